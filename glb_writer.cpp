@@ -0,0 +1,439 @@
+#include "glb_writer.h"
+#include "obj_writer.h"
+#include "obj_json.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+//gltf component types and buffer targets
+static const int GLTF_FLOAT = 5126;
+static const int GLTF_UNSIGNED_SHORT = 5123;
+static const int GLTF_UNSIGNED_INT = 5125;
+static const int GLTF_ARRAY_BUFFER = 34962;
+static const int GLTF_ELEMENT_ARRAY_BUFFER = 34963;
+
+//where each primitive's data lands in the binary chunk
+struct glb_placement
+{
+	int stride;
+	int normal_offset;
+	int uv_offset;
+	int tangent_offset;
+	size_t vertex_offset;
+	size_t vertex_bytes;
+	size_t index_offset;
+	size_t index_bytes;
+};
+
+static size_t padTo4(size_t n)
+{
+	return (n + 3) & ~(size_t)3;
+}
+
+static void appendJSONVec3(string &out, const glm::vec3 &v)
+{
+	out += '[';
+	appendFloat(out, v.x);
+	out += ',';
+	appendFloat(out, v.y);
+	out += ',';
+	appendFloat(out, v.z);
+	out += ']';
+}
+
+static void appendUint32(string &out, uint32_t n)
+{
+	//glb is little-endian, as is every platform this library targets
+	char bytes[4];
+	memcpy(bytes, &n, sizeof(n));
+	out.append(bytes, 4);
+}
+
+static const glb_placement placePrimitive(const glb_primitive &primitive, size_t &bin_size)
+{
+	glb_placement placement;
+	placement.stride = 3;
+	placement.normal_offset = -1;
+	placement.uv_offset = -1;
+	placement.tangent_offset = -1;
+
+	if (primitive.layout.vn_size == 3)
+	{
+		placement.normal_offset = placement.stride;
+		placement.stride += 3;
+	}
+
+	if (primitive.layout.vt_size >= 2)
+	{
+		placement.uv_offset = placement.stride;
+		placement.stride += 2;
+	}
+
+	if (placement.normal_offset >= 0 && placement.uv_offset >= 0 && primitive.layout.tan_size == 3 && primitive.layout.bitan_size == 3)
+	{
+		placement.tangent_offset = placement.stride;
+		placement.stride += 4;
+	}
+
+	placement.vertex_offset = bin_size;
+	placement.vertex_bytes = (size_t)primitive.vertex_total * placement.stride * sizeof(float);
+	placement.index_offset = placement.vertex_offset + placement.vertex_bytes;
+	placement.index_bytes = (size_t)primitive.index_total * primitive.index_size;
+
+	bin_size = padTo4(placement.index_offset + placement.index_bytes);
+	return placement;
+}
+
+//the glb layout is never wider than the source layout, so vertices are repacked front
+//to back inside the buffer they were copied into
+static void repackVertices(float* vertices, const glb_primitive &primitive, const glb_placement &placement)
+{
+	const vertex_layout &layout = primitive.layout;
+	vector<float> source(layout.stride);
+
+	for (int i = 0; i < primitive.vertex_total; i++)
+	{
+		memcpy(&source[0], vertices + (size_t)i * layout.stride, layout.stride * sizeof(float));
+		float* destination = vertices + (size_t)i * placement.stride;
+
+		destination[0] = source[layout.v_offset];
+		destination[1] = source[layout.v_offset + 1];
+		destination[2] = source[layout.v_offset + 2];
+
+		glm::vec3 normal(0.0f, 0.0f, 1.0f);
+		if (placement.normal_offset >= 0)
+		{
+			normal = glm::vec3(source[layout.vn_offset], source[layout.vn_offset + 1], source[layout.vn_offset + 2]);
+			destination[placement.normal_offset] = normal.x;
+			destination[placement.normal_offset + 1] = normal.y;
+			destination[placement.normal_offset + 2] = normal.z;
+		}
+
+		//obj puts the uv origin at the bottom left, gltf at the top left
+		if (placement.uv_offset >= 0)
+		{
+			destination[placement.uv_offset] = source[layout.vt_offset];
+			destination[placement.uv_offset + 1] = 1.0f - source[layout.vt_offset + 1];
+		}
+
+		//gltf wants a unit tangent orthogonal to the normal, w gives the bitangent side
+		if (placement.tangent_offset >= 0)
+		{
+			glm::vec3 tangent(source[layout.tan_offset], source[layout.tan_offset + 1], source[layout.tan_offset + 2]);
+			glm::vec3 bitangent(source[layout.bitan_offset], source[layout.bitan_offset + 1], source[layout.bitan_offset + 2]);
+
+			tangent = tangent - normal * glm::dot(normal, tangent);
+			if (glm::length(tangent) < 1e-12f)
+				tangent = glm::cross(normal, fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+
+			tangent = glm::normalize(tangent);
+
+			destination[placement.tangent_offset] = tangent.x;
+			destination[placement.tangent_offset + 1] = tangent.y;
+			destination[placement.tangent_offset + 2] = tangent.z;
+			destination[placement.tangent_offset + 3] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+		}
+	}
+}
+
+static void appendMaterials(string &json, const vector<string> &material_names, const map<string, material_data> &materials)
+{
+	vector<string> images;
+
+	json += ",\"materials\":[";
+	for (int i = 0; i < (int)material_names.size(); i++)
+	{
+		if (i > 0)
+			json += ',';
+
+		json += "{\"name\":";
+		appendJSONString(json, material_names[i]);
+
+		map<string, material_data>::const_iterator found = materials.find(material_names[i]);
+		if (found == materials.end())
+		{
+			json += '}';
+			continue;
+		}
+
+		const material_data &material = found->second;
+		vector<float> diffuse = material.getData(MTL_KD);
+		//getData returns four zeros for a missing statement, a "d" line holds one value
+		vector<float> dissolve = material.getData(MTL_D);
+		float alpha = dissolve.size() == 1 ? dissolve[0] : 1.0f;
+
+		json += ",\"pbrMetallicRoughness\":{\"baseColorFactor\":[";
+		for (int n = 0; n < 3; n++)
+		{
+			appendFloat(json, n < (int)diffuse.size() ? diffuse[n] : 0.0f);
+			json += ',';
+		}
+		appendFloat(json, alpha);
+		json += "],\"metallicFactor\":0,\"roughnessFactor\":1";
+
+		if (!material.getTextureFilename().empty())
+		{
+			json += ",\"baseColorTexture\":{\"index\":";
+			json += std::to_string(images.size());
+			json += '}';
+			images.push_back(material.getTextureFilename());
+		}
+		json += '}';
+
+		if (!material.getBumpFilename().empty())
+		{
+			json += ",\"normalTexture\":{\"index\":";
+			json += std::to_string(images.size());
+			json += ",\"scale\":";
+			appendFloat(json, material.getBumpValue());
+			json += '}';
+			images.push_back(material.getBumpFilename());
+		}
+
+		if (alpha < 1.0f)
+			json += ",\"alphaMode\":\"BLEND\"";
+
+		json += '}';
+	}
+	json += ']';
+
+	if (images.empty())
+		return;
+
+	json += ",\"textures\":[";
+	for (int i = 0; i < (int)images.size(); i++)
+	{
+		json += i > 0 ? ",{\"source\":" : "{\"source\":";
+		json += std::to_string(i);
+		json += '}';
+	}
+
+	json += "],\"images\":[";
+	for (int i = 0; i < (int)images.size(); i++)
+	{
+		json += i > 0 ? ",{\"uri\":" : "{\"uri\":";
+		appendJSONString(json, images[i]);
+		json += '}';
+	}
+	json += ']';
+}
+
+const glb_primitive glbPrimitive(const mesh_data &mesh)
+{
+	glb_primitive primitive;
+	primitive.name = mesh.getMeshlName();
+	primitive.material = mesh.getMaterialName();
+
+	if (!(mesh.getRepresentations() & MESH_INDEXED) || mesh.getIndexedVertexCount() == 0)
+		return primitive;
+
+	primitive.layout = mesh.getIndexedVertexLayout();
+	primitive.vertex_total = mesh.getIndexedVertexCount();
+	primitive.index_total = mesh.getElementIndexCount();
+	primitive.index_size = sizeof(unsigned short);
+	primitive.bounds_min = mesh.getBoundsMin();
+	primitive.bounds_max = mesh.getBoundsMax();
+
+	const mesh_data* source = &mesh;
+	primitive.copy_vertices = [source](float* destination) { source->copyIndexedVertexData(destination); };
+	primitive.copy_indices = [source](void* destination) { source->copyElementIndex((unsigned short*)destination); };
+
+	return primitive;
+}
+
+bool writeGLB(const char* glb_file, const vector<glb_primitive> &primitives,
+	const map<string, material_data> &materials, string &error)
+{
+	vector<glb_placement> placements;
+	vector<int> written;
+	size_t bin_size = 0;
+	size_t largest_copy = 0;
+
+	for (int i = 0; i < (int)primitives.size(); i++)
+	{
+		const glb_primitive &primitive = primitives[i];
+		if (primitive.vertex_total == 0 || primitive.index_total == 0 || primitive.layout.v_size < 3)
+			continue;
+
+		placements.push_back(placePrimitive(primitive, bin_size));
+		written.push_back(i);
+
+		size_t copy_bytes = std::max((size_t)primitive.vertex_total * primitive.layout.stride * sizeof(float), placements.back().vertex_bytes);
+		largest_copy = std::max(largest_copy, padTo4(copy_bytes + placements.back().index_bytes));
+	}
+
+	//material table in order of first use
+	vector<string> material_names;
+	vector<int> material_index(written.size(), -1);
+	for (int i = 0; i < (int)written.size(); i++)
+	{
+		const string &name = primitives[written[i]].material;
+		if (name.empty())
+			continue;
+
+		vector<string>::iterator found = std::find(material_names.begin(), material_names.end(), name);
+		material_index[i] = found - material_names.begin();
+		if (found == material_names.end())
+			material_names.push_back(name);
+	}
+
+	string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"obj_parser\"}";
+	json += ",\"scene\":0,\"scenes\":[{\"nodes\":[";
+	for (int i = 0; i < (int)written.size(); i++)
+	{
+		json += i > 0 ? "," : "";
+		json += std::to_string(i);
+	}
+	json += "]}]";
+
+	json += ",\"nodes\":[";
+	for (int i = 0; i < (int)written.size(); i++)
+	{
+		json += i > 0 ? ",{\"name\":" : "{\"name\":";
+		appendJSONString(json, primitives[written[i]].name);
+		json += ",\"mesh\":" + std::to_string(i) + "}";
+	}
+	json += ']';
+
+	//each primitive has a vertex view, an index view, one accessor per attribute and one for indices
+	string buffer_views;
+	string accessors;
+	string meshes;
+	int accessor_total = 0;
+
+	for (int i = 0; i < (int)written.size(); i++)
+	{
+		const glb_primitive &primitive = primitives[written[i]];
+		const glb_placement &placement = placements[i];
+		string separator = i > 0 ? "," : "";
+
+		buffer_views += separator + "{\"buffer\":0,\"byteOffset\":" + std::to_string(placement.vertex_offset) +
+			",\"byteLength\":" + std::to_string(placement.vertex_bytes) +
+			",\"byteStride\":" + std::to_string(placement.stride * sizeof(float)) +
+			",\"target\":" + std::to_string(GLTF_ARRAY_BUFFER) + "}";
+		buffer_views += ",{\"buffer\":0,\"byteOffset\":" + std::to_string(placement.index_offset) +
+			",\"byteLength\":" + std::to_string(placement.index_bytes) +
+			",\"target\":" + std::to_string(GLTF_ELEMENT_ARRAY_BUFFER) + "}";
+
+		string vertex_view = std::to_string(i * 2);
+		string count = std::to_string(primitive.vertex_total);
+		string attributes;
+
+		string accessor_separator = accessor_total > 0 ? "," : "";
+		accessors += accessor_separator + "{\"bufferView\":" + vertex_view + ",\"byteOffset\":0,\"componentType\":" +
+			std::to_string(GLTF_FLOAT) + ",\"count\":" + count + ",\"type\":\"VEC3\",\"min\":";
+		appendJSONVec3(accessors, primitive.bounds_min);
+		accessors += ",\"max\":";
+		appendJSONVec3(accessors, primitive.bounds_max);
+		accessors += '}';
+		attributes += "\"POSITION\":" + std::to_string(accessor_total++);
+
+		const char* attribute_names[3] = { "NORMAL", "TEXCOORD_0", "TANGENT" };
+		const char* attribute_types[3] = { "VEC3", "VEC2", "VEC4" };
+		int attribute_offsets[3] = { placement.normal_offset, placement.uv_offset, placement.tangent_offset };
+
+		for (int a = 0; a < 3; a++)
+		{
+			if (attribute_offsets[a] < 0)
+				continue;
+
+			accessors += ",{\"bufferView\":" + vertex_view + ",\"byteOffset\":" + std::to_string(attribute_offsets[a] * sizeof(float)) +
+				",\"componentType\":" + std::to_string(GLTF_FLOAT) + ",\"count\":" + count + ",\"type\":\"" + attribute_types[a] + "\"}";
+			attributes += string(",\"") + attribute_names[a] + "\":" + std::to_string(accessor_total++);
+		}
+
+		accessors += ",{\"bufferView\":" + std::to_string(i * 2 + 1) + ",\"byteOffset\":0,\"componentType\":" +
+			std::to_string(primitive.index_size == 4 ? GLTF_UNSIGNED_INT : GLTF_UNSIGNED_SHORT) +
+			",\"count\":" + std::to_string(primitive.index_total) + ",\"type\":\"SCALAR\"}";
+
+		meshes += separator + "{\"name\":";
+		appendJSONString(meshes, primitive.name);
+		meshes += ",\"primitives\":[{\"attributes\":{" + attributes + "},\"indices\":" + std::to_string(accessor_total++);
+		if (material_index[i] >= 0)
+			meshes += ",\"material\":" + std::to_string(material_index[i]);
+		meshes += ",\"mode\":4}]}";
+	}
+
+	json += ",\"meshes\":[" + meshes + "]";
+	json += ",\"accessors\":[" + accessors + "]";
+	json += ",\"bufferViews\":[" + buffer_views + "]";
+	json += ",\"buffers\":[{\"byteLength\":" + std::to_string(bin_size) + "}]";
+
+	if (!material_names.empty())
+		appendMaterials(json, material_names, materials);
+
+	json += '}';
+	json.append(padTo4(json.size()) - json.size(), ' ');
+
+	size_t total_size = 12 + 8 + json.size() + (bin_size > 0 ? 8 + bin_size : 0);
+	if (total_size > 0xFFFFFFFFull)
+	{
+		error = "glb output exceeds 4 GiB: ";
+		error += glb_file;
+		return false;
+	}
+
+	FILE* file = fopen(glb_file, "wb");
+	if (file == NULL)
+	{
+		error = "unable to open glb file for writing: ";
+		error += glb_file;
+		return false;
+	}
+
+	string header;
+	appendUint32(header, 0x46546C67);
+	appendUint32(header, 2);
+	appendUint32(header, (uint32_t)total_size);
+	appendUint32(header, (uint32_t)json.size());
+	appendUint32(header, 0x4E4F534A);
+	bool write_failed = fwrite(header.data(), 1, header.size(), file) != header.size();
+	write_failed = write_failed || fwrite(json.data(), 1, json.size(), file) != json.size();
+
+	if (bin_size > 0)
+	{
+		string bin_header;
+		appendUint32(bin_header, (uint32_t)bin_size);
+		appendUint32(bin_header, 0x004E4942);
+		write_failed = write_failed || fwrite(bin_header.data(), 1, bin_header.size(), file) != bin_header.size();
+	}
+
+	//one buffer sized for the largest primitive, each primitive goes out in one write
+	vector<float> staging(largest_copy / sizeof(float) + 1);
+	for (int i = 0; i < (int)written.size() && !write_failed; i++)
+	{
+		const glb_primitive &primitive = primitives[written[i]];
+		const glb_placement &placement = placements[i];
+		char* bytes = (char*)&staging[0];
+
+		primitive.copy_vertices(&staging[0]);
+		repackVertices(&staging[0], primitive, placement);
+		primitive.copy_indices(bytes + placement.vertex_bytes);
+
+		size_t block_bytes = padTo4(placement.vertex_bytes + placement.index_bytes);
+		memset(bytes + placement.vertex_bytes + placement.index_bytes, 0, block_bytes - placement.vertex_bytes - placement.index_bytes);
+		write_failed = fwrite(bytes, 1, block_bytes, file) != block_bytes;
+	}
+
+	if (fclose(file) != 0 || write_failed)
+	{
+		error = "error writing glb file: ";
+		error += glb_file;
+		return false;
+	}
+
+	return true;
+}
+
+bool writeGLB(const char* glb_file, const vector<mesh_data> &meshes,
+	const map<string, material_data> &materials, string &error)
+{
+	vector<glb_primitive> primitives;
+	for (const auto &mesh : meshes)
+		primitives.push_back(glbPrimitive(mesh));
+
+	return writeGLB(glb_file, primitives, materials, error);
+}
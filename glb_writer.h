@@ -0,0 +1,46 @@
+#ifndef GLB_WRITER_H
+#define GLB_WRITER_H
+
+#include "obj_parser.h"
+
+#include <functional>
+
+//one indexed triangle list for the glb writer. the writer owns no geometry: it asks the
+//primitive to copy its vertices (in layout, getIndexedVertexData order) and indices
+//straight into its output buffer, then repacks the vertices in place as
+//	position vec3, [normal vec3], [uv vec2, v flipped], [tangent vec4 when uv and normal]
+struct glb_primitive
+{
+	glb_primitive() : vertex_total(0), index_total(0), index_size(2),
+		bounds_min(0.0f, 0.0f, 0.0f), bounds_max(0.0f, 0.0f, 0.0f) {};
+
+	string name;
+	string material;
+	vertex_layout layout;
+	int vertex_total;
+	int index_total;
+	//bytes per index, 2 or 4
+	int index_size;
+	//written as the POSITION accessor's min/max, so must be exact
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+
+	//writes vertex_total * layout.stride floats
+	std::function<void(float*)> copy_vertices;
+	//writes index_total indices of index_size bytes
+	std::function<void(void*)> copy_indices;
+};
+
+//describes an indexed mesh, empty meshes come back with vertex_total 0
+const glb_primitive glbPrimitive(const mesh_data &mesh);
+
+//the json chunk is built first from the primitives' counts and bounds, then each
+//primitive is copied into one reused buffer and written with a single write, so the
+//geometry is never held as a whole. materials become pbr metallic-roughness materials
+//from Kd, d, map_Kd and map_bump, textures are referenced by their file names
+bool writeGLB(const char* glb_file, const vector<glb_primitive> &primitives,
+	const map<string, material_data> &materials, string &error);
+bool writeGLB(const char* glb_file, const vector<mesh_data> &meshes,
+	const map<string, material_data> &materials, string &error);
+
+#endif
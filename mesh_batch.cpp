@@ -0,0 +1,95 @@
+#include "mesh_batch.h"
+#include "obj_parallel.h"
+
+static bool sameLayout(const vertex_layout &a, const vertex_layout &b)
+{
+	return a.stride == b.stride && a.v_size == b.v_size && a.vt_size == b.vt_size &&
+		a.vn_size == b.vn_size && a.tan_size == b.tan_size && a.bitan_size == b.bitan_size;
+}
+
+const vector<material_batch> batchByMaterial(const vector<mesh_data> &meshes)
+{
+	vector<material_batch> batches;
+
+	//batch each mesh lands in and its slot within that batch
+	vector<int> batch_of_mesh(meshes.size(), -1);
+	vector<int> command_of_mesh(meshes.size(), -1);
+	vector< vector<int> > batch_meshes;
+
+	for (int i = 0; i < (int)meshes.size(); i++)
+	{
+		const mesh_data &mesh = meshes[i];
+		if (mesh.getIndexedVertexCount() == 0 || mesh.getElementIndexCount() == 0)
+			continue;
+
+		vertex_layout layout = mesh.getIndexedVertexLayout();
+
+		int batch_index = -1;
+		for (int n = 0; n < (int)batches.size(); n++)
+		{
+			if (batches[n].material_name == mesh.getMaterialName() && sameLayout(batches[n].layout, layout))
+			{
+				batch_index = n;
+				break;
+			}
+		}
+
+		if (batch_index < 0)
+		{
+			batch_index = batches.size();
+			batches.push_back(material_batch());
+			batches.back().material_name = mesh.getMaterialName();
+			batches.back().layout = layout;
+			batch_meshes.push_back(vector<int>());
+		}
+
+		batch_of_mesh[i] = batch_index;
+		command_of_mesh[i] = batch_meshes[batch_index].size();
+		batch_meshes[batch_index].push_back(i);
+	}
+
+	//exclusive prefix sums give every mesh its base vertex and first index
+	for (int n = 0; n < (int)batches.size(); n++)
+	{
+		material_batch &batch = batches[n];
+		int vertex_total = 0;
+		unsigned int index_total = 0;
+
+		for (auto mesh_index : batch_meshes[n])
+		{
+			const mesh_data &mesh = meshes[mesh_index];
+			draw_command command;
+			command.count = mesh.getElementIndexCount();
+			command.first_index = index_total;
+			command.base_vertex = vertex_total;
+			command.base_instance = batch.commands.size();
+
+			batch.commands.push_back(command);
+			batch.mesh_names.push_back(mesh.getMeshlName());
+
+			vertex_total += mesh.getIndexedVertexCount();
+			index_total += command.count;
+		}
+
+		batch.vertices.resize(vertex_total * batch.layout.stride);
+		batch.indices.resize(index_total);
+	}
+
+	//ranges are disjoint, so meshes fill their batches without locking
+	parallelFor(meshes.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (batch_of_mesh[i] < 0)
+				continue;
+
+			material_batch &batch = batches[batch_of_mesh[i]];
+			const draw_command &command = batch.commands[command_of_mesh[i]];
+
+			meshes[i].copyIndexedVertexData(&batch.vertices[command.base_vertex * batch.layout.stride]);
+			meshes[i].copyElementIndex(&batch.indices[command.first_index]);
+		}
+	}, 1);
+
+	return batches;
+}
@@ -0,0 +1,38 @@
+#ifndef MESH_BATCH_H
+#define MESH_BATCH_H
+
+#include "obj_parser.h"
+
+//same field order as DrawElementsIndirectCommand, so a vector of these can be
+//uploaded as-is to a GL_DRAW_INDIRECT_BUFFER (indices are GL_UNSIGNED_SHORT)
+struct draw_command
+{
+	draw_command() : count(0), instance_count(1), first_index(0), base_vertex(0), base_instance(0) {};
+
+	unsigned int count;
+	unsigned int instance_count;
+	unsigned int first_index;
+	int base_vertex;
+	unsigned int base_instance;
+};
+
+//every mesh sharing one material and vertex layout, merged into one vertex buffer
+//and one index buffer. indices stay local to their mesh and are offset by the
+//command's base_vertex, so a batch may hold more than 65535 vertices in total
+struct material_batch
+{
+	string material_name;
+	vertex_layout layout;
+	vector<float> vertices;
+	vector<unsigned short> indices;
+	//one command per source mesh, in the same order as mesh_names
+	vector<draw_command> commands;
+	vector<string> mesh_names;
+};
+
+//batches are returned in the order their material first appears, meshes without
+//indexed vertices are skipped. offsets come from a prefix sum over the mesh sizes,
+//then each mesh copies into its own range of the batch buffers in parallel
+const vector<material_batch> batchByMaterial(const vector<mesh_data> &meshes);
+
+#endif
@@ -0,0 +1,206 @@
+#include "mesh_bounds.h"
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBJ_BOUNDS_SSE2
+#include <emmintrin.h>
+#endif
+
+void point_set::reserve(int n)
+{
+	//room for the padding as well
+	x.reserve(n + 3);
+	y.reserve(n + 3);
+	z.reserve(n + 3);
+}
+
+void point_set::addPoint(const glm::vec3 &p)
+{
+	//drops any padding from an earlier pad() call before appending
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+
+	x.push_back(p.x);
+	y.push_back(p.y);
+	z.push_back(p.z);
+	count++;
+}
+
+void point_set::pad()
+{
+	if (count == 0)
+		return;
+
+	while (x.size() % 4 != 0)
+	{
+		x.push_back(x[count - 1]);
+		y.push_back(y[count - 1]);
+		z.push_back(z[count - 1]);
+	}
+}
+
+bool computeBounds(const point_set &points, glm::vec3 &bounds_min, glm::vec3 &bounds_max)
+{
+	int padded_count = points.getPaddedCount();
+	if (points.getCount() == 0)
+		return false;
+
+	const float* xs = &points.x[0];
+	const float* ys = &points.y[0];
+	const float* zs = &points.z[0];
+
+#ifdef OBJ_BOUNDS_SSE2
+	__m128 min_x = _mm_loadu_ps(xs);
+	__m128 min_y = _mm_loadu_ps(ys);
+	__m128 min_z = _mm_loadu_ps(zs);
+	__m128 max_x = min_x;
+	__m128 max_y = min_y;
+	__m128 max_z = min_z;
+
+	for (int i = 4; i < padded_count; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(xs + i);
+		__m128 py = _mm_loadu_ps(ys + i);
+		__m128 pz = _mm_loadu_ps(zs + i);
+		min_x = _mm_min_ps(min_x, px);
+		min_y = _mm_min_ps(min_y, py);
+		min_z = _mm_min_ps(min_z, pz);
+		max_x = _mm_max_ps(max_x, px);
+		max_y = _mm_max_ps(max_y, py);
+		max_z = _mm_max_ps(max_z, pz);
+	}
+
+	float lanes[6][4];
+	_mm_storeu_ps(lanes[0], min_x);
+	_mm_storeu_ps(lanes[1], min_y);
+	_mm_storeu_ps(lanes[2], min_z);
+	_mm_storeu_ps(lanes[3], max_x);
+	_mm_storeu_ps(lanes[4], max_y);
+	_mm_storeu_ps(lanes[5], max_z);
+
+	bounds_min = glm::vec3(lanes[0][0], lanes[1][0], lanes[2][0]);
+	bounds_max = glm::vec3(lanes[3][0], lanes[4][0], lanes[5][0]);
+	for (int lane = 1; lane < 4; lane++)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, lanes[0][lane]), fminf(bounds_min.y, lanes[1][lane]), fminf(bounds_min.z, lanes[2][lane]));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, lanes[3][lane]), fmaxf(bounds_max.y, lanes[4][lane]), fmaxf(bounds_max.z, lanes[5][lane]));
+	}
+#else
+	bounds_min = glm::vec3(xs[0], ys[0], zs[0]);
+	bounds_max = bounds_min;
+	for (int i = 1; i < padded_count; i++)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, xs[i]), fminf(bounds_min.y, ys[i]), fminf(bounds_min.z, zs[i]));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, xs[i]), fmaxf(bounds_max.y, ys[i]), fmaxf(bounds_max.z, zs[i]));
+	}
+#endif
+
+	return true;
+}
+
+const float farthestPointSquared(const point_set &points, const glm::vec3 &center, int &farthest_index)
+{
+	int padded_count = points.getPaddedCount();
+	farthest_index = 0;
+	if (points.getCount() == 0)
+		return 0.0f;
+
+	const float* xs = &points.x[0];
+	const float* ys = &points.y[0];
+	const float* zs = &points.z[0];
+
+	float farthest = -1.0f;
+
+#ifdef OBJ_BOUNDS_SSE2
+	__m128 center_x = _mm_set1_ps(center.x);
+	__m128 center_y = _mm_set1_ps(center.y);
+	__m128 center_z = _mm_set1_ps(center.z);
+
+	//per-lane maximum and the index it came from, selected with compare masks
+	__m128 lane_max = _mm_set1_ps(-1.0f);
+	__m128i lane_index = _mm_setzero_si128();
+	__m128i current_index = _mm_set_epi32(3, 2, 1, 0);
+	__m128i index_step = _mm_set1_epi32(4);
+
+	for (int i = 0; i < padded_count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), center_x);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), center_y);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(zs + i), center_z);
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		__m128 greater = _mm_cmpgt_ps(distance, lane_max);
+		__m128i greater_index = _mm_castps_si128(greater);
+		lane_max = _mm_or_ps(_mm_and_ps(greater, distance), _mm_andnot_ps(greater, lane_max));
+		lane_index = _mm_or_si128(_mm_and_si128(greater_index, current_index), _mm_andnot_si128(greater_index, lane_index));
+		current_index = _mm_add_epi32(current_index, index_step);
+	}
+
+	float lane_distances[4];
+	int lane_indices[4];
+	_mm_storeu_ps(lane_distances, lane_max);
+	_mm_storeu_si128((__m128i*)lane_indices, lane_index);
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (lane_distances[lane] > farthest || (lane_distances[lane] == farthest && lane_indices[lane] < farthest_index))
+		{
+			farthest = lane_distances[lane];
+			farthest_index = lane_indices[lane];
+		}
+	}
+#else
+	for (int i = 0; i < padded_count; i++)
+	{
+		float dx = xs[i] - center.x;
+		float dy = ys[i] - center.y;
+		float dz = zs[i] - center.z;
+		float distance = dx * dx + dy * dy + dz * dz;
+
+		if (distance > farthest)
+		{
+			farthest = distance;
+			farthest_index = i;
+		}
+	}
+#endif
+
+	//padding repeats the last point, report its real index
+	if (farthest_index >= points.getCount())
+		farthest_index = points.getCount() - 1;
+
+	return farthest;
+}
+
+const bounding_sphere computeBoundingSphere(const point_set &points, const glm::vec3 &bounds_min, const glm::vec3 &bounds_max)
+{
+	bounding_sphere sphere;
+	if (points.getCount() == 0)
+		return sphere;
+
+	glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+	int farthest_index;
+	float best_radius_squared = farthestPointSquared(points, center, farthest_index);
+	glm::vec3 best_center = center;
+
+	//each step moves the center a shrinking fraction of the way to the farthest point
+	const int refinement_steps = 16;
+	for (int i = 0; i < refinement_steps; i++)
+	{
+		glm::vec3 farthest(points.x[farthest_index], points.y[farthest_index], points.z[farthest_index]);
+		center = center + (farthest - center) * (1.0f / float(i + 2));
+
+		float radius_squared = farthestPointSquared(points, center, farthest_index);
+		if (radius_squared < best_radius_squared)
+		{
+			best_radius_squared = radius_squared;
+			best_center = center;
+		}
+	}
+
+	sphere.center = best_center;
+	sphere.radius = sqrt(best_radius_squared);
+	return sphere;
+}
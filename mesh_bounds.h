@@ -0,0 +1,49 @@
+#ifndef MESH_BOUNDS_H
+#define MESH_BOUNDS_H
+
+#include <vector>
+#include <glm.hpp>
+
+using std::vector;
+
+struct bounding_sphere
+{
+	bounding_sphere() : center(0.0f, 0.0f, 0.0f), radius(0.0f) {};
+
+	glm::vec3 center;
+	float radius;
+};
+
+//positions split into one array per axis for the simd kernels. the arrays are padded
+//to a multiple of 4 by repeating the last point, which never changes a min, max or
+//farthest point, so the kernels run without a scalar tail
+class point_set
+{
+public:
+	point_set() : count(0) {};
+	~point_set(){};
+
+	void reserve(int n);
+	void addPoint(const glm::vec3 &p);
+	void pad();
+
+	const int getCount() const { return count; }
+	const int getPaddedCount() const { return x.size(); }
+
+	vector<float> x;
+	vector<float> y;
+	vector<float> z;
+
+private:
+	int count;
+};
+
+//axis-aligned bounds of a padded point set, returns false if it is empty
+bool computeBounds(const point_set &points, glm::vec3 &bounds_min, glm::vec3 &bounds_max);
+//squared distance from center to the farthest point, and that point's index
+const float farthestPointSquared(const point_set &points, const glm::vec3 &center, int &farthest_index);
+//starts at the box center and walks toward the farthest point (badoiu-clarkson),
+//keeping the smallest enclosing radius found
+const bounding_sphere computeBoundingSphere(const point_set &points, const glm::vec3 &bounds_min, const glm::vec3 &bounds_max);
+
+#endif
@@ -0,0 +1,642 @@
+#include "mesh_hull.h"
+#include "obj_parallel.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <algorithm>
+
+//plane tests run in double, relative to the center of the input, so thin faces on
+//large coordinates still get usable normals
+struct hull_point
+{
+	hull_point() : x(0.0), y(0.0), z(0.0) {};
+	hull_point(double px, double py, double pz) : x(px), y(py), z(pz) {};
+
+	hull_point operator - (const hull_point &other) const { return hull_point(x - other.x, y - other.y, z - other.z); }
+	hull_point operator * (double scale) const { return hull_point(x * scale, y * scale, z * scale); }
+	double dot(const hull_point &other) const { return x * other.x + y * other.y + z * other.z; }
+	hull_point cross(const hull_point &other) const { return hull_point(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x); }
+	double length() const { return sqrt(dot(*this)); }
+	double operator [] (int axis) const { return axis == 0 ? x : (axis == 1 ? y : z); }
+
+	double x, y, z;
+};
+
+struct hull_face
+{
+	int v[3];
+	hull_point normal;
+	double offset;
+	vector<int> outside;
+	int farthest;
+	double farthest_distance;
+	bool alive;
+	//iteration the face was last tested against an eye point, and the outcome
+	int tested;
+	bool visible;
+};
+
+class quickhull
+{
+public:
+	quickhull(const vector<glm::vec3> &p) : source(p), epsilon(0.0) {};
+
+	const convex_hull build(int max_vertices);
+
+private:
+	bool buildTetrahedron(int* tetrahedron);
+	int addFace(int a, int b, int c, const hull_point &fallback_normal);
+	void removeFace(int f);
+	void assignPoint(int point, const vector<int> &candidate_faces);
+	double distance(int f, int point) const { return faces[f].normal.dot(points[point]) - faces[f].offset; }
+
+	static uint64_t edgeKey(int a, int b) { return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b; }
+
+	const vector<glm::vec3> &source;
+	vector<hull_point> points;
+	double epsilon;
+	vector<hull_face> faces;
+	//directed edge to the face it belongs to, the face across a->b owns b->a
+	std::unordered_map<uint64_t, int> edge_faces;
+	vector<int> pending;
+};
+
+int quickhull::addFace(int a, int b, int c, const hull_point &fallback_normal)
+{
+	hull_face face;
+	face.v[0] = a;
+	face.v[1] = b;
+	face.v[2] = c;
+
+	hull_point normal = (points[b] - points[a]).cross(points[c] - points[a]);
+	double length = normal.length();
+	face.normal = length > 0.0 ? normal * (1.0 / length) : fallback_normal;
+	face.offset = face.normal.dot(points[a]);
+	face.farthest = -1;
+	face.farthest_distance = 0.0;
+	face.alive = true;
+	face.tested = -1;
+	face.visible = false;
+
+	int f = faces.size();
+	faces.push_back(face);
+	edge_faces[edgeKey(a, b)] = f;
+	edge_faces[edgeKey(b, c)] = f;
+	edge_faces[edgeKey(c, a)] = f;
+	return f;
+}
+
+void quickhull::removeFace(int f)
+{
+	hull_face &face = faces[f];
+	face.alive = false;
+	for (int e = 0; e < 3; e++)
+	{
+		std::unordered_map<uint64_t, int>::iterator found = edge_faces.find(edgeKey(face.v[e], face.v[(e + 1) % 3]));
+		if (found != edge_faces.end() && found->second == f)
+			edge_faces.erase(found);
+	}
+	vector<int>().swap(face.outside);
+}
+
+void quickhull::assignPoint(int point, const vector<int> &candidate_faces)
+{
+	for (auto f : candidate_faces)
+	{
+		double d = distance(f, point);
+		if (d > epsilon)
+		{
+			hull_face &face = faces[f];
+			if (face.outside.empty())
+				pending.push_back(f);
+
+			face.outside.push_back(point);
+			if (d > face.farthest_distance)
+			{
+				face.farthest_distance = d;
+				face.farthest = point;
+			}
+			return;
+		}
+	}
+}
+
+bool quickhull::buildTetrahedron(int* tetrahedron)
+{
+	int point_total = source.size();
+
+	glm::vec3 bounds_min = source[0];
+	glm::vec3 bounds_max = source[0];
+	for (const auto &p : source)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, p.x), fminf(bounds_min.y, p.y), fminf(bounds_min.z, p.z));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, p.x), fmaxf(bounds_max.y, p.y), fmaxf(bounds_max.z, p.z));
+	}
+
+	glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+	points.resize(point_total);
+	for (int i = 0; i < point_total; i++)
+		points[i] = hull_point(double(source[i].x) - center.x, double(source[i].y) - center.y, double(source[i].z) - center.z);
+
+	//the input is only float precise, so the tolerance follows float rounding at the
+	//magnitude of the original coordinates
+	glm::vec3 largest(fmaxf(fabsf(bounds_min.x), fabsf(bounds_max.x)), fmaxf(fabsf(bounds_min.y), fabsf(bounds_max.y)),
+		fmaxf(fabsf(bounds_min.z), fabsf(bounds_max.z)));
+	epsilon = 3.0 * FLT_EPSILON * (double(largest.x) + largest.y + largest.z);
+
+	//extremes along each axis, the farthest apart pair starts the hull
+	int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < point_total; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (points[i][axis] < points[extremes[axis * 2]][axis])
+				extremes[axis * 2] = i;
+
+			if (points[i][axis] > points[extremes[axis * 2 + 1]][axis])
+				extremes[axis * 2 + 1] = i;
+		}
+	}
+
+	double widest = -1.0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		double extent = (points[extremes[axis * 2 + 1]] - points[extremes[axis * 2]]).length();
+		if (extent > widest)
+		{
+			widest = extent;
+			tetrahedron[0] = extremes[axis * 2];
+			tetrahedron[1] = extremes[axis * 2 + 1];
+		}
+	}
+
+	if (widest <= epsilon)
+		return false;
+
+	hull_point a = points[tetrahedron[0]];
+	hull_point direction = (points[tetrahedron[1]] - a) * (1.0 / widest);
+	double farthest = -1.0;
+	for (int i = 0; i < point_total; i++)
+	{
+		double d = (points[i] - a).cross(direction).length();
+		if (d > farthest)
+		{
+			farthest = d;
+			tetrahedron[2] = i;
+		}
+	}
+
+	if (farthest <= epsilon)
+		return false;
+
+	hull_point normal = (points[tetrahedron[1]] - a).cross(points[tetrahedron[2]] - a);
+	normal = normal * (1.0 / normal.length());
+	farthest = -1.0;
+	for (int i = 0; i < point_total; i++)
+	{
+		double d = fabs((points[i] - a).dot(normal));
+		if (d > farthest)
+		{
+			farthest = d;
+			tetrahedron[3] = i;
+		}
+	}
+
+	return farthest > epsilon;
+}
+
+const convex_hull quickhull::build(int max_vertices)
+{
+	convex_hull hull;
+	int point_total = source.size();
+	int tetrahedron[4];
+	if (point_total < 4 || !buildTetrahedron(tetrahedron))
+		return hull;
+
+	//each face is wound so the remaining corner of the tetrahedron is behind it
+	const int corners[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+	for (int f = 0; f < 4; f++)
+	{
+		int a = tetrahedron[corners[f][0]];
+		int b = tetrahedron[corners[f][1]];
+		int c = tetrahedron[corners[f][2]];
+		int opposite = tetrahedron[corners[f][3]];
+		if ((points[b] - points[a]).cross(points[c] - points[a]).dot(points[opposite] - points[a]) > 0.0)
+			std::swap(b, c);
+
+		addFace(a, b, c, hull_point());
+	}
+
+	//the first sort of points onto faces touches every point, so it runs over threads
+	vector<int> first_face(point_total, -1);
+	parallelFor(point_total, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			for (int f = 0; f < 4; f++)
+			{
+				if (distance(f, i) > epsilon)
+				{
+					first_face[i] = f;
+					break;
+				}
+			}
+		}
+	}, 4096);
+
+	for (int i = 0; i < point_total; i++)
+	{
+		if (first_face[i] >= 0)
+			assignPoint(i, vector<int>(1, first_face[i]));
+	}
+
+	int vertex_total = 4;
+	int iteration = 0;
+	vector<int> visible_faces;
+	vector<int> search;
+	vector< std::pair<int, int> > horizon;
+	vector<hull_point> horizon_normals;
+	vector<int> orphans;
+	vector<int> new_faces;
+
+	while (!pending.empty())
+	{
+		if (max_vertices > 0 && vertex_total >= max_vertices)
+			break;
+
+		int start = pending.back();
+		pending.pop_back();
+		if (!faces[start].alive || faces[start].outside.empty())
+			continue;
+
+		int eye = faces[start].farthest;
+		iteration++;
+
+		//faces the eye can see form a connected patch around the start face, the edges
+		//between it and the faces the eye cannot see are the horizon
+		visible_faces.clear();
+		horizon.clear();
+		horizon_normals.clear();
+		search.assign(1, start);
+		faces[start].tested = iteration;
+		faces[start].visible = true;
+
+		while (!search.empty())
+		{
+			int f = search.back();
+			search.pop_back();
+			visible_faces.push_back(f);
+
+			for (int e = 0; e < 3; e++)
+			{
+				int a = faces[f].v[e];
+				int b = faces[f].v[(e + 1) % 3];
+				std::unordered_map<uint64_t, int>::iterator across = edge_faces.find(edgeKey(b, a));
+				if (across == edge_faces.end())
+					continue;
+
+				hull_face &neighbor = faces[across->second];
+				if (neighbor.tested != iteration)
+				{
+					neighbor.tested = iteration;
+					neighbor.visible = distance(across->second, eye) > epsilon;
+					if (neighbor.visible)
+					{
+						search.push_back(across->second);
+						continue;
+					}
+				}
+
+				if (!neighbor.visible)
+				{
+					horizon.push_back(std::make_pair(a, b));
+					horizon_normals.push_back(faces[f].normal);
+				}
+			}
+		}
+
+		orphans.clear();
+		for (auto f : visible_faces)
+		{
+			for (auto point : faces[f].outside)
+			{
+				if (point != eye)
+					orphans.push_back(point);
+			}
+			removeFace(f);
+		}
+
+		new_faces.clear();
+		for (int h = 0; h < (int)horizon.size(); h++)
+			new_faces.push_back(addFace(horizon[h].first, horizon[h].second, eye, horizon_normals[h]));
+
+		//points outside none of the new faces are inside the hull for good
+		for (auto point : orphans)
+			assignPoint(point, new_faces);
+
+		vertex_total++;
+	}
+
+	//compact the vertices the surviving faces use
+	vector<int> remap(point_total, -1);
+	for (const auto &face : faces)
+	{
+		if (!face.alive)
+			continue;
+
+		for (int c = 0; c < 3; c++)
+		{
+			if (remap[face.v[c]] < 0)
+			{
+				remap[face.v[c]] = hull.vertices.size();
+				hull.vertices.push_back(source[face.v[c]]);
+			}
+			hull.indices.push_back(remap[face.v[c]]);
+		}
+	}
+
+	glm::vec3 origin = hull.vertices[0];
+	for (int i = 0; i + 2 < (int)hull.indices.size(); i += 3)
+	{
+		glm::vec3 a = hull.vertices[hull.indices[i]] - origin;
+		glm::vec3 b = hull.vertices[hull.indices[i + 1]] - origin;
+		glm::vec3 c = hull.vertices[hull.indices[i + 2]] - origin;
+		hull.volume += glm::dot(a, glm::cross(b, c)) / 6.0f;
+	}
+
+	return hull;
+}
+
+const convex_hull computeConvexHull(const vector<glm::vec3> &points, int max_vertices)
+{
+	quickhull builder(points);
+	return builder.build(max_vertices);
+}
+
+const vector<glm::vec3> getTrianglePositions(const mesh_data &mesh)
+{
+	vector<glm::vec3> triangles;
+
+	if ((mesh.getRepresentations() & MESH_INDEXED) && mesh.getIndexedVertexCount() > 0)
+	{
+		vector<float> vertices = mesh.getIndexedVertexData();
+		vertex_layout layout = mesh.getIndexedVertexLayout();
+		vector<unsigned short> indices = mesh.getElementIndex();
+		if (layout.v_size < 3)
+			return triangles;
+
+		triangles.reserve(indices.size());
+		for (auto index : indices)
+		{
+			const float* p = &vertices[(size_t)index * layout.stride + layout.v_offset];
+			triangles.push_back(glm::vec3(p[0], p[1], p[2]));
+		}
+	}
+
+	else if (mesh.getVSize() >= 3)
+	{
+		vector<float> positions = mesh.getVData();
+		int v_size = mesh.getVSize();
+		for (int i = 0; i + v_size <= (int)positions.size(); i += v_size)
+			triangles.push_back(glm::vec3(positions[i], positions[i + 1], positions[i + 2]));
+	}
+
+	triangles.resize(triangles.size() / 3 * 3);
+	return triangles;
+}
+
+const convex_hull computeConvexHull(const mesh_data &mesh, int max_vertices)
+{
+	return computeConvexHull(getTrianglePositions(mesh), max_vertices);
+}
+
+//a piece of the surface being decomposed, with its hull and how deep the surface
+//reaches inside that hull
+struct hull_part
+{
+	hull_part() : concavity(0.0f), deepest(0.0f, 0.0f, 0.0f) {};
+
+	vector<glm::vec3> triangles;
+	convex_hull hull;
+	float concavity;
+	glm::vec3 deepest;
+};
+
+static void measurePart(hull_part &part)
+{
+	part.hull = computeConvexHull(part.triangles);
+	part.concavity = 0.0f;
+	part.deepest = part.triangles.empty() ? glm::vec3(0.0f, 0.0f, 0.0f) : part.triangles[0];
+
+	const convex_hull &hull = part.hull;
+	int face_total = hull.indices.size() / 3;
+	if (face_total == 0)
+		return;
+
+	vector<glm::vec3> normals(face_total);
+	vector<float> offsets(face_total);
+	for (int f = 0; f < face_total; f++)
+	{
+		glm::vec3 a = hull.vertices[hull.indices[f * 3]];
+		glm::vec3 normal = glm::cross(hull.vertices[hull.indices[f * 3 + 1]] - a, hull.vertices[hull.indices[f * 3 + 2]] - a);
+		float length = glm::length(normal);
+		normals[f] = length > 0.0f ? normal * (1.0f / length) : normal;
+		offsets[f] = glm::dot(normals[f], a);
+	}
+
+	//depth of corners and triangle centers measured along the surface normal, up to where
+	//that ray leaves the hull. unlike the distance to the nearest hull plane, slicing a
+	//concave part thinner does not make it look convex. triangles are taken to wind
+	//counter-clockwise seen from outside, as obj faces do
+	for (int i = 0; i + 2 < (int)part.triangles.size(); i += 3)
+	{
+		glm::vec3 normal = glm::cross(part.triangles[i + 1] - part.triangles[i], part.triangles[i + 2] - part.triangles[i]);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+			continue;
+
+		normal = normal * (1.0f / length);
+		glm::vec3 samples[4] = { part.triangles[i], part.triangles[i + 1], part.triangles[i + 2],
+			(part.triangles[i] + part.triangles[i + 1] + part.triangles[i + 2]) * (1.0f / 3.0f) };
+
+		for (auto &p : samples)
+		{
+			float depth = FLT_MAX;
+			for (int f = 0; f < face_total && depth > part.concavity; f++)
+			{
+				float facing = glm::dot(normals[f], normal);
+				if (facing > 0.0f)
+					depth = fminf(depth, fmaxf(0.0f, offsets[f] - glm::dot(normals[f], p)) / facing);
+			}
+
+			if (depth != FLT_MAX && depth > part.concavity)
+			{
+				part.concavity = depth;
+				part.deepest = p;
+			}
+		}
+	}
+}
+
+//clips a polygon to one side of the plane p[axis] = value, side is 1 or -1
+static void clipPolygon(const vector<glm::vec3> &polygon, int axis, float value, float side, vector<glm::vec3> &clipped)
+{
+	clipped.clear();
+	for (int i = 0; i < (int)polygon.size(); i++)
+	{
+		const glm::vec3 &a = polygon[i];
+		const glm::vec3 &b = polygon[(i + 1) % polygon.size()];
+		float da = (a[axis] - value) * side;
+		float db = (b[axis] - value) * side;
+
+		if (da >= 0.0f)
+			clipped.push_back(a);
+
+		if ((da >= 0.0f) != (db >= 0.0f))
+			clipped.push_back(a + (b - a) * (da / (da - db)));
+	}
+}
+
+static void splitPart(const hull_part &part, int axis, float value, hull_part &below, hull_part &above)
+{
+	vector<glm::vec3> triangle(3);
+	vector<glm::vec3> clipped;
+
+	for (int i = 0; i + 2 < (int)part.triangles.size(); i += 3)
+	{
+		float lowest = fminf(part.triangles[i][axis], fminf(part.triangles[i + 1][axis], part.triangles[i + 2][axis]));
+		float highest = fmaxf(part.triangles[i][axis], fmaxf(part.triangles[i + 1][axis], part.triangles[i + 2][axis]));
+
+		if (highest <= value || lowest >= value)
+		{
+			//a triangle lying in the plane bounds the side its normal points away from
+			bool on_plane = highest <= value && lowest >= value;
+			float facing = glm::cross(part.triangles[i + 1] - part.triangles[i], part.triangles[i + 2] - part.triangles[i])[axis];
+			hull_part &side = (on_plane ? facing >= 0.0f : highest <= value) ? below : above;
+			side.triangles.insert(side.triangles.end(), part.triangles.begin() + i, part.triangles.begin() + i + 3);
+			continue;
+		}
+
+		triangle[0] = part.triangles[i];
+		triangle[1] = part.triangles[i + 1];
+		triangle[2] = part.triangles[i + 2];
+
+		for (int s = 0; s < 2; s++)
+		{
+			hull_part &side = s == 0 ? below : above;
+			clipPolygon(triangle, axis, value, s == 0 ? -1.0f : 1.0f, clipped);
+			for (int c = 1; c + 1 < (int)clipped.size(); c++)
+			{
+				side.triangles.push_back(clipped[0]);
+				side.triangles.push_back(clipped[c]);
+				side.triangles.push_back(clipped[c + 1]);
+			}
+		}
+	}
+}
+
+const vector<convex_hull> decomposeConvex(const vector<glm::vec3> &triangles, const decomposition_options &options)
+{
+	vector<convex_hull> hulls;
+	if (triangles.size() < 3)
+		return hulls;
+
+	glm::vec3 bounds_min = triangles[0];
+	glm::vec3 bounds_max = triangles[0];
+	for (const auto &p : triangles)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, p.x), fminf(bounds_min.y, p.y), fminf(bounds_min.z, p.z));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, p.x), fmaxf(bounds_max.y, p.y), fmaxf(bounds_max.z, p.z));
+	}
+	float concavity_limit = options.max_concavity * glm::length(bounds_max - bounds_min);
+
+	vector<hull_part> parts(1);
+	parts[0].triangles = triangles;
+	measurePart(parts[0]);
+
+	//parts that no cut improves are left alone
+	vector<bool> final_part(1, false);
+
+	while ((int)parts.size() < options.max_hulls)
+	{
+		int worst = -1;
+		for (int i = 0; i < (int)parts.size(); i++)
+		{
+			if (!final_part[i] && parts[i].concavity > concavity_limit && (worst < 0 || parts[i].concavity > parts[worst].concavity))
+				worst = i;
+		}
+
+		if (worst < 0)
+			break;
+
+		//planes along each axis through the deepest point and through the center of the part
+		const hull_part &part = parts[worst];
+		glm::vec3 part_min = part.triangles[0];
+		glm::vec3 part_max = part.triangles[0];
+		for (const auto &p : part.triangles)
+		{
+			part_min = glm::vec3(fminf(part_min.x, p.x), fminf(part_min.y, p.y), fminf(part_min.z, p.z));
+			part_max = glm::vec3(fmaxf(part_max.x, p.x), fmaxf(part_max.y, p.y), fmaxf(part_max.z, p.z));
+		}
+
+		const int candidate_total = 6;
+		vector<hull_part> halves(candidate_total * 2);
+		parallelFor(candidate_total, [&](int begin, int end) {
+			for (int c = begin; c < end; c++)
+			{
+				int axis = c % 3;
+				float value = c < 3 ? part.deepest[axis] : (part_min[axis] + part_max[axis]) * 0.5f;
+				if (value <= part_min[axis] || value >= part_max[axis])
+					continue;
+
+				splitPart(part, axis, value, halves[c * 2], halves[c * 2 + 1]);
+				measurePart(halves[c * 2]);
+				measurePart(halves[c * 2 + 1]);
+			}
+		}, 1);
+
+		int best = -1;
+		float best_cost = part.concavity;
+		for (int c = 0; c < candidate_total; c++)
+		{
+			if (halves[c * 2].hull.indices.empty() || halves[c * 2 + 1].hull.indices.empty())
+				continue;
+
+			float cost = fmaxf(halves[c * 2].concavity, halves[c * 2 + 1].concavity);
+			if (cost < best_cost)
+			{
+				best = c;
+				best_cost = cost;
+			}
+		}
+
+		if (best < 0)
+		{
+			final_part[worst] = true;
+			continue;
+		}
+
+		parts[worst] = std::move(halves[best * 2]);
+		parts.push_back(std::move(halves[best * 2 + 1]));
+		final_part.push_back(false);
+	}
+
+	hulls.resize(parts.size());
+	parallelFor(parts.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			if (options.max_vertices_per_hull > 0 && (int)parts[i].hull.vertices.size() > options.max_vertices_per_hull)
+				hulls[i] = computeConvexHull(parts[i].hull.vertices, options.max_vertices_per_hull);
+
+			else hulls[i] = parts[i].hull;
+		}
+	}, 1);
+
+	//flat parts have no volume to collide with
+	hulls.erase(std::remove_if(hulls.begin(), hulls.end(), [](const convex_hull &hull) { return hull.indices.empty(); }), hulls.end());
+	return hulls;
+}
+
+const vector<convex_hull> decomposeConvex(const mesh_data &mesh, const decomposition_options &options)
+{
+	return decomposeConvex(getTrianglePositions(mesh), options);
+}
@@ -0,0 +1,49 @@
+#ifndef MESH_HULL_H
+#define MESH_HULL_H
+
+#include "obj_parser.h"
+
+//closed convex polyhedron, triangles wind counter-clockwise seen from outside.
+//flat or degenerate input gives a hull without triangles
+struct convex_hull
+{
+	convex_hull() : volume(0.0f) {};
+
+	vector<glm::vec3> vertices;
+	vector<int> indices;
+	float volume;
+};
+
+struct decomposition_options
+{
+	decomposition_options() : max_hulls(16), max_concavity(0.02f), max_vertices_per_hull(32) {};
+
+	//upper bound on the number of hulls returned
+	int max_hulls;
+	//parts stop splitting once their concavity is below this fraction of the mesh's
+	//bounding box diagonal
+	float max_concavity;
+	//each returned hull is rebuilt from at most this many of its points, 0 keeps all
+	int max_vertices_per_hull;
+};
+
+//quickhull. points are sorted onto the faces of the starting tetrahedron over
+//threads, planes are tested against a tolerance scaled to the coordinates. with a
+//vertex limit the hull stops growing once it has max_vertices, quickhull always adds
+//the farthest remaining point so the result is the best hull of that size it finds
+const convex_hull computeConvexHull(const vector<glm::vec3> &points, int max_vertices = 0);
+const convex_hull computeConvexHull(const mesh_data &mesh, int max_vertices = 0);
+
+//approximate convex decomposition. concavity is how far a surface point can travel
+//along its normal before leaving the hull. the most concave part is cut by an
+//axis-aligned plane, through its deepest point or its center, whichever leaves the
+//shallower halves. triangles crossing the plane are clipped
+//so both halves keep the surface up to the cut. candidate cuts are evaluated in
+//parallel and cutting stops at max_hulls or when every part is within max_concavity
+const vector<convex_hull> decomposeConvex(const vector<glm::vec3> &triangles, const decomposition_options &options);
+const vector<convex_hull> decomposeConvex(const mesh_data &mesh, const decomposition_options &options = decomposition_options());
+
+//positions of every triangle corner of the mesh, three per triangle
+const vector<glm::vec3> getTrianglePositions(const mesh_data &mesh);
+
+#endif
@@ -0,0 +1,281 @@
+#include "mesh_instancing.h"
+#include "obj_parallel.h"
+
+#include <stdint.h>
+#include <unordered_map>
+
+struct instance_frame
+{
+	bool valid;
+	glm::vec3 origin;
+	glm::vec3 axes[3];
+};
+
+static uint64_t hashCombine(uint64_t h, uint64_t value)
+{
+	h ^= value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	return h;
+}
+
+static glm::vec3 positionAt(const vector<float> &vertices, const vertex_layout &layout, int index)
+{
+	const float* vertex = &vertices[index * layout.stride + layout.v_offset];
+	return glm::vec3(vertex[0], vertex[1], vertex[2]);
+}
+
+//nothing that changes under rotation or translation goes into the fingerprint. only exact
+//values are hashed, uvs are left to the tolerance check in matchInstance
+static uint64_t fingerprintMesh(const mesh_data &mesh, const vector<float> &vertices, const vertex_layout &layout)
+{
+	const vector<unsigned short> element_index = mesh.getElementIndex();
+	int vertex_total = layout.stride > 0 ? vertices.size() / layout.stride : 0;
+
+	uint64_t h = std::hash<string>()(mesh.getMaterialName());
+	h = hashCombine(h, vertex_total);
+	h = hashCombine(h, element_index.size());
+	h = hashCombine(h, layout.stride);
+	h = hashCombine(h, layout.vt_size);
+	h = hashCombine(h, layout.vn_size);
+
+	for (auto index : element_index)
+		h = hashCombine(h, index);
+
+	return h;
+}
+
+//positions only contribute their rms spread around the centroid, rounded coarsely. true
+//instances can still straddle a rounding boundary, so lookups probe the neighbouring cells
+static int64_t radiusCell(const vector<float> &vertices, const vertex_layout &layout, float tolerance)
+{
+	int vertex_total = layout.stride > 0 ? vertices.size() / layout.stride : 0;
+
+	glm::vec3 centroid(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < vertex_total; i++)
+		centroid = centroid + positionAt(vertices, layout, i);
+
+	if (vertex_total > 0)
+		centroid = centroid / float(vertex_total);
+
+	float spread = 0.0f;
+	for (int i = 0; i < vertex_total; i++)
+	{
+		glm::vec3 offset = positionAt(vertices, layout, i) - centroid;
+		spread += glm::dot(offset, offset);
+	}
+
+	float radius = vertex_total > 0 ? sqrt(spread / float(vertex_total)) : 0.0f;
+	float radius_step = tolerance > 1e-6f ? tolerance * 64.0f : 1e-4f;
+	return (int64_t)floor(radius / radius_step + 0.5f);
+}
+
+//frame spanned by the centroid, the vertex farthest from it and the vertex farthest
+//off that axis. the same vertex indices build the frame of a candidate instance
+static instance_frame buildFrame(const vector<float> &vertices, const vertex_layout &layout, int first, int second)
+{
+	instance_frame frame;
+	frame.valid = false;
+
+	int vertex_total = vertices.size() / layout.stride;
+	frame.origin = glm::vec3(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < vertex_total; i++)
+		frame.origin = frame.origin + positionAt(vertices, layout, i);
+
+	frame.origin = frame.origin / float(vertex_total);
+
+	glm::vec3 first_axis = positionAt(vertices, layout, first) - frame.origin;
+	if (glm::length(first_axis) < 1e-12f)
+		return frame;
+
+	frame.axes[0] = glm::normalize(first_axis);
+
+	glm::vec3 second_axis = positionAt(vertices, layout, second) - frame.origin;
+	second_axis = second_axis - frame.axes[0] * glm::dot(second_axis, frame.axes[0]);
+	if (glm::length(second_axis) < 1e-12f)
+	{
+		//collinear geometry, any perpendicular works as long as both sides pick the same one
+		second_axis = fabs(frame.axes[0].x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		second_axis = second_axis - frame.axes[0] * glm::dot(second_axis, frame.axes[0]);
+	}
+
+	frame.axes[1] = glm::normalize(second_axis);
+	frame.axes[2] = glm::cross(frame.axes[0], frame.axes[1]);
+	frame.valid = true;
+	return frame;
+}
+
+static void chooseFrameVertices(const vector<float> &vertices, const vertex_layout &layout, int &first, int &second)
+{
+	int vertex_total = vertices.size() / layout.stride;
+	glm::vec3 centroid(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < vertex_total; i++)
+		centroid = centroid + positionAt(vertices, layout, i);
+
+	centroid = centroid / float(vertex_total);
+
+	first = 0;
+	float farthest = -1.0f;
+	for (int i = 0; i < vertex_total; i++)
+	{
+		glm::vec3 offset = positionAt(vertices, layout, i) - centroid;
+		if (glm::dot(offset, offset) > farthest)
+		{
+			farthest = glm::dot(offset, offset);
+			first = i;
+		}
+	}
+
+	glm::vec3 axis = positionAt(vertices, layout, first) - centroid;
+	second = first;
+	float widest = -1.0f;
+	for (int i = 0; i < vertex_total; i++)
+	{
+		glm::vec3 off_axis = glm::cross(axis, positionAt(vertices, layout, i) - centroid);
+		if (glm::dot(off_axis, off_axis) > widest)
+		{
+			widest = glm::dot(off_axis, off_axis);
+			second = i;
+		}
+	}
+}
+
+static glm::vec3 rotate(const instance_frame &from, const instance_frame &to, const glm::vec3 &v)
+{
+	//express v in the source frame, rebuild it from the destination axes
+	return to.axes[0] * glm::dot(v, from.axes[0]) + to.axes[1] * glm::dot(v, from.axes[1]) + to.axes[2] * glm::dot(v, from.axes[2]);
+}
+
+static bool matchInstance(const vector<float> &prototype, const vector<float> &candidate, const vertex_layout &layout,
+	int first, int second, float tolerance, glm::mat4 &transform)
+{
+	if (prototype.size() != candidate.size())
+		return false;
+
+	instance_frame from = buildFrame(prototype, layout, first, second);
+	instance_frame to = buildFrame(candidate, layout, first, second);
+	if (!from.valid || !to.valid)
+		return false;
+
+	int vertex_total = prototype.size() / layout.stride;
+	for (int i = 0; i < vertex_total; i++)
+	{
+		const float* a = &prototype[i * layout.stride];
+		const float* b = &candidate[i * layout.stride];
+
+		glm::vec3 moved = rotate(from, to, positionAt(prototype, layout, i) - from.origin) + to.origin;
+		if (glm::distance(moved, positionAt(candidate, layout, i)) > tolerance)
+			return false;
+
+		for (int n = 0; n < layout.vt_size; n++)
+		{
+			if (fabs(a[layout.vt_offset + n] - b[layout.vt_offset + n]) > tolerance)
+				return false;
+		}
+
+		if (layout.vn_size == 3)
+		{
+			glm::vec3 normal(a[layout.vn_offset], a[layout.vn_offset + 1], a[layout.vn_offset + 2]);
+			glm::vec3 other(b[layout.vn_offset], b[layout.vn_offset + 1], b[layout.vn_offset + 2]);
+			if (glm::distance(rotate(from, to, normal), other) > 0.001f)
+				return false;
+		}
+	}
+
+	//columns of the rotation are the source axes carried into the destination frame
+	glm::vec3 x = rotate(from, to, glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::vec3 y = rotate(from, to, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::vec3 z = rotate(from, to, glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::vec3 translation = to.origin - rotate(from, to, from.origin);
+
+	transform = glm::mat4(1.0f);
+	transform[0] = glm::vec4(x.x, x.y, x.z, 0.0f);
+	transform[1] = glm::vec4(y.x, y.y, y.z, 0.0f);
+	transform[2] = glm::vec4(z.x, z.y, z.z, 0.0f);
+	transform[3] = glm::vec4(translation.x, translation.y, translation.z, 1.0f);
+	return true;
+}
+
+const vector<instance_group> findInstances(const vector<mesh_data> &meshes, float tolerance)
+{
+	int mesh_total = meshes.size();
+	vector< vector<float> > vertex_data(mesh_total);
+	vector<vertex_layout> layouts(mesh_total);
+	vector<uint64_t> fingerprints(mesh_total);
+	vector<int64_t> radius_cells(mesh_total);
+
+	parallelFor(mesh_total, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			vertex_data[i] = meshes[i].getIndexedVertexData();
+			layouts[i] = meshes[i].getIndexedVertexLayout();
+			fingerprints[i] = fingerprintMesh(meshes[i], vertex_data[i], layouts[i]);
+			radius_cells[i] = radiusCell(vertex_data[i], layouts[i], tolerance);
+		}
+	}, 16);
+
+	vector<instance_group> groups;
+	//frame vertices are picked once per prototype and reused for every candidate
+	vector<int> group_source;
+	vector<int> frame_first;
+	vector<int> frame_second;
+	//keyed by fingerprint and radius cell
+	std::unordered_map< uint64_t, vector<int> > groups_by_key;
+
+	for (int i = 0; i < mesh_total; i++)
+	{
+		const vertex_layout &layout = layouts[i];
+		bool comparable = layout.stride > 0 && layout.v_size >= 3 && !vertex_data[i].empty();
+
+		if (comparable)
+		{
+			bool matched = false;
+			static const int cell_offsets[3] = { 0, -1, 1 };
+			for (int c = 0; c < 3 && !matched; c++)
+			{
+				std::unordered_map< uint64_t, vector<int> >::const_iterator found =
+					groups_by_key.find(hashCombine(fingerprints[i], radius_cells[i] + cell_offsets[c]));
+				if (found == groups_by_key.end())
+					continue;
+
+				for (auto group_index : found->second)
+				{
+					int source = group_source[group_index];
+					if (layouts[source].stride != layout.stride || meshes[source].getElementIndex() != meshes[i].getElementIndex())
+						continue;
+
+					glm::mat4 transform;
+					if (matchInstance(vertex_data[source], vertex_data[i], layout, frame_first[group_index], frame_second[group_index], tolerance, transform))
+					{
+						groups[group_index].source_meshes.push_back(i);
+						groups[group_index].instance_names.push_back(meshes[i].getMeshlName());
+						groups[group_index].transforms.push_back(transform);
+						matched = true;
+						break;
+					}
+				}
+			}
+
+			if (matched)
+				continue;
+		}
+
+		int first = 0;
+		int second = 0;
+		if (comparable)
+		{
+			chooseFrameVertices(vertex_data[i], layout, first, second);
+			groups_by_key[hashCombine(fingerprints[i], radius_cells[i])].push_back(groups.size());
+		}
+
+		groups.push_back(instance_group());
+		groups.back().prototype = meshes[i];
+		groups.back().source_meshes.push_back(i);
+		groups.back().instance_names.push_back(meshes[i].getMeshlName());
+		groups.back().transforms.push_back(glm::mat4(1.0f));
+		group_source.push_back(i);
+		frame_first.push_back(first);
+		frame_second.push_back(second);
+	}
+
+	return groups;
+}
@@ -0,0 +1,25 @@
+#ifndef MESH_INSTANCING_H
+#define MESH_INSTANCING_H
+
+#include "obj_parser.h"
+
+//one unique piece of geometry and every place it appears. transforms[i] is the
+//rigid transform (rotation + translation) that maps the prototype onto the mesh
+//meshes[source_meshes[i]], the prototype itself is the first entry with identity
+struct instance_group
+{
+	mesh_data prototype;
+	vector<int> source_meshes;
+	vector<string> instance_names;
+	vector<glm::mat4> transforms;
+};
+
+//groups meshes that are identical up to a rigid transform. a fingerprint of the
+//index buffer, layout and material, plus the rotation invariant spread of the
+//positions rounded to cells, narrows the candidates. neighbouring cells are searched
+//too, then a transform is fitted from three corresponding vertices and
+//every position and normal is checked against it within tolerance. each mesh ends
+//up in exactly one group, unmatched meshes form groups of one
+const vector<instance_group> findInstances(const vector<mesh_data> &meshes, float tolerance = 0.0001f);
+
+#endif
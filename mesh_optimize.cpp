@@ -0,0 +1,474 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+
+//fifo cache state: a vertex is cached if fewer than cache_size misses happened since
+//it was loaded. reset() empties the cache without touching every vertex
+class fifo_cache
+{
+public:
+	fifo_cache(int vertex_total, int size) : loaded_at(vertex_total, 0), time(size + 1), cache_size(size) {};
+
+	bool access(int v)
+	{
+		if (time - loaded_at[v] <= cache_size)
+			return false;
+
+		loaded_at[v] = time++;
+		return true;
+	}
+
+	void reset() { time += cache_size + 1; }
+
+private:
+	vector<unsigned int> loaded_at;
+	unsigned int time;
+	unsigned int cache_size;
+};
+
+static int vertexTotal(const vector<float> &vertices, const vertex_layout &layout, const vector<unsigned short> &indices)
+{
+	int vertex_total = layout.stride > 0 ? vertices.size() / layout.stride : 0;
+	for (auto index : indices)
+		vertex_total = std::max(vertex_total, (int)index + 1);
+
+	return vertex_total;
+}
+
+static const glm::vec3 vertexPosition(const vector<float> &vertices, const vertex_layout &layout, int v)
+{
+	const float* p = &vertices[(size_t)v * layout.stride + layout.v_offset];
+	return glm::vec3(p[0], p[1], p[2]);
+}
+
+//orthographic views down each axis in both directions, back faces are culled and the
+//rest drawn in order with a depth test. every fragment that passes counts as shaded
+static float measureOverdraw(const vector<float> &vertices, const vertex_layout &layout, const vector<unsigned short> &indices)
+{
+	const int grid = 256;
+	int triangle_total = indices.size() / 3;
+	if (layout.stride <= 0 || layout.v_size < 3 || triangle_total == 0)
+		return 0.0f;
+
+	glm::vec3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX);
+	glm::vec3 bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (auto index : indices)
+	{
+		glm::vec3 p = vertexPosition(vertices, layout, index);
+		bounds_min = glm::vec3(fminf(bounds_min.x, p.x), fminf(bounds_min.y, p.y), fminf(bounds_min.z, p.z));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, p.x), fmaxf(bounds_max.y, p.y), fmaxf(bounds_max.z, p.z));
+	}
+
+	glm::vec3 extent = bounds_max - bounds_min;
+	float scale = (grid - 1) / fmaxf(fmaxf(extent.x, extent.y), fmaxf(extent.z, 1e-20f));
+
+	vector<float> depth(grid * grid);
+	unsigned long long shaded = 0;
+	unsigned long long covered = 0;
+
+	for (int view = 0; view < 6; view++)
+	{
+		int axis = view / 2;
+		float toward_viewer = view % 2 == 0 ? 1.0f : -1.0f;
+		int u_axis = (axis + 1) % 3;
+		int v_axis = (axis + 2) % 3;
+		std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+		for (int t = 0; t < triangle_total; t++)
+		{
+			glm::vec3 corners[3];
+			for (int c = 0; c < 3; c++)
+				corners[c] = (vertexPosition(vertices, layout, indices[t * 3 + c]) - bounds_min) * scale;
+
+			glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			if (normal[axis] * toward_viewer <= 0.0f)
+				continue;
+
+			float x[3], y[3], z[3];
+			for (int c = 0; c < 3; c++)
+			{
+				x[c] = corners[c][u_axis];
+				y[c] = corners[c][v_axis];
+				z[c] = -corners[c][axis] * toward_viewer;
+			}
+
+			float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			if (area == 0.0f)
+				continue;
+
+			float inverse_area = 1.0f / area;
+			int min_x = std::max(0, (int)floorf(fminf(x[0], fminf(x[1], x[2]))));
+			int max_x = std::min(grid - 1, (int)ceilf(fmaxf(x[0], fmaxf(x[1], x[2]))));
+			int min_y = std::max(0, (int)floorf(fminf(y[0], fminf(y[1], y[2]))));
+			int max_y = std::min(grid - 1, (int)ceilf(fmaxf(y[0], fmaxf(y[1], y[2]))));
+
+			for (int py = min_y; py <= max_y; py++)
+			{
+				for (int px = min_x; px <= max_x; px++)
+				{
+					float sx = px + 0.5f;
+					float sy = py + 0.5f;
+					//barycentric weights, all non-negative inside whichever way the triangle winds in 2d
+					float w0 = ((x[1] - sx) * (y[2] - sy) - (x[2] - sx) * (y[1] - sy)) * inverse_area;
+					float w1 = ((x[2] - sx) * (y[0] - sy) - (x[0] - sx) * (y[2] - sy)) * inverse_area;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					float fragment_depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+					float &stored = depth[py * grid + px];
+					if (fragment_depth < stored)
+					{
+						stored = fragment_depth;
+						shaded++;
+					}
+				}
+			}
+		}
+
+		for (auto d : depth)
+			covered += d != FLT_MAX;
+	}
+
+	return covered > 0 ? float(double(shaded) / double(covered)) : 0.0f;
+}
+
+const order_metrics measureOrder(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, int cache_size)
+{
+	order_metrics metrics;
+	int vertex_total = vertexTotal(vertices, layout, indices);
+	int triangle_total = indices.size() / 3;
+	if (triangle_total == 0)
+		return metrics;
+
+	fifo_cache cache(vertex_total, cache_size);
+	vector<bool> referenced(vertex_total, false);
+	int misses = 0;
+	int referenced_total = 0;
+
+	for (int i = 0; i < triangle_total * 3; i++)
+	{
+		misses += cache.access(indices[i]);
+		if (!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			referenced_total++;
+		}
+	}
+
+	metrics.acmr = float(misses) / float(triangle_total);
+	metrics.atvr = float(misses) / float(referenced_total);
+
+	if ((int)vertices.size() >= vertex_total * layout.stride && layout.stride > 0)
+	{
+		const int line_bytes = 64;
+		const int line_total = 256;
+		vector<long long> cached_lines(line_total, -1);
+		size_t vertex_bytes = layout.stride * sizeof(float);
+		unsigned long long fetched = 0;
+
+		for (int i = 0; i < triangle_total * 3; i++)
+		{
+			long long first_line = (long long)(indices[i] * vertex_bytes / line_bytes);
+			long long last_line = (long long)(((indices[i] + 1) * vertex_bytes - 1) / line_bytes);
+			for (long long line = first_line; line <= last_line; line++)
+			{
+				if (cached_lines[line % line_total] != line)
+				{
+					cached_lines[line % line_total] = line;
+					fetched += line_bytes;
+				}
+			}
+		}
+
+		metrics.overfetch = float(double(fetched) / double(referenced_total * vertex_bytes));
+		metrics.overdraw = measureOverdraw(vertices, layout, indices);
+	}
+
+	return metrics;
+}
+
+//tipsify (sander, nehab and barczak 2007): fans around a vertex, then moves to the
+//neighbor that will still be cached, falling back to recently used vertices with live
+//triangles and finally to the next unfinished vertex in index order. hard_boundaries
+//marks where the order had to jump, the cache holds nothing useful there
+static const vector<int> tipsify(const vector<unsigned short> &indices, int vertex_total, int cache_size, vector<int> &hard_boundaries)
+{
+	int triangle_total = indices.size() / 3;
+
+	//vertex to triangle adjacency as offsets into one list
+	vector<int> live(vertex_total, 0);
+	for (auto index : indices)
+		live[index]++;
+
+	vector<int> adjacency_start(vertex_total + 1, 0);
+	for (int v = 0; v < vertex_total; v++)
+		adjacency_start[v + 1] = adjacency_start[v] + live[v];
+
+	vector<int> adjacency(indices.size());
+	vector<int> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+	for (int i = 0; i < (int)indices.size(); i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	vector<unsigned int> cached_at(vertex_total, 0);
+	unsigned int time = cache_size + 1;
+	vector<bool> emitted(triangle_total, false);
+	vector<int> dead_end;
+	vector<int> candidates;
+	vector<int> order;
+	order.reserve(triangle_total);
+
+	int fanning = 0;
+	int cursor = 1;
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+
+		for (int a = adjacency_start[fanning]; a < adjacency_start[fanning + 1]; a++)
+		{
+			int t = adjacency[a];
+			if (emitted[t])
+				continue;
+
+			emitted[t] = true;
+			order.push_back(t);
+
+			for (int c = 0; c < 3; c++)
+			{
+				int v = indices[t * 3 + c];
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+
+				if (time - cached_at[v] > (unsigned int)cache_size)
+					cached_at[v] = time++;
+			}
+		}
+
+		//prefer the candidate that stays in the cache longest while its fan is emitted.
+		//candidates that would fall out of the cache score 0 and are never picked, the
+		//dead-end stack is tried next
+		int best = -1;
+		int best_priority = 0;
+		for (auto v : candidates)
+		{
+			if (live[v] <= 0)
+				continue;
+
+			int priority = 0;
+			if ((int)(time - cached_at[v]) + 2 * live[v] <= cache_size)
+				priority = time - cached_at[v];
+
+			if (priority > best_priority)
+			{
+				best = v;
+				best_priority = priority;
+			}
+		}
+
+		if (best >= 0)
+		{
+			fanning = best;
+			continue;
+		}
+
+		if (!order.empty())
+			hard_boundaries.push_back(order.size());
+
+		fanning = -1;
+		while (!dead_end.empty())
+		{
+			int v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0)
+			{
+				fanning = v;
+				break;
+			}
+		}
+
+		while (fanning < 0 && cursor < vertex_total)
+		{
+			if (live[cursor] > 0)
+				fanning = cursor;
+			cursor++;
+		}
+	}
+
+	return order;
+}
+
+const overdraw_result optimizeOverdraw(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, float threshold, int cache_size)
+{
+	overdraw_result result;
+	result.cluster_count = 0;
+	result.before = measureOrder(vertices, layout, indices, cache_size);
+
+	int vertex_total = vertexTotal(vertices, layout, indices);
+	int triangle_total = indices.size() / 3;
+	if (triangle_total == 0 || layout.stride <= 0 || layout.v_size < 3 || (int)vertices.size() < vertex_total * layout.stride)
+	{
+		result.indices = indices;
+		result.after = result.before;
+		return result;
+	}
+
+	vector<int> hard_boundaries;
+	vector<int> order = tipsify(indices, vertex_total, cache_size, hard_boundaries);
+	hard_boundaries.push_back(triangle_total);
+
+	//splits each hard cluster wherever the acmr since the last split is already within
+	//threshold of the acmr of the whole hard cluster
+	vector<int> cluster_starts;
+	fifo_cache cache(vertex_total, cache_size);
+	int hard_start = 0;
+
+	for (auto hard_end : hard_boundaries)
+	{
+		if (hard_end <= hard_start)
+			continue;
+
+		cache.reset();
+		int cluster_misses = 0;
+		for (int i = hard_start; i < hard_end; i++)
+		{
+			for (int c = 0; c < 3; c++)
+				cluster_misses += cache.access(indices[order[i] * 3 + c]);
+		}
+
+		float cluster_threshold = threshold * float(cluster_misses) / float(hard_end - hard_start);
+
+		cache.reset();
+		cluster_starts.push_back(hard_start);
+		int running_start = hard_start;
+		int running_misses = 0;
+
+		for (int i = hard_start; i < hard_end; i++)
+		{
+			for (int c = 0; c < 3; c++)
+				running_misses += cache.access(indices[order[i] * 3 + c]);
+
+			if (i + 1 < hard_end && running_misses <= cluster_threshold * float(i + 1 - running_start))
+			{
+				cluster_starts.push_back(i + 1);
+				running_start = i + 1;
+				running_misses = 0;
+				cache.reset();
+			}
+		}
+
+		hard_start = hard_end;
+	}
+
+	//outward-facing clusters first, sorted by how far along its normal a cluster sits
+	glm::vec3 mesh_center(0.0f, 0.0f, 0.0f);
+	float mesh_area = 0.0f;
+	vector<glm::vec3> cluster_centers(cluster_starts.size());
+	vector<glm::vec3> cluster_normals(cluster_starts.size());
+	vector<float> cluster_areas(cluster_starts.size());
+
+	for (int k = 0; k < (int)cluster_starts.size(); k++)
+	{
+		int end = k + 1 < (int)cluster_starts.size() ? cluster_starts[k + 1] : triangle_total;
+		glm::vec3 center(0.0f, 0.0f, 0.0f);
+		glm::vec3 normal(0.0f, 0.0f, 0.0f);
+		float area = 0.0f;
+
+		for (int i = cluster_starts[k]; i < end; i++)
+		{
+			glm::vec3 a = vertexPosition(vertices, layout, indices[order[i] * 3]);
+			glm::vec3 b = vertexPosition(vertices, layout, indices[order[i] * 3 + 1]);
+			glm::vec3 c = vertexPosition(vertices, layout, indices[order[i] * 3 + 2]);
+			glm::vec3 face_normal = glm::cross(b - a, c - a);
+			float face_area = glm::length(face_normal);
+
+			center = center + (a + b + c) * (face_area / 3.0f);
+			normal = normal + face_normal;
+			area += face_area;
+		}
+
+		cluster_centers[k] = area > 0.0f ? center * (1.0f / area) : center;
+		float normal_length = glm::length(normal);
+		cluster_normals[k] = normal_length > 0.0f ? normal * (1.0f / normal_length) : normal;
+		cluster_areas[k] = area;
+
+		mesh_center = mesh_center + center;
+		mesh_area += area;
+	}
+
+	if (mesh_area > 0.0f)
+		mesh_center = mesh_center * (1.0f / mesh_area);
+
+	vector<float> sort_keys(cluster_starts.size());
+	vector<int> cluster_order(cluster_starts.size());
+	for (int k = 0; k < (int)cluster_starts.size(); k++)
+	{
+		sort_keys[k] = glm::dot(cluster_centers[k] - mesh_center, cluster_normals[k]);
+		cluster_order[k] = k;
+	}
+
+	std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](int a, int b) { return sort_keys[a] > sort_keys[b]; });
+
+	result.indices.reserve(indices.size());
+	for (auto k : cluster_order)
+	{
+		int end = k + 1 < (int)cluster_starts.size() ? cluster_starts[k + 1] : triangle_total;
+		for (int i = cluster_starts[k]; i < end; i++)
+		{
+			for (int c = 0; c < 3; c++)
+				result.indices.push_back(indices[order[i] * 3 + c]);
+		}
+	}
+
+	result.cluster_count = cluster_starts.size();
+	result.after = measureOrder(vertices, layout, result.indices, cache_size);
+	return result;
+}
+
+const fetch_result optimizeVertexFetch(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices)
+{
+	fetch_result result;
+	result.before = measureOrder(vertices, layout, indices);
+
+	int vertex_total = layout.stride > 0 ? vertices.size() / layout.stride : 0;
+	result.remap.assign(vertex_total, -1);
+	result.indices.reserve(indices.size());
+
+	int next_vertex = 0;
+	for (auto index : indices)
+	{
+		if (index >= vertex_total)
+		{
+			result.indices.push_back(index);
+			continue;
+		}
+
+		if (result.remap[index] < 0)
+		{
+			result.remap[index] = next_vertex++;
+			result.vertices.insert(result.vertices.end(), vertices.begin() + (size_t)index * layout.stride,
+				vertices.begin() + (size_t)(index + 1) * layout.stride);
+		}
+
+		result.indices.push_back(result.remap[index]);
+	}
+
+	result.after = measureOrder(result.vertices, layout, result.indices);
+	return result;
+}
+
+const fetch_result optimizeMeshOrder(const mesh_data &mesh, float threshold, int cache_size)
+{
+	vector<float> vertices = mesh.getIndexedVertexData();
+	vertex_layout layout = mesh.getIndexedVertexLayout();
+
+	overdraw_result reordered = optimizeOverdraw(vertices, layout, mesh.getElementIndex(), threshold, cache_size);
+	fetch_result result = optimizeVertexFetch(vertices, layout, reordered.indices);
+	result.before = reordered.before;
+	result.after = measureOrder(result.vertices, layout, result.indices, cache_size);
+	return result;
+}
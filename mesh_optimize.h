@@ -0,0 +1,61 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include "obj_parser.h"
+
+//how well an index order suits the gpu, measured on the buffers as given
+struct order_metrics
+{
+	order_metrics() : acmr(0.0f), atvr(0.0f), overdraw(0.0f), overfetch(0.0f) {};
+
+	//post-transform cache misses per triangle for a fifo cache, 0.5 to 3
+	float acmr;
+	//cache misses per referenced vertex, 1 is optimal
+	float atvr;
+	//shaded pixels per covered pixel, averaged over views along the six axes, 1 is optimal
+	float overdraw;
+	//bytes read through 64 byte cache lines per byte of referenced vertex data
+	float overfetch;
+};
+
+struct overdraw_result
+{
+	//the source triangles, reordered
+	vector<unsigned short> indices;
+	//groups of triangles kept together so the cache order inside them survives
+	int cluster_count;
+	order_metrics before;
+	order_metrics after;
+};
+
+struct fetch_result
+{
+	//referenced vertices in the order the indices first use them, same layout as the source
+	vector<float> vertices;
+	vector<unsigned short> indices;
+	//for each source vertex its new index, -1 for vertices no triangle uses
+	vector<int> remap;
+	order_metrics before;
+	order_metrics after;
+};
+
+//simulates a fifo vertex cache of cache_size entries, a 256 by 256 depth-tested
+//rasterizer for overdraw and a direct-mapped 16 kb cache for vertex fetch
+const order_metrics measureOrder(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, int cache_size = 16);
+
+//orders triangles for the vertex cache with tipsify, cuts the order into clusters
+//wherever the cache restarts or, within threshold times the cluster's own acmr, where
+//a cluster's running acmr allows it, then draws clusters facing away from the mesh
+//center first so they occlude the ones behind them. linear apart from the cluster sort
+const overdraw_result optimizeOverdraw(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, float threshold = 1.05f, int cache_size = 16);
+
+//renumbers vertices in order of first use so fetches walk the vertex buffer forward
+const fetch_result optimizeVertexFetch(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices);
+
+//both passes on the mesh's indexed data, before holds the metrics of the mesh as loaded
+const fetch_result optimizeMeshOrder(const mesh_data &mesh, float threshold = 1.05f, int cache_size = 16);
+
+#endif
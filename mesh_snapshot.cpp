@@ -0,0 +1,196 @@
+#include "mesh_snapshot.h"
+#include "obj_parallel.h"
+
+mesh_snapshot::mesh_snapshot(const mesh_data &mesh) :
+	mesh_name(mesh.getMeshlName()),
+	material_name(mesh.getMaterialName()),
+	v_data(std::make_shared<const vector<float> >(mesh.getVData())),
+	vt_data(std::make_shared<const vector<float> >(mesh.getVTData())),
+	vn_data(std::make_shared<const vector<float> >(mesh.getVNData())),
+	vp_data(std::make_shared<const vector<float> >(mesh.getVPData())),
+	v_size(mesh.getVSize()),
+	vt_size(mesh.getVTSize()),
+	vn_size(mesh.getVNSize()),
+	element_index(std::make_shared<const vector<unsigned short> >(mesh.getElementIndex())),
+	face_count(mesh.getFaceCount()),
+	bounds_min(mesh.getBoundsMin()),
+	bounds_max(mesh.getBoundsMax()),
+	sphere(mesh.getBoundingSphere())
+{
+	if ((mesh.getRepresentations() & MESH_INDEXED) && mesh.getIndexedVertexCount() > 0)
+	{
+		layout = mesh.getIndexedVertexLayout();
+		std::shared_ptr<vector<float> > indexed = std::make_shared<vector<float> >((size_t)mesh.getIndexedVertexCount() * layout.stride);
+		mesh.copyIndexedVertexData(&(*indexed)[0]);
+		indexed_data = indexed;
+	}
+
+	else indexed_data = std::make_shared<const vector<float> >();
+}
+
+mesh_handle mesh_snapshot::modifyPosition(const glm::mat4 &translation_matrix) const
+{
+	std::shared_ptr<mesh_snapshot> edited = std::make_shared<mesh_snapshot>(*this);
+	edited->transform(translation_matrix, false);
+	return edited;
+}
+
+mesh_handle mesh_snapshot::rotate(const glm::mat4 &rotation_matrix) const
+{
+	std::shared_ptr<mesh_snapshot> edited = std::make_shared<mesh_snapshot>(*this);
+	edited->transform(rotation_matrix, true);
+	return edited;
+}
+
+mesh_handle mesh_snapshot::setMaterialName(const string &name) const
+{
+	std::shared_ptr<mesh_snapshot> edited = std::make_shared<mesh_snapshot>(*this);
+	edited->material_name = name;
+	return edited;
+}
+
+mesh_handle mesh_snapshot::setMeshName(const string &name) const
+{
+	std::shared_ptr<mesh_snapshot> edited = std::make_shared<mesh_snapshot>(*this);
+	edited->mesh_name = name;
+	return edited;
+}
+
+//called only on a copy that no other thread has seen yet. each vertex goes through a
+//temporary vertex_data so the math matches mesh_data::modifyPosition and rotate
+void mesh_snapshot::transform(const glm::mat4 &matrix, bool rotate_normals)
+{
+	if (v_size >= 3)
+	{
+		std::shared_ptr<vector<float> > moved_v = std::make_shared<vector<float> >(*v_data);
+		std::shared_ptr<vector<float> > moved_vn = rotate_normals && vn_size > 0 ? std::make_shared<vector<float> >(*vn_data) : NULL;
+
+		int corner_total = moved_v->size() / v_size;
+		parallelFor(corner_total, [&](int begin, int end) {
+			for (int c = begin; c < end; c++)
+			{
+				float* position = &(*moved_v)[(size_t)c * v_size];
+				float* normal = moved_vn && (int)moved_vn->size() >= (c + 1) * vn_size ? &(*moved_vn)[(size_t)c * vn_size] : NULL;
+
+				vertex_data vertex(vector<float>(position, position + v_size), vector<float>(),
+					normal != NULL ? vector<float>(normal, normal + vn_size) : vector<float>());
+
+				if (rotate_normals)
+					vertex.rotate(matrix);
+
+				else vertex.modifyPosition(matrix);
+
+				vector<float> moved_position = vertex.getVData();
+				std::copy(moved_position.begin(), moved_position.end(), position);
+
+				if (normal != NULL)
+				{
+					vector<float> moved_normal = vertex.getVNData();
+					std::copy(moved_normal.begin(), moved_normal.end(), normal);
+				}
+			}
+		});
+
+		v_data = moved_v;
+		if (moved_vn)
+			vn_data = moved_vn;
+	}
+
+	if (layout.stride > 0 && layout.v_size >= 3)
+	{
+		std::shared_ptr<vector<float> > moved = std::make_shared<vector<float> >(*indexed_data);
+		int vertex_total = moved->size() / layout.stride;
+
+		parallelFor(vertex_total, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				float* vertex = &(*moved)[(size_t)i * layout.stride];
+				float* position = vertex + layout.v_offset;
+				float* normal = rotate_normals && layout.vn_size > 0 ? vertex + layout.vn_offset : NULL;
+
+				vertex_data moved_vertex(vector<float>(position, position + layout.v_size), vector<float>(),
+					normal != NULL ? vector<float>(normal, normal + layout.vn_size) : vector<float>());
+
+				if (rotate_normals)
+					moved_vertex.rotate(matrix);
+
+				else moved_vertex.modifyPosition(matrix);
+
+				vector<float> moved_position = moved_vertex.getVData();
+				std::copy(moved_position.begin(), moved_position.end(), position);
+
+				if (normal != NULL)
+				{
+					vector<float> moved_normal = moved_vertex.getVNData();
+					std::copy(moved_normal.begin(), moved_normal.end(), normal);
+				}
+
+				if (!rotate_normals)
+					continue;
+
+				if (layout.tan_size == 3)
+				{
+					glm::vec3 tangent(matrix * glm::vec4(vertex[layout.tan_offset], vertex[layout.tan_offset + 1], vertex[layout.tan_offset + 2], 0.0f));
+					vertex[layout.tan_offset] = tangent.x;
+					vertex[layout.tan_offset + 1] = tangent.y;
+					vertex[layout.tan_offset + 2] = tangent.z;
+				}
+
+				if (layout.bitan_size == 3)
+				{
+					glm::vec3 bitangent(matrix * glm::vec4(vertex[layout.bitan_offset], vertex[layout.bitan_offset + 1], vertex[layout.bitan_offset + 2], 0.0f));
+					vertex[layout.bitan_offset] = bitangent.x;
+					vertex[layout.bitan_offset + 1] = bitangent.y;
+					vertex[layout.bitan_offset + 2] = bitangent.z;
+				}
+			}
+		});
+
+		indexed_data = moved;
+	}
+
+	updateBoundingVolumes();
+}
+
+void mesh_snapshot::updateBoundingVolumes()
+{
+	//unique vertices when the indexed data is held, the per-corner positions otherwise
+	point_set points;
+	if (layout.stride > 0 && layout.v_size >= 3 && !indexed_data->empty())
+	{
+		const vector<float> &vertices = *indexed_data;
+		points.reserve(vertices.size() / layout.stride);
+		for (size_t i = 0; i + layout.stride <= vertices.size(); i += layout.stride)
+			points.addPoint(glm::vec3(vertices[i + layout.v_offset], vertices[i + layout.v_offset + 1], vertices[i + layout.v_offset + 2]));
+	}
+
+	else if (v_size >= 3)
+	{
+		const vector<float> &positions = *v_data;
+		for (size_t i = 0; i + v_size <= positions.size(); i += v_size)
+			points.addPoint(glm::vec3(positions[i], positions[i + 1], positions[i + 2]));
+	}
+
+	if (points.getCount() == 0)
+		return;
+
+	points.pad();
+	computeBounds(points, bounds_min, bounds_max);
+	sphere = computeBoundingSphere(points, bounds_min, bounds_max);
+}
+
+mesh_handle freezeMesh(const mesh_data &mesh)
+{
+	return std::make_shared<const mesh_snapshot>(mesh);
+}
+
+const vector<mesh_handle> freezeMeshes(const vector<mesh_data> &meshes)
+{
+	vector<mesh_handle> handles(meshes.size());
+	parallelFor(meshes.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			handles[i] = freezeMesh(meshes[i]);
+	}, 1);
+
+	return handles;
+}
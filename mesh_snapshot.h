@@ -0,0 +1,85 @@
+#ifndef MESH_SNAPSHOT_H
+#define MESH_SNAPSHOT_H
+
+//read-only copies of loaded meshes for sharing between threads. a snapshot never
+//changes after it is built, so any number of threads can hold the same mesh_handle
+//and read from it without locks. edits return a new snapshot that points at the
+//buffers the edit left untouched instead of copying them
+
+#include "obj_parser.h"
+
+#include <memory>
+
+class mesh_snapshot;
+typedef std::shared_ptr<const mesh_snapshot> mesh_handle;
+
+class mesh_snapshot
+{
+public:
+	//copies the attribute lists and indexed data the mesh still holds, see mesh_data::compact
+	mesh_snapshot(const mesh_data &mesh);
+	~mesh_snapshot(){};
+
+	//references stay valid for as long as the snapshot is held
+	const string& getMeshName() const { return mesh_name; }
+	const string& getMaterialName() const { return material_name; }
+
+	const vector<float>& getVData() const { return *v_data; }
+	const vector<float>& getVTData() const { return *vt_data; }
+	const vector<float>& getVNData() const { return *vn_data; }
+	const vector<float>& getVPData() const { return *vp_data; }
+	const int getVSize() const { return v_size; }
+	const int getVTSize() const { return vt_size; }
+	const int getVNSize() const { return vn_size; }
+
+	//same contents as mesh_data::getIndexedVertexData and getElementIndex
+	const vector<float>& getIndexedVertexData() const { return *indexed_data; }
+	const vector<unsigned short>& getElementIndex() const { return *element_index; }
+	const vertex_layout& getIndexedVertexLayout() const { return layout; }
+	const int getIndexedVertexCount() const { return layout.stride > 0 ? indexed_data->size() / layout.stride : 0; }
+
+	const int getFaceCount() const { return face_count; }
+	const glm::vec3 getBoundsMin() const { return bounds_min; }
+	const glm::vec3 getBoundsMax() const { return bounds_max; }
+	const bounding_sphere getBoundingSphere() const { return sphere; }
+
+	//copy-on-write edits, mirroring mesh_data::modifyPosition and rotate. rotate also
+	//turns the tangents and bitangents of the indexed data, as directions
+	mesh_handle modifyPosition(const glm::mat4 &translation_matrix) const;
+	mesh_handle rotate(const glm::mat4 &rotation_matrix) const;
+	mesh_handle setMaterialName(const string &name) const;
+	mesh_handle setMeshName(const string &name) const;
+
+	//true when both snapshots read the same indexed vertex buffer
+	bool sharesIndexedData(const mesh_snapshot &other) const { return indexed_data == other.indexed_data; }
+
+private:
+	void transform(const glm::mat4 &matrix, bool rotate_normals);
+	void updateBoundingVolumes();
+
+	string mesh_name;
+	string material_name;
+
+	std::shared_ptr<const vector<float> > v_data;
+	std::shared_ptr<const vector<float> > vt_data;
+	std::shared_ptr<const vector<float> > vn_data;
+	std::shared_ptr<const vector<float> > vp_data;
+	int v_size;
+	int vt_size;
+	int vn_size;
+
+	std::shared_ptr<const vector<float> > indexed_data;
+	std::shared_ptr<const vector<unsigned short> > element_index;
+	vertex_layout layout;
+
+	int face_count;
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+	bounding_sphere sphere;
+};
+
+mesh_handle freezeMesh(const mesh_data &mesh);
+//freezes every mesh, spread over threads
+const vector<mesh_handle> freezeMeshes(const vector<mesh_data> &meshes);
+
+#endif
@@ -0,0 +1,343 @@
+#include "mesh_tiles.h"
+#include "obj_parallel.h"
+#include "vertex_dedup.h"
+
+#include <algorithm>
+#include <string.h>
+
+//triangles of one tile before its buffers are built
+struct tile_job
+{
+	int level;
+	int x, y, z;
+	vector<int> triangles;
+};
+
+static const vector<glm::vec3> triangleCentroids(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned int> &indices, glm::vec3 &bounds_min, glm::vec3 &bounds_max)
+{
+	int triangle_total = indices.size() / 3;
+	vector<glm::vec3> centroids(triangle_total);
+
+	parallelFor(triangle_total, [&](int begin, int end) {
+		for (int t = begin; t < end; t++)
+		{
+			glm::vec3 sum(0.0f, 0.0f, 0.0f);
+			for (int c = 0; c < 3; c++)
+			{
+				const float* p = &vertices[(size_t)indices[t * 3 + c] * layout.stride + layout.v_offset];
+				sum = sum + glm::vec3(p[0], p[1], p[2]);
+			}
+			centroids[t] = sum * (1.0f / 3.0f);
+		}
+	});
+
+	bounds_min = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	bounds_max = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const auto &c : centroids)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, c.x), fminf(bounds_min.y, c.y), fminf(bounds_min.z, c.z));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, c.x), fmaxf(bounds_max.y, c.y), fmaxf(bounds_max.z, c.z));
+	}
+
+	return centroids;
+}
+
+static int cellOf(float value, float low, float high, int cells)
+{
+	if (high <= low)
+		return 0;
+
+	int cell = (int)((value - low) / (high - low) * cells);
+	return std::max(0, std::min(cells - 1, cell));
+}
+
+static const vector<tile_job> gridJobs(const vector<glm::vec3> &centroids, const glm::vec3 &bounds_min,
+	const glm::vec3 &bounds_max, const tile_options &options)
+{
+	int divisions[3];
+	for (int axis = 0; axis < 3; axis++)
+		divisions[axis] = std::max(1, options.divisions[axis]);
+
+	int cell_total = divisions[0] * divisions[1] * divisions[2];
+	int triangle_total = centroids.size();
+	vector<int> cells(triangle_total);
+
+	parallelFor(triangle_total, [&](int begin, int end) {
+		for (int t = begin; t < end; t++)
+		{
+			int x = cellOf(centroids[t].x, bounds_min.x, bounds_max.x, divisions[0]);
+			int y = cellOf(centroids[t].y, bounds_min.y, bounds_max.y, divisions[1]);
+			int z = cellOf(centroids[t].z, bounds_min.z, bounds_max.z, divisions[2]);
+			cells[t] = (z * divisions[1] + y) * divisions[0] + x;
+		}
+	});
+
+	vector<int> counts(cell_total, 0);
+	for (auto cell : cells)
+		counts[cell]++;
+
+	vector<int> job_of_cell(cell_total, -1);
+	vector<tile_job> jobs;
+	for (int cell = 0; cell < cell_total; cell++)
+	{
+		if (counts[cell] == 0)
+			continue;
+
+		tile_job job;
+		job.level = 0;
+		job.x = cell % divisions[0];
+		job.y = cell / divisions[0] % divisions[1];
+		job.z = cell / (divisions[0] * divisions[1]);
+		job.triangles.reserve(counts[cell]);
+		job_of_cell[cell] = jobs.size();
+		jobs.push_back(job);
+	}
+
+	for (int t = 0; t < triangle_total; t++)
+		jobs[job_of_cell[cells[t]]].triangles.push_back(t);
+
+	return jobs;
+}
+
+static const vector<tile_job> octreeJobs(const vector<glm::vec3> &centroids, const glm::vec3 &bounds_min,
+	const glm::vec3 &bounds_max, const tile_options &options)
+{
+	vector<tile_job> leaves;
+	vector<tile_job> stack(1);
+	stack[0].level = 0;
+	stack[0].x = 0;
+	stack[0].y = 0;
+	stack[0].z = 0;
+	stack[0].triangles.resize(centroids.size());
+	for (int t = 0; t < (int)centroids.size(); t++)
+		stack[0].triangles[t] = t;
+
+	//the root is a cube from bounds_min, so flat meshes are not cut along their thin axis
+	glm::vec3 size = bounds_max - bounds_min;
+	float edge = fmaxf(size.x, fmaxf(size.y, size.z));
+
+	while (!stack.empty())
+	{
+		tile_job node = std::move(stack.back());
+		stack.pop_back();
+
+		if ((int)node.triangles.size() <= options.max_triangles || node.level >= options.max_depth)
+		{
+			leaves.push_back(std::move(node));
+			continue;
+		}
+
+		//children split the node's cell of the root cube at its middle
+		float cells = float(1 << node.level);
+		glm::vec3 center = bounds_min + glm::vec3(node.x + 0.5f, node.y + 0.5f, node.z + 0.5f) * (edge / cells);
+
+		tile_job children[8];
+		for (int child = 0; child < 8; child++)
+		{
+			children[child].level = node.level + 1;
+			children[child].x = node.x * 2 + (child & 1);
+			children[child].y = node.y * 2 + ((child >> 1) & 1);
+			children[child].z = node.z * 2 + ((child >> 2) & 1);
+		}
+
+		for (auto t : node.triangles)
+		{
+			const glm::vec3 &c = centroids[t];
+			children[(c.x >= center.x) | ((c.y >= center.y) << 1) | ((c.z >= center.z) << 2)].triangles.push_back(t);
+		}
+
+		for (int child = 7; child >= 0; child--)
+		{
+			if (!children[child].triangles.empty())
+				stack.push_back(std::move(children[child]));
+		}
+	}
+
+	std::sort(leaves.begin(), leaves.end(), [](const tile_job &a, const tile_job &b) {
+		if (a.level != b.level)
+			return a.level < b.level;
+		if (a.z != b.z)
+			return a.z < b.z;
+		if (a.y != b.y)
+			return a.y < b.y;
+		return a.x < b.x;
+	});
+
+	return leaves;
+}
+
+const vector<mesh_tile> tileTriangles(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned int> &indices, const tile_options &options)
+{
+	vector<mesh_tile> tiles;
+	if (layout.stride <= 0 || layout.v_size < 3 || indices.size() < 3)
+		return tiles;
+
+	glm::vec3 bounds_min, bounds_max;
+	vector<glm::vec3> centroids = triangleCentroids(vertices, layout, indices, bounds_min, bounds_max);
+	vector<tile_job> jobs = options.scheme == TILE_OCTREE ? octreeJobs(centroids, bounds_min, bounds_max, options)
+		: gridJobs(centroids, bounds_min, bounds_max, options);
+
+	int vertex_total = vertices.size() / layout.stride;
+	tiles.resize(jobs.size());
+
+	//each thread keeps one source-to-tile vertex map and clears only the entries it used
+	parallelFor(jobs.size(), [&](int begin, int end) {
+		vector<int> remap(vertex_total, -1);
+		vector<int> used;
+
+		for (int j = begin; j < end; j++)
+		{
+			const tile_job &job = jobs[j];
+			mesh_tile &tile = tiles[j];
+			tile.level = job.level;
+			tile.x = job.x;
+			tile.y = job.y;
+			tile.z = job.z;
+			tile.layout = layout;
+			tile.indices.reserve(job.triangles.size() * 3);
+			tile.bounds_min = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+			tile.bounds_max = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+			used.clear();
+			for (auto t : job.triangles)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					unsigned int source = indices[t * 3 + c];
+					if (remap[source] < 0)
+					{
+						remap[source] = used.size();
+						used.push_back(source);
+					}
+					tile.indices.push_back(remap[source]);
+				}
+			}
+
+			tile.vertices.resize(used.size() * layout.stride);
+			for (int v = 0; v < (int)used.size(); v++)
+			{
+				const float* source = &vertices[(size_t)used[v] * layout.stride];
+				memcpy(&tile.vertices[(size_t)v * layout.stride], source, layout.stride * sizeof(float));
+
+				glm::vec3 p(source[layout.v_offset], source[layout.v_offset + 1], source[layout.v_offset + 2]);
+				tile.bounds_min = glm::vec3(fminf(tile.bounds_min.x, p.x), fminf(tile.bounds_min.y, p.y), fminf(tile.bounds_min.z, p.z));
+				tile.bounds_max = glm::vec3(fmaxf(tile.bounds_max.x, p.x), fmaxf(tile.bounds_max.y, p.y), fmaxf(tile.bounds_max.z, p.z));
+
+				remap[used[v]] = -1;
+			}
+		}
+	}, 1);
+
+	return tiles;
+}
+
+const vector<mesh_tile> tileMesh(const mesh_data &mesh, const tile_options &options)
+{
+	int v_size = mesh.getVSize();
+	int vt_size = mesh.getVTSize();
+	int vn_size = mesh.getVNSize();
+
+	if ((mesh.getRepresentations() & MESH_ATTRIBUTE_LISTS) && v_size >= 3)
+	{
+		vector<float> positions = mesh.getVData();
+		vector<float> uvs = mesh.getVTData();
+		vector<float> normals = mesh.getVNData();
+
+		int corner_total = positions.size() / v_size;
+		corner_total -= corner_total % 3;
+		if (vt_size > 0 && (int)uvs.size() < corner_total * vt_size)
+			vt_size = 0;
+		if (vn_size > 0 && (int)normals.size() < corner_total * vn_size)
+			vn_size = 0;
+
+		vertex_layout layout;
+		layout.v_size = v_size;
+		layout.vt_offset = v_size;
+		layout.vt_size = vt_size;
+		layout.vn_offset = v_size + vt_size;
+		layout.vn_size = vn_size;
+		layout.stride = v_size + vt_size + vn_size;
+
+		//interleave the corners, then merge them back into shared vertices
+		vector<float> corners((size_t)corner_total * layout.stride);
+		parallelFor(corner_total, [&](int begin, int end) {
+			for (int c = begin; c < end; c++)
+			{
+				float* corner = &corners[(size_t)c * layout.stride];
+				memcpy(corner, &positions[(size_t)c * v_size], v_size * sizeof(float));
+				if (vt_size > 0)
+					memcpy(corner + layout.vt_offset, &uvs[(size_t)c * vt_size], vt_size * sizeof(float));
+				if (vn_size > 0)
+					memcpy(corner + layout.vn_offset, &normals[(size_t)c * vn_size], vn_size * sizeof(float));
+			}
+		});
+
+		vector<float> vertices;
+		vector<unsigned int> indices;
+		if (corner_total > 0)
+			dedupVertices(&corners[0], corner_total, layout.stride, vertices, indices);
+
+		return tileTriangles(vertices, layout, indices, options);
+	}
+
+	vector<unsigned short> element_index = mesh.getElementIndex();
+	return tileTriangles(mesh.getIndexedVertexData(), mesh.getIndexedVertexLayout(),
+		vector<unsigned int>(element_index.begin(), element_index.end()), options);
+}
+
+const glb_primitive glbPrimitive(const mesh_tile &tile, const string &name, const string &material)
+{
+	glb_primitive primitive;
+	primitive.name = name;
+	primitive.material = material;
+	primitive.layout = tile.layout;
+	primitive.vertex_total = tile.layout.stride > 0 ? tile.vertices.size() / tile.layout.stride : 0;
+	primitive.index_total = tile.indices.size();
+	primitive.index_size = sizeof(unsigned int);
+	primitive.bounds_min = tile.bounds_min;
+	primitive.bounds_max = tile.bounds_max;
+
+	const mesh_tile* source = &tile;
+	primitive.copy_vertices = [source](float* destination) {
+		memcpy(destination, source->vertices.data(), source->vertices.size() * sizeof(float));
+	};
+	primitive.copy_indices = [source](void* destination) {
+		memcpy(destination, source->indices.data(), source->indices.size() * sizeof(unsigned int));
+	};
+
+	return primitive;
+}
+
+bool writeTileGLBs(const vector<mesh_tile> &tiles, const string &file_prefix, const string &material,
+	const map<string, material_data> &materials, string &error)
+{
+	vector<string> errors(tiles.size());
+
+	parallelFor(tiles.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			const mesh_tile &tile = tiles[i];
+			string suffix = "_" + std::to_string(tile.level) + "_" + std::to_string(tile.x) + "_" +
+				std::to_string(tile.y) + "_" + std::to_string(tile.z);
+
+			vector<glb_primitive> primitives(1, glbPrimitive(tile, "tile" + suffix, material));
+			string path = file_prefix + suffix + ".glb";
+			writeGLB(path.c_str(), primitives, materials, errors[i]);
+		}
+	}, 1);
+
+	error.clear();
+	for (const auto &tile_error : errors)
+	{
+		if (tile_error.empty())
+			continue;
+
+		if (!error.empty())
+			error += "\n";
+		error += tile_error;
+	}
+
+	return error.empty();
+}
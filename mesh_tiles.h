@@ -0,0 +1,62 @@
+#ifndef MESH_TILES_H
+#define MESH_TILES_H
+
+#include "obj_parser.h"
+#include "glb_writer.h"
+
+enum TILE_SCHEME { TILE_GRID, TILE_OCTREE };
+
+struct tile_options
+{
+	tile_options() : scheme(TILE_GRID), max_triangles(65536), max_depth(8)
+	{
+		//obj terrain is usually y-up, so the default grid only splits the ground plane
+		divisions[0] = 8;
+		divisions[1] = 1;
+		divisions[2] = 8;
+	};
+
+	TILE_SCHEME scheme;
+	//TILE_GRID: cells along x, y and z over the mesh bounds
+	int divisions[3];
+	//TILE_OCTREE: a node splits into eight while it holds more than max_triangles,
+	//at most max_depth times
+	int max_triangles;
+	int max_depth;
+};
+
+//one spatial piece of a mesh with its own compact vertex and index buffers. triangles
+//belong to the tile holding their centroid, vertices they share with other tiles are
+//copied into each, so bounds of neighboring tiles may overlap slightly
+struct mesh_tile
+{
+	mesh_tile() : level(0), x(0), y(0), z(0), bounds_min(0.0f, 0.0f, 0.0f), bounds_max(0.0f, 0.0f, 0.0f) {};
+
+	//grid tiles are level 0, octree tiles use the cell coordinates of their depth
+	int level;
+	int x, y, z;
+	//exact bounds of the tile's vertices
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+	vertex_layout layout;
+	vector<float> vertices;
+	vector<unsigned int> indices;
+};
+
+//splits an indexed triangle list, tiles are built in parallel and come back ordered
+//by level, then z, y and x. empty tiles are left out
+const vector<mesh_tile> tileTriangles(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned int> &indices, const tile_options &options);
+
+//tiles the mesh from its per-corner attribute lists when it holds them, these are not
+//limited to 65536 vertices the way the indexed data is. otherwise the indexed data is used
+const vector<mesh_tile> tileMesh(const mesh_data &mesh, const tile_options &options = tile_options());
+
+const glb_primitive glbPrimitive(const mesh_tile &tile, const string &name, const string &material);
+
+//writes every tile to its own file, <file_prefix>_<level>_<x>_<y>_<z>.glb, in parallel.
+//returns false and describes the failures in error if any file could not be written
+bool writeTileGLBs(const vector<mesh_tile> &tiles, const string &file_prefix, const string &material,
+	const map<string, material_data> &materials, string &error);
+
+#endif
@@ -0,0 +1,455 @@
+#include "mesh_voxel.h"
+#include "mesh_hull.h"
+#include "obj_parallel.h"
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <bitset>
+#include <algorithm>
+
+//voxel boxes are grown by this much, in voxels, so rounding never drops a touched voxel
+static const float voxel_epsilon = 1e-4f;
+
+//a triangle in grid space, where voxel (x, y, z) spans [x, x + 1] on each axis
+struct voxel_triangle
+{
+	glm::vec3 v[3];
+	glm::vec3 edges[3];
+	glm::vec3 normal;
+};
+
+//bricks of one slab, found through a dense table over brick x and z
+struct voxel_slab
+{
+	int brick_y;
+	int bricks_x;
+	vector<int> lookup;
+	vector<voxel_brick> bricks;
+
+	void set(int x, int y, int z)
+	{
+		int &slot = lookup[(z / VOXEL_BRICK_SIZE) * bricks_x + x / VOXEL_BRICK_SIZE];
+		if (slot < 0)
+		{
+			voxel_brick brick;
+			brick.x = x / VOXEL_BRICK_SIZE;
+			brick.y = brick_y;
+			brick.z = z / VOXEL_BRICK_SIZE;
+			memset(brick.bits, 0, sizeof(brick.bits));
+
+			slot = bricks.size();
+			bricks.push_back(brick);
+		}
+
+		bricks[slot].bits[z % VOXEL_BRICK_SIZE] |= (uint64_t)1 << ((y % VOXEL_BRICK_SIZE) * VOXEL_BRICK_SIZE + x % VOXEL_BRICK_SIZE);
+	}
+};
+
+//a surface crossing of the +z ray through a column's center
+struct voxel_crossing
+{
+	float z;
+	int winding;
+
+	bool operator < (const voxel_crossing &other) const { return z < other.z; }
+};
+
+static bool brickBefore(const voxel_brick &a, const voxel_brick &b)
+{
+	if (a.z != b.z)
+		return a.z < b.z;
+	if (a.y != b.y)
+		return a.y < b.y;
+	return a.x < b.x;
+}
+
+const bool voxel_grid::isSet(int x, int y, int z) const
+{
+	if (x < 0 || y < 0 || z < 0 || x >= dimensions[0] || y >= dimensions[1] || z >= dimensions[2])
+		return false;
+
+	voxel_brick key;
+	key.x = x / VOXEL_BRICK_SIZE;
+	key.y = y / VOXEL_BRICK_SIZE;
+	key.z = z / VOXEL_BRICK_SIZE;
+
+	vector<voxel_brick>::const_iterator found = std::lower_bound(bricks.begin(), bricks.end(), key, brickBefore);
+	if (found == bricks.end() || brickBefore(key, *found))
+		return false;
+
+	return (found->bits[z % VOXEL_BRICK_SIZE] >> ((y % VOXEL_BRICK_SIZE) * VOXEL_BRICK_SIZE + x % VOXEL_BRICK_SIZE)) & 1;
+}
+
+const unsigned long long voxel_grid::getVoxelCount() const
+{
+	unsigned long long count = 0;
+	for (const auto &brick : bricks)
+	{
+		for (int word = 0; word < VOXEL_BRICK_SIZE; word++)
+			count += std::bitset<64>(brick.bits[word]).count();
+	}
+
+	return count;
+}
+
+//separating axis test of a triangle against the cube of half size half around center,
+//axes are the box normals, the triangle normal and the 9 edge and box axis cross products
+static bool triangleBoxOverlap(const voxel_triangle &triangle, const glm::vec3 &center, float half)
+{
+	glm::vec3 v[3] = { triangle.v[0] - center, triangle.v[1] - center, triangle.v[2] - center };
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float low = fminf(v[0][axis], fminf(v[1][axis], v[2][axis]));
+		float high = fmaxf(v[0][axis], fmaxf(v[1][axis], v[2][axis]));
+		if (low > half || high < -half)
+			return false;
+	}
+
+	float plane_distance = glm::dot(triangle.normal, v[0]);
+	float plane_radius = half * (fabsf(triangle.normal.x) + fabsf(triangle.normal.y) + fabsf(triangle.normal.z));
+	if (fabsf(plane_distance) > plane_radius)
+		return false;
+
+	for (int e = 0; e < 3; e++)
+	{
+		const glm::vec3 &edge = triangle.edges[e];
+		glm::vec3 axes[3] = {
+			glm::vec3(0.0f, -edge.z, edge.y),
+			glm::vec3(edge.z, 0.0f, -edge.x),
+			glm::vec3(-edge.y, edge.x, 0.0f)
+		};
+
+		for (const auto &axis : axes)
+		{
+			float p0 = glm::dot(axis, v[0]);
+			float p1 = glm::dot(axis, v[1]);
+			float p2 = glm::dot(axis, v[2]);
+			float radius = half * (fabsf(axis.x) + fabsf(axis.y) + fabsf(axis.z));
+
+			if (fminf(p0, fminf(p1, p2)) > radius || fmaxf(p0, fmaxf(p1, p2)) < -radius)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//sets every voxel of rows [row_begin, row_end) the triangle touches. voxels are visited
+//in columns along the normal's dominant axis, each column only over the cells the
+//triangle's plane passes through, so large slanted triangles cost their area, not their box
+static void voxelizeSurface(const voxel_triangle &triangle, int row_begin, int row_end, const int dimensions[3], voxel_slab &slab)
+{
+	int low[3];
+	int high[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float low_value = fminf(triangle.v[0][axis], fminf(triangle.v[1][axis], triangle.v[2][axis]));
+		float high_value = fmaxf(triangle.v[0][axis], fmaxf(triangle.v[1][axis], triangle.v[2][axis]));
+		low[axis] = std::max(0, (int)floorf(low_value - voxel_epsilon));
+		high[axis] = std::min(dimensions[axis] - 1, (int)floorf(high_value + voxel_epsilon));
+	}
+
+	low[1] = std::max(low[1], row_begin);
+	high[1] = std::min(high[1], row_end - 1);
+	if (low[0] > high[0] || low[1] > high[1] || low[2] > high[2])
+		return;
+
+	const glm::vec3 &n = triangle.normal;
+	int k = fabsf(n.x) >= fabsf(n.y) && fabsf(n.x) >= fabsf(n.z) ? 0 : (fabsf(n.y) >= fabsf(n.z) ? 1 : 2);
+	int i = (k + 1) % 3;
+	int j = (k + 2) % 3;
+	bool has_plane = fabsf(n[k]) > 0.0f;
+	float plane_offset = glm::dot(n, triangle.v[0]);
+	float half = 0.5f + voxel_epsilon;
+
+	for (int ci = low[i]; ci <= high[i]; ci++)
+	{
+		for (int cj = low[j]; cj <= high[j]; cj++)
+		{
+			int k_begin = low[k];
+			int k_end = high[k];
+
+			if (has_plane)
+			{
+				//plane height over the column's four corners
+				float k_low = FLT_MAX;
+				float k_high = -FLT_MAX;
+				for (int corner = 0; corner < 4; corner++)
+				{
+					float pi = float(ci + (corner & 1));
+					float pj = float(cj + (corner >> 1));
+					float pk = (plane_offset - n[i] * pi - n[j] * pj) / n[k];
+					k_low = fminf(k_low, pk);
+					k_high = fmaxf(k_high, pk);
+				}
+
+				k_begin = std::max(k_begin, (int)floorf(k_low - voxel_epsilon));
+				k_end = std::min(k_end, (int)floorf(k_high + voxel_epsilon));
+			}
+
+			for (int ck = k_begin; ck <= k_end; ck++)
+			{
+				int cell[3];
+				cell[i] = ci;
+				cell[j] = cj;
+				cell[k] = ck;
+
+				glm::vec3 center(cell[0] + 0.5f, cell[1] + 0.5f, cell[2] + 0.5f);
+				if (triangleBoxOverlap(triangle, center, half))
+					slab.set(cell[0], cell[1], cell[2]);
+			}
+		}
+	}
+}
+
+//twice the signed area of (a, b, p). the endpoints are put in a fixed order first, so
+//two triangles sharing an edge get exactly opposite values at any point
+static double edgeFunction(double ax, double ay, double bx, double by, double px, double py)
+{
+	bool swapped = bx < ax || (bx == ax && by < ay);
+	if (swapped)
+	{
+		std::swap(ax, bx);
+		std::swap(ay, by);
+	}
+
+	double w = (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+	return swapped ? -w : w;
+}
+
+//top-left rule for a counter-clockwise triangle, of the triangles sharing an edge
+//exactly one counts a sample lying on it
+static bool isTopLeftEdge(double ax, double ay, double bx, double by)
+{
+	return by < ay || (by == ay && bx < ax);
+}
+
+//adds the triangle's crossing to each column of rows [row_begin, row_end) whose center it covers
+static void addCrossings(const voxel_triangle &triangle, int row_begin, int row_end, const int dimensions[3],
+	vector< vector<voxel_crossing> > &columns)
+{
+	double x[3];
+	double y[3];
+	double z[3];
+	for (int c = 0; c < 3; c++)
+	{
+		x[c] = triangle.v[c].x;
+		y[c] = triangle.v[c].y;
+		z[c] = triangle.v[c].z;
+	}
+
+	double area = edgeFunction(x[0], y[0], x[1], y[1], x[2], y[2]);
+	if (area == 0.0)
+		return;
+
+	//the ray runs along +z, it enters through faces whose normal points down
+	int winding = area < 0.0 ? 1 : -1;
+	if (area < 0.0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+	}
+
+	double low_x = std::min(x[0], std::min(x[1], x[2]));
+	double high_x = std::max(x[0], std::max(x[1], x[2]));
+	double low_y = std::min(y[0], std::min(y[1], y[2]));
+	double high_y = std::max(y[0], std::max(y[1], y[2]));
+
+	int column_begin = std::max(0, (int)ceil(low_x - 0.5));
+	int column_end = std::min(dimensions[0] - 1, (int)floor(high_x - 0.5));
+	int first_row = std::max(row_begin, (int)ceil(low_y - 0.5));
+	int last_row = std::min(row_end - 1, (int)floor(high_y - 0.5));
+
+	bool top_left[3] = {
+		isTopLeftEdge(x[1], y[1], x[2], y[2]),
+		isTopLeftEdge(x[2], y[2], x[0], y[0]),
+		isTopLeftEdge(x[0], y[0], x[1], y[1])
+	};
+
+	for (int row = first_row; row <= last_row; row++)
+	{
+		double py = row + 0.5;
+		for (int column = column_begin; column <= column_end; column++)
+		{
+			double px = column + 0.5;
+			double w[3] = {
+				edgeFunction(x[1], y[1], x[2], y[2], px, py),
+				edgeFunction(x[2], y[2], x[0], y[0], px, py),
+				edgeFunction(x[0], y[0], x[1], y[1], px, py)
+			};
+
+			bool inside = true;
+			for (int e = 0; e < 3 && inside; e++)
+				inside = w[e] > 0.0 || (w[e] == 0.0 && top_left[e]);
+
+			if (!inside)
+				continue;
+
+			voxel_crossing crossing;
+			crossing.z = float((w[0] * z[0] + w[1] * z[1] + w[2] * z[2]) / (w[0] + w[1] + w[2]));
+			crossing.winding = winding;
+			columns[(row - row_begin) * dimensions[0] + column].push_back(crossing);
+		}
+	}
+}
+
+//marks the voxels of one column whose centers lie inside
+static void fillColumn(vector<voxel_crossing> &crossings, int column, int row, VOXEL_FILL fill, const int dimensions[3], voxel_slab &slab)
+{
+	std::sort(crossings.begin(), crossings.end());
+
+	int winding = 0;
+	for (int c = 0; c + 1 < (int)crossings.size(); c++)
+	{
+		winding += crossings[c].winding;
+
+		bool inside = fill == VOXEL_FILL_PARITY ? (c % 2) == 0 : winding != 0;
+		if (!inside)
+			continue;
+
+		//centers in (z_c, z_c+1]
+		int first = std::max(0, (int)floorf(crossings[c].z - 0.5f) + 1);
+		int last = std::min(dimensions[2] - 1, (int)floorf(crossings[c + 1].z - 0.5f));
+		for (int z = first; z <= last; z++)
+			slab.set(column, row, z);
+	}
+}
+
+const voxel_grid voxelizeTriangles(const vector<glm::vec3> &triangles, const voxel_options &options)
+{
+	voxel_grid grid;
+	int triangle_total = triangles.size() / 3;
+	if (triangle_total == 0 || options.resolution < 1)
+		return grid;
+
+	glm::vec3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX);
+	glm::vec3 bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int p = 0; p < triangle_total * 3; p++)
+	{
+		bounds_min = glm::min(bounds_min, triangles[p]);
+		bounds_max = glm::max(bounds_max, triangles[p]);
+	}
+
+	glm::vec3 size = bounds_max - bounds_min;
+	float extent = fmaxf(size.x, fmaxf(size.y, size.z));
+
+	grid.origin = bounds_min;
+	grid.voxel_size = extent > 0.0f ? extent / float(options.resolution) : 1.0f;
+	for (int axis = 0; axis < 3; axis++)
+		grid.dimensions[axis] = std::max(1, std::min(options.resolution, (int)ceilf(size[axis] / grid.voxel_size)));
+
+	vector<voxel_triangle> grid_triangles(triangle_total);
+	float scale = 1.0f / grid.voxel_size;
+
+	parallelFor(triangle_total, [&](int begin, int end) {
+		for (int t = begin; t < end; t++)
+		{
+			voxel_triangle &triangle = grid_triangles[t];
+			for (int c = 0; c < 3; c++)
+				triangle.v[c] = (triangles[t * 3 + c] - bounds_min) * scale;
+
+			triangle.edges[0] = triangle.v[1] - triangle.v[0];
+			triangle.edges[1] = triangle.v[2] - triangle.v[1];
+			triangle.edges[2] = triangle.v[0] - triangle.v[2];
+			triangle.normal = glm::cross(triangle.edges[0], triangle.edges[1]);
+		}
+	});
+
+	//bins triangles by the slabs their y range reaches
+	int slab_total = grid.getBrickDimension(1);
+	vector<int> slab_begin(slab_total + 1, 0);
+	vector<int> first_slab(triangle_total);
+	vector<int> last_slab(triangle_total);
+
+	for (int t = 0; t < triangle_total; t++)
+	{
+		const voxel_triangle &triangle = grid_triangles[t];
+		float low = fminf(triangle.v[0].y, fminf(triangle.v[1].y, triangle.v[2].y));
+		float high = fmaxf(triangle.v[0].y, fmaxf(triangle.v[1].y, triangle.v[2].y));
+		first_slab[t] = std::max(0, (int)floorf(low - voxel_epsilon)) / VOXEL_BRICK_SIZE;
+		last_slab[t] = std::min(grid.dimensions[1] - 1, (int)floorf(high + voxel_epsilon)) / VOXEL_BRICK_SIZE;
+
+		for (int s = first_slab[t]; s <= last_slab[t]; s++)
+			slab_begin[s + 1]++;
+	}
+
+	for (int s = 0; s < slab_total; s++)
+		slab_begin[s + 1] += slab_begin[s];
+
+	vector<int> slab_triangles(slab_begin[slab_total]);
+	vector<int> slab_fill(slab_begin.begin(), slab_begin.end() - 1);
+	for (int t = 0; t < triangle_total; t++)
+	{
+		for (int s = first_slab[t]; s <= last_slab[t]; s++)
+			slab_triangles[slab_fill[s]++] = t;
+	}
+
+	vector< vector<voxel_brick> > slab_bricks(slab_total);
+
+	parallelFor(slab_total, [&](int begin, int end) {
+		voxel_slab slab;
+		slab.bricks_x = grid.getBrickDimension(0);
+		slab.lookup.assign(slab.bricks_x * grid.getBrickDimension(2), -1);
+
+		vector< vector<voxel_crossing> > columns;
+		if (options.fill != VOXEL_SURFACE)
+			columns.resize(VOXEL_BRICK_SIZE * grid.dimensions[0]);
+
+		for (int s = begin; s < end; s++)
+		{
+			int row_begin = s * VOXEL_BRICK_SIZE;
+			int row_end = std::min(grid.dimensions[1], row_begin + VOXEL_BRICK_SIZE);
+			slab.brick_y = s;
+
+			for (int n = slab_begin[s]; n < slab_begin[s + 1]; n++)
+				voxelizeSurface(grid_triangles[slab_triangles[n]], row_begin, row_end, grid.dimensions, slab);
+
+			if (options.fill != VOXEL_SURFACE)
+			{
+				for (int n = slab_begin[s]; n < slab_begin[s + 1]; n++)
+					addCrossings(grid_triangles[slab_triangles[n]], row_begin, row_end, grid.dimensions, columns);
+
+				for (int row = row_begin; row < row_end; row++)
+				{
+					for (int column = 0; column < grid.dimensions[0]; column++)
+					{
+						vector<voxel_crossing> &crossings = columns[(row - row_begin) * grid.dimensions[0] + column];
+						if (crossings.size() > 1)
+							fillColumn(crossings, column, row, options.fill, grid.dimensions, slab);
+
+						crossings.clear();
+					}
+				}
+			}
+
+			//clears only the table entries this slab used
+			for (const auto &brick : slab.bricks)
+				slab.lookup[brick.z * slab.bricks_x + brick.x] = -1;
+
+			slab_bricks[s].swap(slab.bricks);
+			slab.bricks.clear();
+		}
+	}, 1);
+
+	size_t brick_total = 0;
+	for (const auto &bricks : slab_bricks)
+		brick_total += bricks.size();
+
+	grid.bricks.reserve(brick_total);
+	for (auto &bricks : slab_bricks)
+	{
+		grid.bricks.insert(grid.bricks.end(), bricks.begin(), bricks.end());
+		vector<voxel_brick>().swap(bricks);
+	}
+
+	std::sort(grid.bricks.begin(), grid.bricks.end(), brickBefore);
+	return grid;
+}
+
+const voxel_grid voxelizeMesh(const mesh_data &mesh, const voxel_options &options)
+{
+	return voxelizeTriangles(getTrianglePositions(mesh), options);
+}
@@ -0,0 +1,72 @@
+#ifndef MESH_VOXEL_H
+#define MESH_VOXEL_H
+
+#include "obj_parser.h"
+
+#include <stdint.h>
+
+enum VOXEL_FILL { VOXEL_SURFACE, VOXEL_FILL_PARITY, VOXEL_FILL_WINDING };
+
+//voxels per brick edge, a brick is 8x8x8 voxels held in 512 bits
+const int VOXEL_BRICK_SIZE = 8;
+
+struct voxel_options
+{
+	voxel_options() : resolution(128), fill(VOXEL_SURFACE) {};
+
+	//voxels along the longest side of the bounds, voxels are cubes so the other
+	//sides get fewer
+	int resolution;
+	//VOXEL_FILL_PARITY marks voxels whose center sees an odd number of surface crossings
+	//along +z, VOXEL_FILL_WINDING those with a nonzero winding number, which also holds
+	//for self-intersecting or nested shells as long as they are consistently wound
+	VOXEL_FILL fill;
+};
+
+struct voxel_brick
+{
+	//brick coordinates, voxel (x, y, z) lives in brick (x / 8, y / 8, z / 8)
+	int x, y, z;
+	//word is the local z, bit the local y * 8 + local x
+	uint64_t bits[VOXEL_BRICK_SIZE];
+};
+
+//sparse occupancy, only bricks with a set voxel are stored
+class voxel_grid
+{
+public:
+	voxel_grid() : origin(0.0f, 0.0f, 0.0f), voxel_size(0.0f)
+	{
+		dimensions[0] = dimensions[1] = dimensions[2] = 0;
+	};
+
+	const glm::vec3 getOrigin() const { return origin; }
+	const float getVoxelSize() const { return voxel_size; }
+	const int getDimension(int axis) const { return dimensions[axis]; }
+	const int getBrickDimension(int axis) const { return (dimensions[axis] + VOXEL_BRICK_SIZE - 1) / VOXEL_BRICK_SIZE; }
+
+	//ordered by brick z, then y, then x
+	const vector<voxel_brick>& getBricks() const { return bricks; }
+	const bool isSet(int x, int y, int z) const;
+	const unsigned long long getVoxelCount() const;
+
+	//lower corner of voxel (x, y, z) in mesh space
+	const glm::vec3 getVoxelPosition(int x, int y, int z) const { return origin + glm::vec3(float(x), float(y), float(z)) * voxel_size; }
+
+private:
+	friend const voxel_grid voxelizeTriangles(const vector<glm::vec3> &triangles, const voxel_options &options);
+
+	glm::vec3 origin;
+	float voxel_size;
+	int dimensions[3];
+	vector<voxel_brick> bricks;
+};
+
+//conservative surface voxelization, every voxel a triangle touches is set, decided by
+//separating axis tests of the triangle against the voxel's box. work is split into
+//slabs one brick thick along y, each thread voxelizes the triangles binned to its
+//slabs and owns their bricks, so no voxel is written by two threads
+const voxel_grid voxelizeTriangles(const vector<glm::vec3> &triangles, const voxel_options &options = voxel_options());
+const voxel_grid voxelizeMesh(const mesh_data &mesh, const voxel_options &options = voxel_options());
+
+#endif
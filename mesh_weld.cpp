@@ -0,0 +1,141 @@
+#include "mesh_weld.h"
+
+#include <stdint.h>
+
+//cell coordinates are hashed into a power of two table, collisions only add candidates
+static uint64_t hashCell(int64_t x, int64_t y, int64_t z)
+{
+	uint64_t h = (uint64_t)x * 73856093ull;
+	h ^= (uint64_t)y * 19349663ull;
+	h ^= (uint64_t)z * 83492791ull;
+	h ^= h >> 29;
+	return h * 0x9e3779b97f4a7c15ull;
+}
+
+static bool withinTolerance(const float* a, const float* b, const vertex_layout &layout, const weld_tolerance &tolerance)
+{
+	float distance_squared = 0.0f;
+	for (int i = 0; i < layout.v_size && i < 3; i++)
+	{
+		float difference = a[layout.v_offset + i] - b[layout.v_offset + i];
+		distance_squared += difference * difference;
+	}
+
+	if (distance_squared > tolerance.position * tolerance.position)
+		return false;
+
+	if (tolerance.uv >= 0.0f)
+	{
+		for (int i = 0; i < layout.vt_size; i++)
+		{
+			if (abs(a[layout.vt_offset + i] - b[layout.vt_offset + i]) > tolerance.uv)
+				return false;
+		}
+	}
+
+	if (tolerance.normal >= 0.0f && layout.vn_size > 0)
+	{
+		float normal_distance_squared = 0.0f;
+		for (int i = 0; i < layout.vn_size; i++)
+		{
+			float difference = a[layout.vn_offset + i] - b[layout.vn_offset + i];
+			normal_distance_squared += difference * difference;
+		}
+
+		if (normal_distance_squared > tolerance.normal * tolerance.normal)
+			return false;
+	}
+
+	return true;
+}
+
+const weld_result weldVertices(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, const weld_tolerance &tolerance)
+{
+	weld_result result;
+	result.welded_vertex_count = 0;
+
+	if (layout.stride <= 0 || layout.v_size < 3)
+		return result;
+
+	int vertex_total = vertices.size() / layout.stride;
+
+	//a zero tolerance still needs a finite cell, exact duplicates share a cell regardless
+	float cell_size = tolerance.position > 1e-6f ? tolerance.position : 1e-6f;
+	float inverse_cell_size = 1.0f / cell_size;
+
+	int bucket_total = 1;
+	while (bucket_total < vertex_total * 2)
+		bucket_total <<= 1;
+
+	//bucket heads and per-vertex links form the grid, only representatives are inserted
+	vector<int> bucket_heads(bucket_total, -1);
+	vector<int> next_in_bucket(vertex_total, -1);
+	vector<int> representatives;
+	representatives.reserve(vertex_total);
+
+	result.remap.resize(vertex_total);
+
+	for (int i = 0; i < vertex_total; i++)
+	{
+		const float* vertex = &vertices[i * layout.stride];
+		int64_t cell_x = (int64_t)floor(vertex[layout.v_offset] * inverse_cell_size);
+		int64_t cell_y = (int64_t)floor(vertex[layout.v_offset + 1] * inverse_cell_size);
+		int64_t cell_z = (int64_t)floor(vertex[layout.v_offset + 2] * inverse_cell_size);
+
+		//anything within the position tolerance lies in this cell or one of its neighbors
+		int match = -1;
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					uint64_t bucket = hashCell(cell_x + dx, cell_y + dy, cell_z + dz) & (bucket_total - 1);
+					for (int candidate = bucket_heads[bucket]; candidate >= 0; candidate = next_in_bucket[candidate])
+					{
+						if (withinTolerance(vertex, &vertices[candidate * layout.stride], layout, tolerance))
+						{
+							//earliest representative wins so the result does not depend on cell order
+							if (match < 0 || candidate < match)
+								match = candidate;
+						}
+					}
+				}
+			}
+		}
+
+		if (match >= 0)
+		{
+			result.remap[i] = result.remap[match];
+			continue;
+		}
+
+		result.remap[i] = representatives.size();
+		representatives.push_back(i);
+
+		uint64_t bucket = hashCell(cell_x, cell_y, cell_z) & (bucket_total - 1);
+		next_in_bucket[i] = bucket_heads[bucket];
+		bucket_heads[bucket] = i;
+	}
+
+	result.welded_vertex_count = representatives.size();
+
+	result.vertices.reserve(representatives.size() * layout.stride);
+	for (auto representative : representatives)
+	{
+		vector<float>::const_iterator vertex = vertices.begin() + representative * layout.stride;
+		result.vertices.insert(result.vertices.end(), vertex, vertex + layout.stride);
+	}
+
+	result.indices.reserve(indices.size());
+	for (auto index : indices)
+		result.indices.push_back(result.remap[index]);
+
+	return result;
+}
+
+const weld_result weldMesh(const mesh_data &mesh, const weld_tolerance &tolerance)
+{
+	return weldVertices(mesh.getIndexedVertexData(), mesh.getIndexedVertexLayout(), mesh.getElementIndex(), tolerance);
+}
@@ -0,0 +1,37 @@
+#ifndef MESH_WELD_H
+#define MESH_WELD_H
+
+#include "obj_parser.h"
+
+struct weld_tolerance
+{
+	weld_tolerance() : position(0.0001f), normal(0.01f), uv(0.0001f) {};
+
+	//maximum distance between welded positions
+	float position;
+	//maximum distance between welded unit normals, negative ignores normals
+	float normal;
+	//maximum difference of each uv component, negative ignores uvs
+	float uv;
+};
+
+struct weld_result
+{
+	//for each vertex of the source buffer, the index of the vertex it was welded into
+	vector<unsigned short> remap;
+	//source index buffer rewritten through remap
+	vector<unsigned short> indices;
+	//surviving vertices, in the same layout as the source buffer
+	vector<float> vertices;
+	int welded_vertex_count;
+};
+
+//merges vertices whose attributes are all within tolerance of an earlier vertex.
+//candidates come from a uniform hash grid with cells the size of the position
+//tolerance, so each vertex only compares against the 27 cells around it
+const weld_result weldVertices(const vector<float> &vertices, const vertex_layout &layout,
+	const vector<unsigned short> &indices, const weld_tolerance &tolerance);
+
+const weld_result weldMesh(const mesh_data &mesh, const weld_tolerance &tolerance);
+
+#endif
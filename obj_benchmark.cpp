@@ -0,0 +1,683 @@
+//benchmark driver for obj_parser, generates a deterministic synthetic obj corpus
+//and measures parse throughput, face deduplication and the mesh_data accessors
+//
+//built by the obj_benchmark target of CMakeLists.txt, or by hand alongside the library:
+//	g++ -O2 -std=c++17 -pthread -I<glm include dir> obj_parser.cpp obj_input.cpp obj_index.cpp mesh_bounds.cpp vertex_dedup.cpp obj_spill.cpp obj_trace.cpp obj_writer.cpp obj_benchmark.cpp -o obj_benchmark
+//add -DOBJ_PARSER_TRACE (cmake -DOBJ_PARSER_TRACE=ON) to record the zones --trace writes
+//
+//usage:
+//	obj_benchmark [--sizes 1M,16M,256M,4G] [--cases tri,quad,pos,uv,normal,full,small,giant]
+//		[--dir <corpus directory>] [--out results.json] [--baseline baseline.json]
+//		[--edge-limit <max faces per mesh for the edge benchmark>] [--keep]
+//		[--trace <chrome trace json>] [--trace-min-us <shortest zone kept>]
+
+#include "obj_parser.h"
+#include "obj_writer.h"
+#include "obj_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using std::chrono::steady_clock;
+
+enum CORPUS_CASE { CASE_TRIANGLES, CASE_QUADS, CASE_POSITION_ONLY, CASE_POSITION_UV, CASE_POSITION_NORMAL, CASE_FULL,
+	CASE_SMALL_GROUPS, CASE_GIANT_GROUP };
+
+struct corpus_case
+{
+	CORPUS_CASE id;
+	const char* name;
+	bool quads;
+	bool has_vt;
+	bool has_vn;
+	//number of grid cells along each side of a group, 0 means one group sized to the file
+	int cells_per_side;
+};
+
+static const corpus_case corpus_cases[] = {
+	{ CASE_TRIANGLES, "tri", false, true, true, 32 },
+	{ CASE_QUADS, "quad", true, true, true, 32 },
+	{ CASE_POSITION_ONLY, "pos", false, false, false, 32 },
+	//with tri and pos these cover each face format, "v", "v/vt", "v//vn" and "v/vt/vn"
+	{ CASE_POSITION_UV, "uv", false, true, false, 32 },
+	{ CASE_POSITION_NORMAL, "normal", false, false, true, 32 },
+	{ CASE_FULL, "full", true, true, true, 32 },
+	{ CASE_SMALL_GROUPS, "small", false, true, true, 3 },
+	{ CASE_GIANT_GROUP, "giant", false, true, true, 0 }
+};
+
+struct benchmark_result
+{
+	string case_name;
+	unsigned long long file_size;
+	double parse_seconds;
+	double parse_mb_per_second;
+	//face vertices per second of PHASE_FACE_ASSEMBLY time, 0 when built without stats
+	double assembly_vertices_per_second;
+	int mesh_count;
+	int face_count;
+	long long total_vertices;
+	//from load_stats, 0 when built without stats
+	long long unique_vertices;
+	double dedup_ratio;
+	double add_face_vertices_per_second;
+	double add_faces_vertices_per_second;
+	double edges_seconds;
+	int edges_meshes_skipped;
+	double interleave_seconds;
+	double indexed_seconds;
+	double write_mb_per_second;
+	double spill_parse_mb_per_second;
+	unsigned long long mesh_bytes;
+	unsigned long long compacted_mesh_bytes;
+	//peak of this case alone on linux, of the whole run so far elsewhere
+	long long peak_rss_kb;
+};
+
+//xorshift generator, keeps the corpus identical across platforms and runs
+class corpus_random
+{
+public:
+	corpus_random(unsigned int seed) : state(seed ? seed : 0x9e3779b9u) {};
+
+	unsigned int next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	//returns a float in [-1, 1]
+	float nextFloat() { return (float(next() & 0xffffff) / float(0xffffff)) * 2.0f - 1.0f; }
+
+private:
+	unsigned int state;
+};
+
+class corpus_writer
+{
+public:
+	corpus_writer(FILE* f) : file(f), bytes_written(0), v_offset(0), vt_offset(0), vn_offset(0), group_counter(0) {};
+
+	//writes one grid shaped group of cells x cells quads, split into triangles unless quads is set
+	void writeGroup(const corpus_case &c, int cells, corpus_random &rng);
+	unsigned long long getBytesWritten() const { return bytes_written; }
+
+private:
+	void write(const char* s, int length);
+
+	FILE* file;
+	unsigned long long bytes_written;
+	int v_offset;
+	int vt_offset;
+	int vn_offset;
+	int group_counter;
+};
+
+void corpus_writer::write(const char* s, int length)
+{
+	fwrite(s, 1, length, file);
+	bytes_written += length;
+}
+
+void corpus_writer::writeGroup(const corpus_case &c, int cells, corpus_random &rng)
+{
+	char line[256];
+	int length;
+	int side = cells + 1;
+	float origin_x = float(group_counter % 64) * 2.0f;
+	float origin_z = float(group_counter / 64) * 2.0f;
+
+	for (int row = 0; row < side; row++)
+	{
+		for (int col = 0; col < side; col++)
+		{
+			float x = origin_x + float(col) / float(cells);
+			float z = origin_z + float(row) / float(cells);
+			float y = rng.nextFloat() * 0.05f;
+			length = sprintf(line, "v %.6f %.6f %.6f\n", x, y, z);
+			write(line, length);
+		}
+	}
+
+	if (c.has_vt)
+	{
+		for (int row = 0; row < side; row++)
+		{
+			for (int col = 0; col < side; col++)
+			{
+				length = sprintf(line, "vt %.6f %.6f\n", float(col) / float(cells), float(row) / float(cells));
+				write(line, length);
+			}
+		}
+	}
+
+	if (c.has_vn)
+	{
+		for (int i = 0; i < side * side; i++)
+		{
+			glm::vec3 n(rng.nextFloat() * 0.1f, 1.0f, rng.nextFloat() * 0.1f);
+			n = glm::normalize(n);
+			length = sprintf(line, "vn %.6f %.6f %.6f\n", n.x, n.y, n.z);
+			write(line, length);
+		}
+	}
+
+	length = sprintf(line, "g group_%d\nusemtl material_%d\n", group_counter, group_counter % 8);
+	write(line, length);
+
+	for (int row = 0; row < cells; row++)
+	{
+		for (int col = 0; col < cells; col++)
+		{
+			int corners[4] = {
+				row * side + col,
+				row * side + col + 1,
+				(row + 1) * side + col + 1,
+				(row + 1) * side + col
+			};
+
+			std::ostringstream face;
+			vector< vector<int> > polygons;
+
+			//quad-heavy corpus still carries some triangles, as real exports do
+			if (c.quads && (rng.next() % 8) != 0)
+				polygons.push_back(vector<int> { corners[0], corners[1], corners[2], corners[3] });
+
+			else
+			{
+				polygons.push_back(vector<int> { corners[0], corners[1], corners[2] });
+				polygons.push_back(vector<int> { corners[0], corners[2], corners[3] });
+			}
+
+			for (auto polygon : polygons)
+			{
+				face << "f";
+				for (auto corner : polygon)
+				{
+					face << " " << v_offset + corner + 1;
+					if (c.has_vt)
+						face << "/" << vt_offset + corner + 1;
+					if (c.has_vn)
+						face << (c.has_vt ? "/" : "//") << vn_offset + corner + 1;
+				}
+				face << "\n";
+			}
+
+			string face_string = face.str();
+			write(face_string.c_str(), face_string.size());
+		}
+	}
+
+	v_offset += side * side;
+	if (c.has_vt)
+		vt_offset += side * side;
+	if (c.has_vn)
+		vn_offset += side * side;
+	group_counter++;
+}
+
+static bool generateCorpusFile(const corpus_case &c, unsigned long long target_size, const string &path, unsigned long long &file_size)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL)
+		return false;
+
+	corpus_random rng(1234u + (unsigned int)c.id);
+	corpus_writer writer(file);
+
+	fprintf(file, "mtllib benchmark.mtl\n");
+
+	if (c.cells_per_side == 0)
+	{
+		//measure the cost of one cell to size the single giant group
+		FILE* scratch = tmpfile();
+		corpus_writer sample(scratch);
+		corpus_random sample_rng(1u);
+		sample.writeGroup(c, 16, sample_rng);
+		fclose(scratch);
+
+		double bytes_per_cell = double(sample.getBytesWritten()) / (16.0 * 16.0);
+		int cells = std::max(1, int(sqrt(double(target_size) / bytes_per_cell)));
+		writer.writeGroup(c, cells, rng);
+	}
+
+	else
+	{
+		while (writer.getBytesWritten() < target_size)
+			writer.writeGroup(c, c.cells_per_side, rng);
+	}
+
+	//header line is written outside of the corpus writer
+	file_size = writer.getBytesWritten() + strlen("mtllib benchmark.mtl\n");
+	fclose(file);
+	return true;
+}
+
+//linux resets the peak resident set size (VmHWM) when 5 is written to clear_refs, other
+//platforms have no reset and report the peak of the whole process
+static void resetPeakResident()
+{
+#if defined(__linux__)
+	FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+	if (clear_refs != NULL)
+	{
+		fputs("5", clear_refs);
+		fclose(clear_refs);
+	}
+#endif
+}
+
+static long long peakResidentKB()
+{
+#if defined(__linux__)
+	//ru_maxrss ignores the clear_refs reset, VmHWM follows it
+	FILE* status = fopen("/proc/self/status", "r");
+	if (status != NULL)
+	{
+		char line[256];
+		long long peak = -1;
+		while (peak < 0 && fgets(line, sizeof(line), status) != NULL)
+		{
+			if (strncmp(line, "VmHWM:", 6) == 0)
+				peak = atoll(line + 6);
+		}
+		fclose(status);
+
+		if (peak >= 0)
+			return peak;
+	}
+#endif
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return (long long)(counters.PeakWorkingSetSize / 1024);
+	return 0;
+#elif defined(__APPLE__)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (long long)(usage.ru_maxrss / 1024);
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (long long)usage.ru_maxrss;
+#endif
+}
+
+static double secondsSince(steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(steady_clock::now() - start).count();
+}
+
+//meshes above this face count are skipped by the edge benchmark, getMeshEdgesVec4 is quadratic
+static int max_edge_benchmark_faces = 2048;
+
+static benchmark_result runCase(const corpus_case &c, unsigned long long file_size, const string &path)
+{
+	benchmark_result result;
+	result.case_name = c.name;
+	result.file_size = file_size;
+	resetPeakResident();
+
+	steady_clock::time_point start = steady_clock::now();
+	obj_contents contents(path.c_str());
+	result.parse_seconds = secondsSince(start);
+	result.parse_mb_per_second = (double(result.file_size) / (1024.0 * 1024.0)) / result.parse_seconds;
+
+	load_stats stats = contents.getLoadStats();
+	double assembly_seconds = stats.phase_seconds[PHASE_FACE_ASSEMBLY];
+	result.assembly_vertices_per_second = assembly_seconds > 0.0 ? double(stats.total_vertices) / assembly_seconds : 0.0;
+
+	vector<mesh_data> meshes = contents.getMeshes();
+	result.mesh_count = meshes.size();
+	result.face_count = 0;
+	result.total_vertices = 0;
+	result.unique_vertices = stats.unique_vertices;
+
+	for (const auto &mesh : meshes)
+	{
+		result.face_count += mesh.getFaceCount();
+		result.total_vertices += mesh.getVertexCount();
+	}
+
+	result.dedup_ratio = result.total_vertices > 0 ? double(result.unique_vertices) / double(result.total_vertices) : 0.0;
+
+	//replays the faces of the loaded meshes through addFace to isolate indexing cost from parsing,
+	//then through the batched addFaces to compare the serial and concurrent indexing paths
+	vector< vector< vector<vertex_data> > > replay_faces(meshes.size());
+	long long replayed_vertices = 0;
+	for (int i = 0; i < (int)meshes.size(); i++)
+	{
+		vector< vector<glm::vec4> > triangles = meshes[i].getMeshTrianglesVec4();
+		for (const auto &triangle : triangles)
+		{
+			vector<vertex_data> face;
+			for (const auto &position : triangle)
+				face.push_back(vertex_data(vector<float> { position.x, position.y, position.z }, vector<float>(), vector<float>()));
+
+			replay_faces[i].push_back(face);
+			replayed_vertices += 3;
+		}
+	}
+
+	start = steady_clock::now();
+	for (const auto &faces : replay_faces)
+	{
+		mesh_data replay;
+		for (const auto &face : faces)
+			replay.addFace(face);
+	}
+	double replay_seconds = secondsSince(start);
+	result.add_face_vertices_per_second = replay_seconds > 0.0 ? double(replayed_vertices) / replay_seconds : 0.0;
+
+	start = steady_clock::now();
+	for (const auto &faces : replay_faces)
+	{
+		mesh_data replay;
+		replay.addFaces(faces);
+	}
+	replay_seconds = secondsSince(start);
+	result.add_faces_vertices_per_second = replay_seconds > 0.0 ? double(replayed_vertices) / replay_seconds : 0.0;
+
+	result.edges_meshes_skipped = 0;
+	start = steady_clock::now();
+	for (const auto &mesh : meshes)
+	{
+		if (mesh.getFaceCount() > max_edge_benchmark_faces)
+		{
+			result.edges_meshes_skipped++;
+			continue;
+		}
+		mesh.getMeshEdgesVec4();
+	}
+	result.edges_seconds = secondsSince(start);
+
+	start = steady_clock::now();
+	for (const auto &mesh : meshes)
+		mesh.getInterleaveData();
+	result.interleave_seconds = secondsSince(start);
+
+	start = steady_clock::now();
+	for (const auto &mesh : meshes)
+		mesh.getIndexedVertexData();
+	result.indexed_seconds = secondsSince(start);
+
+	//writes the loaded meshes back out, the output is usually a little smaller than the input
+	string written_path = path + ".written.obj";
+	string write_error;
+	start = steady_clock::now();
+	bool written = writeOBJ(written_path.c_str(), meshes, contents.getMTLFilename(), write_error);
+	double write_seconds = secondsSince(start);
+	FILE* written_file = written ? fopen(written_path.c_str(), "rb") : NULL;
+	long written_size = 0;
+	if (written_file != NULL)
+	{
+		fseek(written_file, 0, SEEK_END);
+		written_size = ftell(written_file);
+		fclose(written_file);
+	}
+	remove(written_path.c_str());
+	result.write_mb_per_second = write_seconds > 0.0 ? (double(written_size) / (1024.0 * 1024.0)) / write_seconds : 0.0;
+
+	//footprint of all representations, then of just what an indexed renderer uploads
+	result.mesh_bytes = 0;
+	result.compacted_mesh_bytes = 0;
+	for (auto &mesh : meshes)
+	{
+		result.mesh_bytes += mesh.memoryUsage().getTotal();
+		mesh.compact(MESH_INDEXED);
+		result.compacted_mesh_bytes += mesh.memoryUsage().getTotal();
+	}
+
+	//out-of-core parse of the same file, raw attributes and meshes in mapped temp files
+	start = steady_clock::now();
+	{
+		obj_contents spilled_contents(path.c_str(), spill_options());
+	}
+	double spill_seconds = secondsSince(start);
+	result.spill_parse_mb_per_second = (double(result.file_size) / (1024.0 * 1024.0)) / spill_seconds;
+
+	result.peak_rss_kb = peakResidentKB();
+
+	return result;
+}
+
+static string resultToJSON(const benchmark_result &r)
+{
+	char buffer[1024];
+	sprintf(buffer,
+		"{\"case\": \"%s\", \"size\": %llu, \"parse_seconds\": %.6f, \"parse_mb_s\": %.3f, \"assembly_vertices_s\": %.1f, "
+		"\"meshes\": %d, \"faces\": %d, \"total_vertices\": %lld, \"unique_vertices\": %lld, "
+		"\"dedup_ratio\": %.6f, \"add_face_vertices_s\": %.1f, \"add_faces_vertices_s\": %.1f, \"edges_seconds\": %.6f, "
+		"\"edges_meshes_skipped\": %d, \"interleave_seconds\": %.6f, \"indexed_seconds\": %.6f, \"write_mb_s\": %.3f, "
+		"\"spill_parse_mb_s\": %.3f, \"mesh_bytes\": %llu, \"compacted_mesh_bytes\": %llu, \"peak_rss_kb\": %lld}",
+		r.case_name.c_str(), r.file_size, r.parse_seconds, r.parse_mb_per_second, r.assembly_vertices_per_second,
+		r.mesh_count, r.face_count, r.total_vertices, r.unique_vertices,
+		r.dedup_ratio, r.add_face_vertices_per_second, r.add_faces_vertices_per_second, r.edges_seconds,
+		r.edges_meshes_skipped, r.interleave_seconds, r.indexed_seconds, r.write_mb_per_second,
+		r.spill_parse_mb_per_second, r.mesh_bytes, r.compacted_mesh_bytes, r.peak_rss_kb);
+
+	return string(buffer);
+}
+
+//results files hold one record per line, so a baseline can be read back without a json library
+static double extractJSONNumber(const string &record, const string &key)
+{
+	string quoted_key = "\"" + key + "\": ";
+	size_t position = record.find(quoted_key);
+	if (position == string::npos)
+		return 0.0;
+
+	return atof(record.c_str() + position + quoted_key.size());
+}
+
+static string extractJSONString(const string &record, const string &key)
+{
+	string quoted_key = "\"" + key + "\": \"";
+	size_t position = record.find(quoted_key);
+	if (position == string::npos)
+		return "";
+
+	size_t begin = position + quoted_key.size();
+	return record.substr(begin, record.find('"', begin) - begin);
+}
+
+static void compareWithBaseline(const vector<string> &records, const char* baseline_path)
+{
+	fstream file;
+	file.open(baseline_path, std::ifstream::in);
+
+	if (!file.is_open())
+	{
+		std::cout << "unable to open baseline file: " << baseline_path << std::endl;
+		return;
+	}
+
+	vector<string> baseline_records;
+	while (!file.eof())
+	{
+		string line;
+		std::getline(file, line, '\n');
+		if (line.find("\"case\"") != string::npos)
+			baseline_records.push_back(line);
+	}
+	file.close();
+
+	//higher is better for throughput, lower is better for timings and memory
+	const char* metrics[] = { "parse_mb_s", "assembly_vertices_s", "add_face_vertices_s", "add_faces_vertices_s", "edges_seconds", "interleave_seconds", "indexed_seconds", "write_mb_s", "spill_parse_mb_s", "mesh_bytes", "peak_rss_kb" };
+
+	for (const auto &record : records)
+	{
+		string case_name = extractJSONString(record, "case");
+		double size = extractJSONNumber(record, "size");
+
+		for (const auto &baseline : baseline_records)
+		{
+			if (extractJSONString(baseline, "case") != case_name)
+				continue;
+
+			//sizes are generated to a target, compare records within 10% of each other
+			double baseline_size = extractJSONNumber(baseline, "size");
+			if (baseline_size <= 0.0 || fabs(size - baseline_size) / baseline_size > 0.1)
+				continue;
+
+			std::cout << case_name << " (" << (unsigned long long)size << " bytes) vs baseline:" << std::endl;
+			for (const auto metric : metrics)
+			{
+				double current_value = extractJSONNumber(record, metric);
+				double baseline_value = extractJSONNumber(baseline, metric);
+				double change = baseline_value != 0.0 ? (current_value - baseline_value) / baseline_value * 100.0 : 0.0;
+				printf("\t%-22s %14.3f %14.3f %+8.1f%%\n", metric, baseline_value, current_value, change);
+			}
+			break;
+		}
+	}
+}
+
+static unsigned long long parseSize(const string &s)
+{
+	double value = atof(s.c_str());
+	char suffix = s.empty() ? '\0' : s[s.size() - 1];
+
+	switch (suffix)
+	{
+	case 'k': case 'K': value *= 1024.0; break;
+	case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+	case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+	default: break;
+	}
+
+	return (unsigned long long)value;
+}
+
+static vector<string> splitList(const string &s)
+{
+	vector<string> items;
+	std::stringstream stream(s);
+	string item;
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty())
+			items.push_back(item);
+	}
+	return items;
+}
+
+int main(int argc, char** argv)
+{
+	vector<string> sizes = { "1M" };
+	vector<string> case_names;
+	string corpus_dir = ".";
+	string out_path = "obj_benchmark_results.json";
+	const char* baseline_path = NULL;
+	bool keep_corpus = false;
+	const char* trace_path = NULL;
+	double trace_min_microseconds = 0.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--sizes" && has_value)
+			sizes = splitList(argv[++i]);
+		else if (arg == "--cases" && has_value)
+			case_names = splitList(argv[++i]);
+		else if (arg == "--dir" && has_value)
+			corpus_dir = argv[++i];
+		else if (arg == "--out" && has_value)
+			out_path = argv[++i];
+		else if (arg == "--baseline" && has_value)
+			baseline_path = argv[++i];
+		else if (arg == "--edge-limit" && has_value)
+			max_edge_benchmark_faces = atoi(argv[++i]);
+		else if (arg == "--keep")
+			keep_corpus = true;
+		else if (arg == "--trace" && has_value)
+			trace_path = argv[++i];
+		else if (arg == "--trace-min-us" && has_value)
+			trace_min_microseconds = atof(argv[++i]);
+		else
+		{
+			std::cout << "unknown argument: " << arg << std::endl;
+			return 1;
+		}
+	}
+
+#ifndef OBJ_PARSER_TRACE
+	if (trace_path != NULL)
+		std::cout << "--trace has no zones to record unless built with OBJ_PARSER_TRACE" << std::endl;
+#endif
+
+	if (trace_path != NULL)
+		startTrace(trace_min_microseconds);
+
+	vector<string> records;
+
+	for (const auto &c : corpus_cases)
+	{
+		if (!case_names.empty() && std::find(case_names.begin(), case_names.end(), c.name) == case_names.end())
+			continue;
+
+		for (const auto &size_string : sizes)
+		{
+			unsigned long long target_size = parseSize(size_string);
+			string path = corpus_dir + "/bench_" + c.name + "_" + size_string + ".obj";
+
+			unsigned long long file_size = 0;
+			if (!generateCorpusFile(c, target_size, path, file_size))
+			{
+				std::cout << "unable to write corpus file: " << path << std::endl;
+				return 1;
+			}
+
+			benchmark_result result = runCase(c, file_size, path);
+			string record = resultToJSON(result);
+			std::cout << record << std::endl;
+			records.push_back(record);
+
+			if (!keep_corpus)
+				remove(path.c_str());
+		}
+	}
+
+	FILE* out = fopen(out_path.c_str(), "w");
+	if (out == NULL)
+	{
+		std::cout << "unable to write results file: " << out_path << std::endl;
+		return 1;
+	}
+
+	fprintf(out, "{\"results\": [\n");
+	for (size_t i = 0; i < records.size(); i++)
+		fprintf(out, "%s%s\n", records[i].c_str(), i + 1 < records.size() ? "," : "");
+	fprintf(out, "]}\n");
+	fclose(out);
+
+	if (trace_path != NULL)
+	{
+		stopTrace();
+
+		string trace_error;
+		if (!writeTrace(trace_path, trace_error))
+			std::cout << trace_error << std::endl;
+	}
+
+	if (baseline_path != NULL)
+		compareWithBaseline(records, baseline_path);
+
+	return 0;
+}
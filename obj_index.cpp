@@ -0,0 +1,453 @@
+#include "obj_index.h"
+#include "obj_input.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+//same prefix rules as getDataType, without building a string per line
+static DATA_TYPE indexLineType(const char* line_start, const char* line_end)
+{
+	const char* prefix_end = (const char*)memchr(line_start, ' ', line_end - line_start);
+	if (prefix_end == NULL)
+		prefix_end = line_end;
+
+	size_t length = prefix_end - line_start;
+
+	if (length == 1)
+	{
+		switch (line_start[0])
+		{
+		case 'v': return OBJ_V;
+		case 'f': return OBJ_F;
+		case 'g': return OBJ_G;
+		default: return UNDEFINED;
+		}
+	}
+
+	if (length == 2 && line_start[0] == 'v')
+	{
+		switch (line_start[1])
+		{
+		case 't': return OBJ_VT;
+		case 'n': return OBJ_VN;
+		case 'p': return OBJ_VP;
+		default: return UNDEFINED;
+		}
+	}
+
+	if (length == 6 && memcmp(line_start, "usemtl", 6) == 0)
+		return OBJ_USEMTL;
+
+	if (length == 6 && memcmp(line_start, "mtllib", 6) == 0)
+		return OBJ_MTLLIB;
+
+	return UNDEFINED;
+}
+
+//what build collects for one block while hashing content, folded into content_hash at the end
+struct block_hash_state
+{
+	block_hash_state() : hash(0xcbf29ce484222325ull), unresolved(false) {};
+
+	uint64_t hash;
+	//blocks holding attributes this block's faces reference outside its own
+	vector<int> owners;
+	//references past the attributes read so far, resolved once the whole file is indexed
+	vector< std::pair<DATA_TYPE, int> > forward;
+	//references to attributes the file does not have
+	bool unresolved;
+};
+
+//fnv-1a
+static uint64_t hashBytes(uint64_t h, const char* start, const char* end)
+{
+	for (const char* c = start; c < end; c++)
+	{
+		h ^= (unsigned char)*c;
+		h *= 0x100000001b3ull;
+	}
+
+	return h;
+}
+
+static uint64_t hashCombine(uint64_t h, uint64_t value)
+{
+	h ^= value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	return h;
+}
+
+static void addOwner(block_hash_state &state, int owner)
+{
+	if (owner < 0)
+		state.unresolved = true;
+
+	else if (state.owners.empty() || state.owners.back() != owner)
+		state.owners.push_back(owner);
+}
+
+//digit runs of a face line are indices, the slot a run fills is the number of '/' since the
+//last space, as extractFaceSequence reads them. everything else is hashed as it is
+static void hashFaceLine(const obj_group_index &index, const obj_group_range &range, const int counters[4],
+	const char* line_start, const char* line_end, block_hash_state &state)
+{
+	int slot = 0;
+	const char* c = line_start;
+
+	while (c < line_end)
+	{
+		if (*c < '0' || *c > '9')
+		{
+			if (*c == ' ')
+				slot = 0;
+
+			else if (*c == '/')
+				slot++;
+
+			state.hash = hashBytes(state.hash, c, c + 1);
+			c++;
+			continue;
+		}
+
+		int value = 0;
+		for (; c < line_end && *c >= '0' && *c <= '9'; c++)
+			value = value * 10 + (*c - '0');
+
+		if (slot >= FACE_SLOT_COUNT || value == 0)
+		{
+			state.hash = hashCombine(hashCombine(state.hash, 0), value);
+			continue;
+		}
+
+		DATA_TYPE type = face_slot_types[slot];
+		int start = type == OBJ_V ? range.v_start : (type == OBJ_VT ? range.vt_start : range.vn_start);
+		int next = type == OBJ_V ? counters[0] : (type == OBJ_VT ? counters[1] : counters[2]);
+
+		if (value >= start && value < next)
+		{
+			state.hash = hashCombine(hashCombine(state.hash, 1), value - start);
+			continue;
+		}
+
+		//anything outside the block keeps its file-wide number, so a shift changes the hash
+		state.hash = hashCombine(hashCombine(state.hash, 2), value);
+
+		if (value < start)
+			addOwner(state, index.findAttributeGroup(type, value));
+
+		else state.forward.push_back(std::make_pair(type, value));
+	}
+}
+
+const unsigned long long fileSize(const char* file_path)
+{
+	FILE* file = fopen(file_path, "rb");
+	if (file == NULL)
+		return 0;
+
+#ifdef _WIN32
+	_fseeki64(file, 0, SEEK_END);
+	unsigned long long size = _ftelli64(file);
+#else
+	fseeko(file, 0, SEEK_END);
+	unsigned long long size = ftello(file);
+#endif
+
+	fclose(file);
+	return size;
+}
+
+const long long fileModifiedTime(const char* file_path)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(file_path, &info) != 0)
+		return 0;
+
+	return (long long)info.st_mtime * 1000000000ll;
+#else
+	struct stat info;
+	if (stat(file_path, &info) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	return (long long)info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#else
+	return (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#endif
+#endif
+}
+
+bool obj_group_index::build(const char* obj_file, bool hash_content)
+{
+	groups.clear();
+	mtl_filename.clear();
+	error_log.clear();
+
+	string error;
+	std::unique_ptr<input_source> source(openInputSource(obj_file, error));
+	if (!source)
+	{
+		error_log.push_back(error);
+		return false;
+	}
+
+	//taken before reading, so an edit made while indexing makes the sidecar stale
+	file_bytes = fileSize(obj_file);
+	file_time = fileModifiedTime(obj_file);
+
+	groups.push_back(obj_group_range());
+	obj_group_range* current = &groups.back();
+	vector<block_hash_state> hash_states(1);
+
+	string current_material;
+	bool end_of_vertex_data = false;
+	int counters[4] = { 1, 1, 1, 1 };
+
+	vector<char> buffer(1 << 16);
+	string partial_line;
+	unsigned long long offset = 0;
+
+	for (bool input_finished = false; !input_finished;)
+	{
+		size_t bytes_read = source->read(&buffer[0], buffer.size());
+		input_finished = bytes_read == 0;
+
+		const char* data = &buffer[0];
+		const char* data_end = data + bytes_read;
+		const char* line_start = data;
+
+		//a line split across reads is completed in partial_line first
+		while (line_start < data_end || (input_finished && !partial_line.empty()))
+		{
+			const char* line_end = input_finished ? data_end : (const char*)memchr(line_start, '\n', data_end - line_start);
+			if (line_end == NULL)
+				break;
+
+			unsigned long long line_offset = offset + (line_start - data) - partial_line.size();
+			const char* scan_start = line_start;
+			const char* scan_end = line_end;
+			if (!partial_line.empty())
+			{
+				partial_line.append(line_start, line_end);
+				scan_start = partial_line.data();
+				scan_end = partial_line.data() + partial_line.size();
+			}
+
+			scan_end = trimCarriageReturn(scan_start, scan_end);
+			DATA_TYPE type = indexLineType(scan_start, scan_end);
+
+			//mirrors obj_contents::processLine, which starts a mesh on the first "v" after a "g"
+			if (type == OBJ_V && end_of_vertex_data)
+			{
+				current->end = line_offset;
+
+				groups.push_back(obj_group_range());
+				current = &groups.back();
+				current->begin = line_offset;
+				current->material = current_material;
+				current->v_start = counters[0];
+				current->vt_start = counters[1];
+				current->vn_start = counters[2];
+				current->vp_start = counters[3];
+				end_of_vertex_data = false;
+
+				if (hash_content)
+					hash_states.push_back(block_hash_state());
+			}
+
+			//lines obj_contents ignores are left out, so comments can change freely
+			if (hash_content && type != UNDEFINED)
+			{
+				block_hash_state &state = hash_states.back();
+				if (type == OBJ_F)
+					hashFaceLine(*this, *current, counters, scan_start, scan_end, state);
+				else
+					state.hash = hashBytes(state.hash, scan_start, scan_end);
+
+				state.hash = hashCombine(state.hash, '\n');
+			}
+
+			switch (type)
+			{
+			case OBJ_V: counters[0]++; current->v_count++; break;
+			case OBJ_VT: counters[1]++; current->vt_count++; break;
+			case OBJ_VN: counters[2]++; current->vn_count++; break;
+			case OBJ_VP: counters[3]++; current->vp_count++; break;
+			case OBJ_G:
+				current->name = extractName(string(scan_start, scan_end));
+				end_of_vertex_data = true;
+				break;
+			case OBJ_USEMTL:
+				current_material = extractName(string(scan_start, scan_end));
+				break;
+			case OBJ_MTLLIB:
+				mtl_filename = extractName(string(scan_start, scan_end));
+				break;
+			default: break;
+			}
+
+			partial_line.clear();
+			line_start = line_end < data_end ? line_end + 1 : data_end;
+		}
+
+		partial_line.append(line_start, data_end);
+		offset += bytes_read;
+	}
+
+	current->end = offset;
+	source_bytes = offset;
+
+	//a block's final hash also covers its starting material, and the content and starts
+	//of every block its faces take attributes from
+	for (int i = 0; hash_content && i < (int)groups.size(); i++)
+	{
+		block_hash_state &state = hash_states[i];
+		for (const auto &reference : state.forward)
+			addOwner(state, findAttributeGroup(reference.first, reference.second));
+
+		std::sort(state.owners.begin(), state.owners.end());
+		state.owners.erase(std::unique(state.owners.begin(), state.owners.end()), state.owners.end());
+
+		obj_group_range &group = groups[i];
+		uint64_t h = hashCombine(state.hash, hashBytes(0xcbf29ce484222325ull, group.material.data(), group.material.data() + group.material.size()));
+
+		for (auto owner : state.owners)
+		{
+			const obj_group_range &source = groups[owner];
+			h = hashCombine(h, hash_states[owner].hash);
+			h = hashCombine(h, source.v_start);
+			h = hashCombine(h, source.vt_start);
+			h = hashCombine(h, source.vn_start);
+		}
+
+		if (state.unresolved)
+		{
+			for (int n = 0; n < 4; n++)
+				h = hashCombine(h, counters[n]);
+		}
+
+		group.content_hash = h;
+	}
+
+	vector<string> source_errors = source->getErrors();
+	error_log.insert(error_log.end(), source_errors.begin(), source_errors.end());
+	return source_errors.empty();
+}
+
+bool obj_group_index::save(const char* index_file) const
+{
+	std::ofstream file(index_file, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	//names may hold spaces, so each sits alone on its own line after the numbers
+	file << "obj_group_index 2\n";
+	file << file_bytes << " " << file_time << " " << source_bytes << " " << groups.size() << "\n";
+	file << mtl_filename << "\n";
+
+	for (const auto &group : groups)
+	{
+		file << group.begin << " " << group.end << " "
+			<< group.v_start << " " << group.vt_start << " " << group.vn_start << " " << group.vp_start << " "
+			<< group.v_count << " " << group.vt_count << " " << group.vn_count << " " << group.vp_count << "\n";
+		file << group.name << "\n";
+		file << group.material << "\n";
+	}
+
+	return file.good();
+}
+
+bool obj_group_index::load(const char* index_file, const char* obj_file)
+{
+	std::ifstream file(index_file, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	string header;
+	std::getline(file, header);
+	if (header != "obj_group_index 2")
+		return false;
+
+	unsigned long long stored_file_bytes = 0;
+	long long stored_file_time = 0;
+	unsigned long long stored_source_bytes = 0;
+	int group_total = 0;
+	file >> stored_file_bytes >> stored_file_time >> stored_source_bytes >> group_total;
+	file.ignore(1);
+
+	//a same-size re-export is common, so the modification time has to match as well
+	if (!file.good() || stored_file_bytes != fileSize(obj_file) || stored_file_time != fileModifiedTime(obj_file))
+		return false;
+
+	string stored_mtl_filename;
+	std::getline(file, stored_mtl_filename);
+
+	vector<obj_group_range> stored_groups(group_total > 0 ? group_total : 0);
+	for (auto &group : stored_groups)
+	{
+		file >> group.begin >> group.end
+			>> group.v_start >> group.vt_start >> group.vn_start >> group.vp_start
+			>> group.v_count >> group.vt_count >> group.vn_count >> group.vp_count;
+		file.ignore(1);
+		std::getline(file, group.name);
+		std::getline(file, group.material);
+	}
+
+	if (file.fail())
+		return false;
+
+	groups.swap(stored_groups);
+	mtl_filename = stored_mtl_filename;
+	file_bytes = stored_file_bytes;
+	file_time = stored_file_time;
+	source_bytes = stored_source_bytes;
+	return true;
+}
+
+bool obj_group_index::open(const char* obj_file, const char* index_file)
+{
+	if (load(index_file, obj_file))
+		return true;
+
+	if (!build(obj_file))
+		return false;
+
+	if (!save(index_file))
+		error_log.push_back(string("unable to write group index: ") + index_file);
+
+	return true;
+}
+
+const int obj_group_index::findAttributeGroup(DATA_TYPE dt, int n) const
+{
+	//starts only grow from block to block, so the owner is found by binary search
+	int low = 0;
+	int high = groups.size() - 1;
+	while (low <= high)
+	{
+		int middle = (low + high) / 2;
+		const obj_group_range &group = groups[middle];
+
+		int start, count;
+		switch (dt)
+		{
+		case OBJ_V: start = group.v_start; count = group.v_count; break;
+		case OBJ_VT: start = group.vt_start; count = group.vt_count; break;
+		case OBJ_VN: start = group.vn_start; count = group.vn_count; break;
+		case OBJ_VP: start = group.vp_start; count = group.vp_count; break;
+		default: return -1;
+		}
+
+		if (n < start)
+			high = middle - 1;
+
+		else if (n >= start + count)
+			low = middle + 1;
+
+		else return middle;
+	}
+
+	return -1;
+}
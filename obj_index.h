@@ -0,0 +1,80 @@
+#ifndef OBJ_INDEX_H
+#define OBJ_INDEX_H
+
+#include "obj_parser.h"
+
+#include <stdint.h>
+
+//one mesh worth of the file, split the same way obj_contents splits meshes: a block
+//starts at the first "v" line after a "g" line and runs to the next such line
+struct obj_group_range
+{
+	obj_group_range() : begin(0), end(0), v_start(1), vt_start(1), vn_start(1), vp_start(1),
+		v_count(0), vt_count(0), vn_count(0), vp_count(0), content_hash(0) {};
+
+	string name;
+	//material in effect where the block starts, usemtl lines inside it still apply
+	string material;
+
+	//byte range in the decompressed stream
+	unsigned long long begin;
+	unsigned long long end;
+
+	//1-based index of the first attribute of each type in the block, and how many it has
+	int v_start;
+	int vt_start;
+	int vn_start;
+	int vp_start;
+	int v_count;
+	int vt_count;
+	int vn_count;
+	int vp_count;
+
+	//set by build when asked to hash content, 0 otherwise and not kept in the sidecar.
+	//face indices into the block's own attributes are hashed relative to its starts, so
+	//a block moved by edits before it keeps its hash as long as it parses the same
+	uint64_t content_hash;
+};
+
+//byte ranges and attribute counters of every group, so obj_contents can load a few
+//named groups without parsing the rest of the file. kept as a text sidecar next to
+//the obj, tied to it by the obj's size and modification time
+class obj_group_index
+{
+public:
+	obj_group_index() : file_bytes(0), file_time(0), source_bytes(0) {};
+	~obj_group_index(){};
+
+	//single prepass over the file, only mtllib, usemtl and g lines are tokenized,
+	//plus face lines when hash_content is set
+	bool build(const char* obj_file, bool hash_content = false);
+	bool save(const char* index_file) const;
+	//fails if the sidecar is missing, malformed or was built from a file of another size or time
+	bool load(const char* index_file, const char* obj_file);
+	//loads index_file if it is current, otherwise builds the index and rewrites index_file
+	bool open(const char* obj_file, const char* index_file);
+
+	const vector<obj_group_range> getGroups() const { return groups; }
+	const int getGroupCount() const { return groups.size(); }
+	const obj_group_range& getGroup(int n) const { return groups[n]; }
+	const string getMTLFilename() const { return mtl_filename; }
+	vector<string> getErrors() const { return error_log; }
+
+	//block holding the 1-based attribute index n of type dt, -1 if there is none
+	const int findAttributeGroup(DATA_TYPE dt, int n) const;
+
+private:
+	vector<obj_group_range> groups;
+	string mtl_filename;
+	unsigned long long file_bytes;
+	long long file_time;
+	unsigned long long source_bytes;
+	vector<string> error_log;
+};
+
+const unsigned long long fileSize(const char* file_path);
+//last modification time in nanoseconds since the epoch, 0 if the file cannot be read.
+//windows only reports whole seconds
+const long long fileModifiedTime(const char* file_path);
+
+#endif
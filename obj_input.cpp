@@ -0,0 +1,305 @@
+#include "obj_input.h"
+
+#include <string.h>
+
+bool input_source::skip(unsigned long long size)
+{
+	char discard[1 << 14];
+	while (size > 0)
+	{
+		size_t request = size > sizeof(discard) ? sizeof(discard) : (size_t)size;
+		size_t bytes_read = read(discard, request);
+		if (bytes_read == 0)
+			return false;
+
+		size -= bytes_read;
+	}
+
+	return true;
+}
+
+file_source::~file_source()
+{
+	if (file != NULL)
+		fclose(file);
+}
+
+size_t file_source::read(char* buffer, size_t size)
+{
+	size_t bytes_read = fread(buffer, 1, size, file);
+
+	if (bytes_read == 0 && ferror(file))
+		error_log.push_back("error reading input file");
+
+	return bytes_read;
+}
+
+bool file_source::skip(unsigned long long size)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (long long)size, SEEK_CUR) == 0;
+#else
+	return fseeko(file, (off_t)size, SEEK_CUR) == 0;
+#endif
+}
+
+#ifdef OBJ_PARSER_USE_ZLIB
+gzip_source::~gzip_source()
+{
+	if (file != NULL)
+		gzclose(file);
+}
+
+size_t gzip_source::read(char* buffer, size_t size)
+{
+	//gzread takes an unsigned count, large requests are clamped and simply return short
+	unsigned int request = size > (1u << 30) ? (1u << 30) : (unsigned int)size;
+	int bytes_read = gzread(file, buffer, request);
+
+	//a truncated stream ends with 0 bytes read and Z_BUF_ERROR rather than a negative count
+	int error_number = Z_OK;
+	const char* message = bytes_read <= 0 ? gzerror(file, &error_number) : NULL;
+
+	if (bytes_read < 0 || (error_number != Z_OK && error_number != Z_STREAM_END))
+	{
+		string error = "gzip decompression failed: ";
+		error += message;
+		error_log.push_back(error);
+		return 0;
+	}
+
+	return (size_t)bytes_read;
+}
+#endif
+
+#ifdef OBJ_PARSER_USE_ZSTD
+zstd_source::zstd_source(FILE* f) : file(f), compressed(ZSTD_DStreamInSize()), input_finished(false), frame_remaining(0), failed(false)
+{
+	stream = ZSTD_createDStream();
+	ZSTD_initDStream(stream);
+
+	input.src = &compressed[0];
+	input.size = 0;
+	input.pos = 0;
+}
+
+zstd_source::~zstd_source()
+{
+	ZSTD_freeDStream(stream);
+
+	if (file != NULL)
+		fclose(file);
+}
+
+size_t zstd_source::read(char* buffer, size_t size)
+{
+	if (failed)
+		return 0;
+
+	ZSTD_outBuffer output = { buffer, size, 0 };
+
+	//keeps decoding until some output is produced or the decoder is drained
+	while (output.pos == 0)
+	{
+		if (input.pos == input.size && !input_finished)
+		{
+			input.size = fread(&compressed[0], 1, compressed.size(), file);
+			input.pos = 0;
+			input_finished = input.size == 0;
+		}
+
+		size_t input_before = input.pos;
+		size_t result = ZSTD_decompressStream(stream, &output, &input);
+		if (ZSTD_isError(result))
+		{
+			string error = "zstd decompression failed: ";
+			error += ZSTD_getErrorName(result);
+			error_log.push_back(error);
+			failed = true;
+			return 0;
+		}
+
+		//calls that move no data report the next frame's header size, not the current state
+		if (input.pos != input_before || output.pos != 0)
+			frame_remaining = result;
+
+		//with no input left, a call that produces nothing means the decoder is drained.
+		//if the last frame still expected data, the stream was cut off
+		if (input_finished && output.pos == 0)
+		{
+			if (frame_remaining != 0)
+			{
+				error_log.push_back("truncated zstd stream");
+				failed = true;
+			}
+
+			break;
+		}
+	}
+
+	return output.pos;
+}
+#endif
+
+pipelined_source::pipelined_source(std::unique_ptr<input_source> s, size_t block_bytes, int depth) :
+	source(std::move(s)), block_size(block_bytes), queue_depth(depth), producer_finished(false), stopping(false), current_position(0)
+{
+	worker = std::thread(&pipelined_source::produce, this);
+}
+
+pipelined_source::~pipelined_source()
+{
+	{
+		std::lock_guard<std::mutex> guard(queue_lock);
+		stopping = true;
+	}
+	block_consumed.notify_all();
+
+	if (worker.joinable())
+		worker.join();
+}
+
+void pipelined_source::produce()
+{
+	for (;;)
+	{
+		vector<char> block;
+		{
+			std::unique_lock<std::mutex> guard(queue_lock);
+			block_consumed.wait(guard, [this] { return stopping || int(filled_blocks.size()) < queue_depth; });
+
+			if (stopping)
+				break;
+
+			//recycles blocks the consumer has finished with
+			if (!free_blocks.empty())
+			{
+				block.swap(free_blocks.front());
+				free_blocks.pop_front();
+			}
+		}
+
+		block.resize(block_size);
+		size_t bytes_read = source->read(&block[0], block_size);
+		block.resize(bytes_read);
+
+		std::lock_guard<std::mutex> guard(queue_lock);
+		if (bytes_read == 0)
+		{
+			//errors are handed over before the consumer can observe the end of input
+			vector<string> source_errors = source->getErrors();
+			error_log.insert(error_log.end(), source_errors.begin(), source_errors.end());
+			producer_finished = true;
+			block_ready.notify_all();
+			break;
+		}
+
+		filled_blocks.push_back(vector<char>());
+		filled_blocks.back().swap(block);
+		block_ready.notify_all();
+	}
+}
+
+size_t pipelined_source::read(char* buffer, size_t size)
+{
+	if (current_position == current_block.size())
+	{
+		std::unique_lock<std::mutex> guard(queue_lock);
+
+		if (!current_block.empty())
+		{
+			free_blocks.push_back(vector<char>());
+			free_blocks.back().swap(current_block);
+		}
+
+		block_ready.wait(guard, [this] { return producer_finished || !filled_blocks.empty(); });
+
+		if (filled_blocks.empty())
+			return 0;
+
+		current_block.swap(filled_blocks.front());
+		filled_blocks.pop_front();
+		current_position = 0;
+		guard.unlock();
+		block_consumed.notify_all();
+	}
+
+	size_t bytes_copied = current_block.size() - current_position;
+	if (bytes_copied > size)
+		bytes_copied = size;
+
+	memcpy(buffer, &current_block[current_position], bytes_copied);
+	current_position += bytes_copied;
+
+	return bytes_copied;
+}
+
+const INPUT_FORMAT detectInputFormat(const unsigned char* header, size_t size)
+{
+	if (size >= 2 && header[0] == 0x1f && header[1] == 0x8b)
+		return INPUT_GZIP;
+
+	if (size >= 4 && header[0] == 0x28 && header[1] == 0xb5 && header[2] == 0x2f && header[3] == 0xfd)
+		return INPUT_ZSTD;
+
+	return INPUT_PLAIN;
+}
+
+std::unique_ptr<input_source> openInputSource(const char* file_path, string &error)
+{
+	FILE* file = fopen(file_path, "rb");
+
+	if (file == NULL)
+	{
+		error = "unable to open obj file: ";
+		error += file_path;
+		return std::unique_ptr<input_source>();
+	}
+
+	unsigned char header[4];
+	size_t header_size = fread(header, 1, sizeof(header), file);
+	rewind(file);
+
+	switch (detectInputFormat(header, header_size))
+	{
+	case INPUT_GZIP:
+	{
+#ifdef OBJ_PARSER_USE_ZLIB
+		fclose(file);
+
+		gzFile compressed_file = gzopen(file_path, "rb");
+		if (compressed_file == NULL)
+		{
+			error = "unable to open gzip stream: ";
+			error += file_path;
+			return std::unique_ptr<input_source>();
+		}
+
+		gzbuffer(compressed_file, 1 << 17);
+		std::unique_ptr<input_source> decoder(new gzip_source(compressed_file));
+		return std::unique_ptr<input_source>(new pipelined_source(std::move(decoder)));
+#else
+		fclose(file);
+		error = "gzip input requires building with OBJ_PARSER_USE_ZLIB: ";
+		error += file_path;
+		return std::unique_ptr<input_source>();
+#endif
+	}
+
+	case INPUT_ZSTD:
+	{
+#ifdef OBJ_PARSER_USE_ZSTD
+		std::unique_ptr<input_source> decoder(new zstd_source(file));
+		return std::unique_ptr<input_source>(new pipelined_source(std::move(decoder)));
+#else
+		fclose(file);
+		error = "zstd input requires building with OBJ_PARSER_USE_ZSTD: ";
+		error += file_path;
+		return std::unique_ptr<input_source>();
+#endif
+	}
+
+	default:
+		return std::unique_ptr<input_source>(new file_source(file));
+	}
+}
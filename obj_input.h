@@ -0,0 +1,134 @@
+#ifndef OBJ_INPUT_H
+#define OBJ_INPUT_H
+
+//byte sources the parser reads from. openInputSource picks the reader from the
+//file's magic bytes, compressed readers are only available when built with
+//OBJ_PARSER_USE_ZLIB (gzip, link zlib) or OBJ_PARSER_USE_ZSTD (zstd, link libzstd)
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+
+#ifdef OBJ_PARSER_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef OBJ_PARSER_USE_ZSTD
+#include <zstd.h>
+#endif
+
+using std::string;
+using std::vector;
+
+enum INPUT_FORMAT { INPUT_PLAIN, INPUT_GZIP, INPUT_ZSTD };
+
+class input_source
+{
+public:
+	input_source(){};
+	virtual ~input_source(){};
+
+	//reads up to size bytes into buffer, returns the number of bytes read,
+	//0 once the input is exhausted or an error was logged
+	virtual size_t read(char* buffer, size_t size) = 0;
+	//discards the next size bytes, returns false if the input ended first.
+	//streams read and drop the bytes, seekable sources override it
+	virtual bool skip(unsigned long long size);
+
+	vector<string> getErrors() const { return error_log; }
+
+protected:
+	vector<string> error_log;
+};
+
+class file_source : public input_source
+{
+public:
+	file_source(FILE* f) : file(f) {};
+	~file_source();
+
+	size_t read(char* buffer, size_t size);
+	bool skip(unsigned long long size);
+
+private:
+	FILE* file;
+};
+
+#ifdef OBJ_PARSER_USE_ZLIB
+class gzip_source : public input_source
+{
+public:
+	gzip_source(gzFile f) : file(f) {};
+	~gzip_source();
+
+	size_t read(char* buffer, size_t size);
+
+private:
+	gzFile file;
+};
+#endif
+
+#ifdef OBJ_PARSER_USE_ZSTD
+class zstd_source : public input_source
+{
+public:
+	zstd_source(FILE* f);
+	~zstd_source();
+
+	size_t read(char* buffer, size_t size);
+
+private:
+	FILE* file;
+	ZSTD_DStream* stream;
+	vector<char> compressed;
+	ZSTD_inBuffer input;
+	bool input_finished;
+	//last ZSTD_decompressStream result, 0 once a frame is complete
+	size_t frame_remaining;
+	//set once an error was logged, later reads return 0
+	bool failed;
+};
+#endif
+
+//runs another source's reads on a worker thread, keeping up to queue_depth blocks
+//decoded ahead of the consumer so decompression overlaps with tokenizing
+class pipelined_source : public input_source
+{
+public:
+	pipelined_source(std::unique_ptr<input_source> s, size_t block_bytes = 1 << 20, int depth = 4);
+	~pipelined_source();
+
+	size_t read(char* buffer, size_t size);
+
+private:
+	void produce();
+
+	std::unique_ptr<input_source> source;
+	size_t block_size;
+	int queue_depth;
+
+	std::mutex queue_lock;
+	std::condition_variable block_ready;
+	std::condition_variable block_consumed;
+	std::deque< vector<char> > filled_blocks;
+	std::deque< vector<char> > free_blocks;
+	bool producer_finished;
+	bool stopping;
+
+	//block being handed out to read(), owned by the consumer thread
+	vector<char> current_block;
+	size_t current_position;
+
+	std::thread worker;
+};
+
+const INPUT_FORMAT detectInputFormat(const unsigned char* header, size_t size);
+//returns NULL and sets error if the file cannot be opened or its format is not supported
+std::unique_ptr<input_source> openInputSource(const char* file_path, string &error);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef OBJ_JSON_H
+#define OBJ_JSON_H
+
+#include <string>
+#include <stdio.h>
+
+//appends s as a quoted json string, escaping quotes, backslashes and control characters
+inline void appendJSONString(std::string &out, const std::string &s)
+{
+	out += '"';
+	for (auto c : s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+
+		else if ((unsigned char)c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+			out += escaped;
+		}
+
+		else out += c;
+	}
+	out += '"';
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef OBJ_PARALLEL_H
+#define OBJ_PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+//splits [0, count) into one contiguous range per hardware thread and calls
+//function(begin, end) for each, the calling thread takes the first range.
+//ranges smaller than min_per_thread are not worth a thread and run inline
+template <typename F>
+void parallelFor(int count, F function, int min_per_thread = 1024)
+{
+	int thread_total = std::thread::hardware_concurrency();
+	if (thread_total < 1)
+		thread_total = 1;
+
+	thread_total = std::min(thread_total, std::max(1, count / std::max(1, min_per_thread)));
+
+	if (thread_total <= 1)
+	{
+		function(0, count);
+		return;
+	}
+
+	int range_size = (count + thread_total - 1) / thread_total;
+
+	std::vector<std::thread> workers;
+	for (int begin = range_size; begin < count; begin += range_size)
+		workers.push_back(std::thread(function, begin, std::min(count, begin + range_size)));
+
+	function(0, std::min(count, range_size));
+
+	for (auto &worker : workers)
+		worker.join();
+}
+
+#endif
@@ -1,6 +1,21 @@
 #include "obj_parser.h"
-
-bool vertex_data::operator == (const vertex_data &other)
+#include "obj_input.h"
+#include "obj_index.h"
+#include "obj_parallel.h"
+#include "vertex_dedup.h"
+#include "obj_spill.h"
+#include "obj_trace.h"
+
+#include <string.h>
+#include <ctype.h>
+#include <tuple>
+#include <algorithm>
+#include <sstream>
+#include <locale>
+#include <stdexcept>
+#include <limits>
+
+bool vertex_data::operator == (const vertex_data &other) const
 {
 	if (getUVOffset() != other.getUVOffset())
 		return false;
@@ -170,13 +185,72 @@ void vertex_data::rotate(const glm::mat4 &rotation_matrix)
 	setVertexData();
 }
 
+float* vertex_data::copyAllData(float* destination) const
+{
+	return std::copy(all_data.begin(), all_data.end(), destination);
+}
+
+const size_t vertex_data::getHeapBytes() const
+{
+	return (v_data.capacity() + vt_data.capacity() + vn_data.capacity() + vp_data.capacity() + all_data.capacity()) * sizeof(float);
+}
+
+void vertex_data::setNormal(const glm::vec3 &normal)
+{
+	all_data.clear();
+
+	vn_data.clear();
+	vn_data.push_back(normal.x);
+	vn_data.push_back(normal.y);
+	vn_data.push_back(normal.z);
+	vn_count = 3;
+
+	setVertexData();
+}
+
 void mesh_data::addFace(const vector<vertex_data> &data)
 { 
 	faces.push_back(data); 
+	indexLastFace();
+}
+
+//builds the stored face in place rather than copying a temporary one
+void mesh_data::addTriangle(const vertex_data &a, const vertex_data &b, const vertex_data &c)
+{
+	faces.emplace_back();
+	faces.back().reserve(3);
+	faces.back().push_back(a);
+	faces.back().push_back(b);
+	faces.back().push_back(c);
+	indexLastFace();
+}
+
+void mesh_data::indexLastFace()
+{
+	const vector<vertex_data> &data = faces.back();
 	total_face_count++; 
 	vertex_count += data.size(); 
+	trackFaceStride(data);
+
+	for (const auto &vertex : data)
+	{
+		bounds_min = glm::vec3(fminf(bounds_min.x, vertex.x), fminf(bounds_min.y, vertex.y), fminf(bounds_min.z, vertex.z));
+		bounds_max = glm::vec3(fmaxf(bounds_max.x, vertex.x), fmaxf(bounds_max.y, vertex.y), fmaxf(bounds_max.z, vertex.z));
+	}
+#ifndef OBJ_PARSER_NO_STATS
+	if (stats != NULL)
+	{
+		stats->faces++;
+		stats->total_vertices += data.size();
+	}
+#endif
 
-	vector<glm::vec3> tangent_bitangent = calcTangentBitangent(data);
+	vector<glm::vec3> tangent_bitangent;
+	{
+		OBJ_STATS_PHASE(stats, PHASE_TANGENTS);
+		OBJ_TRACE_ZONE("tangents");
+		tangent_bitangent = calcTangentBitangent(data);
+	}
 
 	//add data to each respective all_data vector, for retrieving individual sets
 	for (vector<vertex_data>::const_iterator it = data.begin(); it != data.end(); it++)
@@ -184,17 +258,19 @@ void mesh_data::addFace(const vector<vertex_data> &data)
 		addVData(it->getVData());
 		addVTData(it->getVTData());
 		addVNData(it->getVNData());
-
-		//adds tangent/bitangent once for each vertex
-		addTangentBitangent(tangent_bitangent);
 	}
 
-	for (auto i : data)
+	//adds tangent/bitangent once for each of the face's 3 vertices
+	addTangentBitangent(tangent_bitangent);
+
+	OBJ_STATS_PHASE(stats, PHASE_DEDUP);
+	OBJ_TRACE_ZONE("dedup");
+	for (const auto &i : data)
 	{
 		bool match_found = false;
 
 		//TODO use find methods instead of iterating through all vertices
-		for (auto j : vertex_map)
+		for (const auto &j : vertex_map)
 		{
 			if (i == j.second)
 			{
@@ -211,6 +287,11 @@ void mesh_data::addFace(const vector<vertex_data> &data)
 
 		if (!match_found)
 		{
+#ifndef OBJ_PARSER_NO_STATS
+			if (stats != NULL)
+				stats->unique_vertices++;
+#endif
+
 			//add new index, vertex, tangent, and bitangent
 			unsigned short new_index = vertex_map.size();
 			element_index.push_back(new_index);
@@ -227,6 +308,202 @@ void mesh_data::addFace(const vector<vertex_data> &data)
 	}
 }
 
+//floats compare bitwise with -0 equal to 0, as in dedupVertices
+static uint64_t hashVertexBits(const float* vertex, int stride)
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+	for (int i = 0; i < stride; i++)
+	{
+		float value = vertex[i] == 0.0f ? 0.0f : vertex[i];
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		h = (h ^ bits) * 0x100000001b3ull;
+	}
+
+	return h;
+}
+
+static bool sameVertexBits(const float* a, const float* b, int stride)
+{
+	for (int i = 0; i < stride; i++)
+	{
+		if (a[i] != b[i] && memcmp(&a[i], &b[i], sizeof(float)) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+void mesh_data::resetVertexLookup()
+{
+	std::unordered_multimap<uint64_t, unsigned short>().swap(vertex_lookup);
+	vertex_lookup_size = 0;
+}
+
+void mesh_data::addFaces(const vector< vector<vertex_data> > &triangles)
+{
+	if (triangles.empty())
+		return;
+
+	bool uniform = true;
+	for (int t = 0; t < (int)triangles.size() && uniform; t++)
+		uniform = triangles[t].size() == 3;
+
+	int stride_bytes = uniform ? triangles[0][0].getStride() : 0;
+	uniform = uniform && (vertex_map.empty() || vertex_map.begin()->second.getStride() == stride_bytes);
+	for (int t = 0; t < (int)triangles.size() && uniform; t++)
+	{
+		for (const auto &vertex : triangles[t])
+			uniform = uniform && vertex.getStride() == stride_bytes;
+	}
+
+	if (!uniform)
+	{
+		//faces of fewer than 3 vertices have no tangent space and are skipped
+		for (const auto &face : triangles)
+		{
+			if (face.size() >= 3)
+				addFace(face);
+		}
+
+		return;
+	}
+
+	int stride = stride_bytes / sizeof(float);
+	int triangle_total = triangles.size();
+	int corner_total = triangle_total * 3;
+
+	vector< vector<glm::vec3> > face_tangents(triangle_total);
+	{
+		OBJ_STATS_PHASE(stats, PHASE_TANGENTS);
+		OBJ_TRACE_ZONE("tangents");
+		parallelFor(triangle_total, [&](int begin, int end) {
+			//one zone per worker, so uneven ranges show up on the timeline
+			OBJ_TRACE_ZONE("tangents range");
+			for (int t = begin; t < end; t++)
+				face_tangents[t] = calcTangentBitangent(triangles[t]);
+		}, 256);
+	}
+
+	//the new corners are deduplicated among themselves, then each distinct one is looked
+	//up among the vertices already indexed. those keep their numbers, new ones follow in
+	//first-occurrence order, the numbering a serial pass over all corners would give
+	vector<unsigned int> indices(corner_total);
+	{
+		OBJ_STATS_PHASE(stats, PHASE_DEDUP);
+		OBJ_TRACE_ZONE("dedup");
+		vector<float> corners((size_t)corner_total * stride);
+
+		parallelFor(triangle_total, [&](int begin, int end) {
+			for (int t = begin; t < end; t++)
+			{
+				for (int k = 0; k < 3; k++)
+					triangles[t][k].copyAllData(&corners[(size_t)(t * 3 + k) * stride]);
+			}
+		}, 256);
+
+		vector<float> unique_vertices;
+		vector<unsigned int> corner_indices;
+		int unique_total = dedupVertices(&corners[0], corner_total, stride, unique_vertices, corner_indices);
+
+		//catches up with vertices addFace indexed since the last call
+		vector<float> existing(stride);
+		for (map<unsigned short, vertex_data>::const_iterator it = vertex_map.lower_bound(vertex_lookup_size); it != vertex_map.end(); it++)
+		{
+			it->second.copyAllData(&existing[0]);
+			vertex_lookup.insert(std::make_pair(hashVertexBits(&existing[0], stride), it->first));
+		}
+
+		vector<unsigned int> unique_indices(unique_total);
+		unsigned int next_index = vertex_map.size();
+		for (int u = 0; u < unique_total; u++)
+		{
+			const float* vertex = &unique_vertices[(size_t)u * stride];
+			uint64_t h = hashVertexBits(vertex, stride);
+			bool found = false;
+
+			auto candidates = vertex_lookup.equal_range(h);
+			for (auto it = candidates.first; it != candidates.second && !found; it++)
+			{
+				//vertices numbered by this call are distinct from each other already
+				if (it->second >= vertex_map.size())
+					continue;
+
+				vertex_map.at(it->second).copyAllData(&existing[0]);
+				if (sameVertexBits(vertex, &existing[0], stride))
+				{
+					unique_indices[u] = it->second;
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				unique_indices[u] = next_index++;
+				vertex_lookup.insert(std::make_pair(h, (unsigned short)unique_indices[u]));
+			}
+		}
+
+		for (int c = 0; c < corner_total; c++)
+			indices[c] = unique_indices[corner_indices[c]];
+
+		vertex_lookup_size = next_index;
+	}
+
+	//the rest is the bookkeeping addFace does, in the same order so tangent sums match
+	for (int t = 0; t < triangle_total; t++)
+	{
+		const vector<vertex_data> &face = triangles[t];
+		const vector<glm::vec3> &tangent_bitangent = face_tangents[t];
+
+		faces.push_back(face);
+		total_face_count++;
+		vertex_count += 3;
+		trackFaceStride(face);
+#ifndef OBJ_PARSER_NO_STATS
+		if (stats != NULL)
+		{
+			stats->faces++;
+			stats->total_vertices += 3;
+		}
+#endif
+
+		for (int k = 0; k < 3; k++)
+		{
+			const vertex_data &vertex = face[k];
+			bounds_min = glm::vec3(fminf(bounds_min.x, vertex.x), fminf(bounds_min.y, vertex.y), fminf(bounds_min.z, vertex.z));
+			bounds_max = glm::vec3(fmaxf(bounds_max.x, vertex.x), fmaxf(bounds_max.y, vertex.y), fmaxf(bounds_max.z, vertex.z));
+
+			addVData(vertex.getVData());
+			addVTData(vertex.getVTData());
+			addVNData(vertex.getVNData());
+		}
+
+		addTangentBitangent(tangent_bitangent);
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned short index = indices[t * 3 + k];
+			element_index.push_back(index);
+
+			if (index < vertex_map.size())
+			{
+				tangent_map[index] += tangent_bitangent[0];
+				bitangent_map[index] += tangent_bitangent[1];
+				continue;
+			}
+
+#ifndef OBJ_PARSER_NO_STATS
+			if (stats != NULL)
+				stats->unique_vertices++;
+#endif
+			vertex_map.insert(std::pair<unsigned short, vertex_data>(index, face[k]));
+			tangent_map.insert(std::pair<unsigned short, glm::vec3>(index, tangent_bitangent[0]));
+			bitangent_map.insert(std::pair<unsigned short, glm::vec3>(index, tangent_bitangent[1]));
+		}
+	}
+}
+
 void mesh_data::addTangentBitangent(const vector<glm::vec3> &tb)
 {
 	for (int i = 0; i < 3; i++)
@@ -236,19 +513,57 @@ void mesh_data::addTangentBitangent(const vector<glm::vec3> &tb)
 	}
 }
 
+void mesh_data::trackFaceStride(const vector<vertex_data> &face)
+{
+	for (const auto &vertex : face)
+	{
+		int stride = vertex.getStride() / sizeof(float);
+		if (face_stride != stride)
+			face_stride = face_stride == 0 ? stride : -1;
+	}
+}
+
+template <int STRIDE>
+const vector<float> mesh_data::interleaveFaces() const
+{
+	vector<float> interleave_data((size_t)vertex_count * STRIDE);
+	float* destination = interleave_data.data();
+
+	for (const auto &face : faces)
+	{
+		for (const auto &vertex : face)
+			destination = vertex.copyFixedData<STRIDE>(destination);
+	}
+
+	return interleave_data;
+}
+
 const vector<float> mesh_data::getInterleaveData() const
 {
+	//object data format will be:
+	//		position.x, position.y, position.z, [position.w],
+	//		uv.x, [uv.y], [uv.w],
+	//		normal.x, normal.y, normal.z,
+	//	bracketed values are only included if they were in the original obj file
+
+	//every layout the parser builds: v, v/vt, v//vn and v/vt/vn with 3 or 4 float positions
+	switch (face_stride)
+	{
+	case 3: return interleaveFaces<3>();
+	case 4: return interleaveFaces<4>();
+	case 5: return interleaveFaces<5>();
+	case 6: return interleaveFaces<6>();
+	case 7: return interleaveFaces<7>();
+	case 8: return interleaveFaces<8>();
+	case 9: return interleaveFaces<9>();
+	default: break;
+	}
+
 	vector<float> interleave_data;
 	interleave_data.reserve(total_float_count);
 	for (vector< vector<vertex_data> >::const_iterator faces_it = faces.begin();
 		faces_it != faces.end(); faces_it++)
 	{
-		//object data format will be:
-		//		position.x, position.y, position.z, [position.w],
-		//		uv.x, [uv.y], [uv.w],
-		//		normal.x, normal.y, normal.z,
-		//	bracketed values are only included if they were in the original obj file
-
 		//for each vertex in each face, pass the stored, ordered data to interleave_data
 		for (vector<vertex_data>::const_iterator vertex_it = faces_it->begin();
 			vertex_it != faces_it->end(); vertex_it++)
@@ -311,29 +626,94 @@ void mesh_data::getIndexedVertexData(const vector<unsigned short> &indices, vect
 
 const vector<float> mesh_data::getIndexedVertexData() const
 {
-	vector<float> all_data;
+	vector<float> all_data(vertex_map.size() * getIndexedVertexLayout().stride);
+
+	if (!all_data.empty())
+		copyIndexedVertexData(&all_data[0]);
+
+	return all_data;
+}
+
+template <int STRIDE>
+void mesh_data::copyIndexedVertices(float* destination) const
+{
+	for (const auto &vert_pair : vertex_map)
+	{
+		destination = vert_pair.second.copyFixedData<STRIDE>(destination);
+
+		const glm::vec3 &tangent_data = tangent_map.at(vert_pair.first);
+		const glm::vec3 &bitangent_data = bitangent_map.at(vert_pair.first);
+		destination[0] = tangent_data.x;
+		destination[1] = tangent_data.y;
+		destination[2] = tangent_data.z;
+		destination[3] = bitangent_data.x;
+		destination[4] = bitangent_data.y;
+		destination[5] = bitangent_data.z;
+		destination += 6;
+	}
+}
+
+void mesh_data::copyElementIndex(unsigned short* destination) const
+{
+	if (!element_index.empty())
+		memcpy(destination, &element_index[0], element_index.size() * sizeof(unsigned short));
+}
+
+void mesh_data::copyIndexedVertexData(float* destination) const
+{
+	//indexed vertices come from the faces, so they share the faces' stride
+	switch (face_stride)
+	{
+	case 3: copyIndexedVertices<3>(destination); return;
+	case 4: copyIndexedVertices<4>(destination); return;
+	case 5: copyIndexedVertices<5>(destination); return;
+	case 6: copyIndexedVertices<6>(destination); return;
+	case 7: copyIndexedVertices<7>(destination); return;
+	case 8: copyIndexedVertices<8>(destination); return;
+	case 9: copyIndexedVertices<9>(destination); return;
+	default: break;
+	}
 
-	for (const auto vert_pair : vertex_map)
+	for (const auto &vert_pair : vertex_map)
 	{
 		//includes vertex position data, uv data, and normal data
-		vector<float> vertex_data_to_add = (vert_pair.second).getAllData();
+		destination = vert_pair.second.copyAllData(destination);
 
 		//append tangent data
-		glm::vec3 tangent_data = tangent_map.at(vert_pair.first);
-		vertex_data_to_add.push_back(tangent_data.x);
-		vertex_data_to_add.push_back(tangent_data.y);
-		vertex_data_to_add.push_back(tangent_data.z);
+		const glm::vec3 &tangent_data = tangent_map.at(vert_pair.first);
+		*destination++ = tangent_data.x;
+		*destination++ = tangent_data.y;
+		*destination++ = tangent_data.z;
 
 		//append bitangent data
-		glm::vec3 bitangent_data = bitangent_map.at(vert_pair.first);
-		vertex_data_to_add.push_back(bitangent_data.x);
-		vertex_data_to_add.push_back(bitangent_data.y);
-		vertex_data_to_add.push_back(bitangent_data.z);
-
-		all_data.insert(all_data.end(), vertex_data_to_add.begin(), vertex_data_to_add.end());
+		const glm::vec3 &bitangent_data = bitangent_map.at(vert_pair.first);
+		*destination++ = bitangent_data.x;
+		*destination++ = bitangent_data.y;
+		*destination++ = bitangent_data.z;
 	}
+}
 
-	return all_data;
+const vertex_layout mesh_data::getIndexedVertexLayout() const
+{
+	vertex_layout layout;
+
+	if (vertex_map.empty())
+		return layout;
+
+	//sizes are read from a stored vertex, setMeshData may not have run yet
+	const vertex_data &first = vertex_map.begin()->second;
+	layout.v_size = first.getVSize();
+	layout.vt_offset = layout.v_size;
+	layout.vt_size = first.getVTSize();
+	layout.vn_offset = layout.vt_offset + layout.vt_size;
+	layout.vn_size = first.getVNSize();
+	layout.tan_offset = layout.vn_offset + layout.vn_size;
+	layout.tan_size = 3;
+	layout.bitan_offset = layout.tan_offset + layout.tan_size;
+	layout.bitan_size = 3;
+	layout.stride = layout.bitan_offset + layout.bitan_size;
+
+	return layout;
 }
 
 const vector<float> mesh_data::getIndexedVertexData(vector<unsigned short> &indices) const
@@ -380,144 +760,465 @@ const vector<float> mesh_data::getIndexedVertexData(vector<unsigned short> &indi
 
 void mesh_data::modifyPosition(const glm::mat4 &translation_matrix)
 {
-	all_v_data.clear();
-
 	for (auto &face : faces)
 	{
 		for (auto &vertex : face)
-		{
 			vertex.modifyPosition(translation_matrix);
-			vector<float> vertex_v_data = vertex.getVData();
-			all_v_data.insert(all_v_data.end(), vertex_v_data.begin(), vertex_v_data.end());
-		}
 	}
 
-	for (auto i : vertex_map)
+	for (auto &i : vertex_map)
 		i.second.modifyPosition(translation_matrix);
+
+	resetVertexLookup();
+
+	if (representations & (MESH_FACES | MESH_INDEXED))
+		rebuildAttributeLists();
+
+	else transformAttributeLists(translation_matrix, false);
+
+	updateBoundingVolumes(true);
 }
 
 void mesh_data::rotate(const glm::mat4 &rotation_matrix)
 {
-	all_v_data.clear();
-	all_vn_data.clear();
-
 	for (auto &face : faces)
 	{
 		for (auto &vertex : face)
-		{
 			vertex.rotate(rotation_matrix);
-			vector<float> vertex_v_data = vertex.getVData();
-			vector<float> vertex_vn_data = vertex.getVNData();
-			all_v_data.insert(all_v_data.end(), vertex_v_data.begin(), vertex_v_data.end());
-			all_vn_data.insert(all_vn_data.end(), vertex_vn_data.begin(), vertex_vn_data.end());
-		}
 	}
 
-	for (auto i : vertex_map)
+	for (auto &i : vertex_map)
 		i.second.rotate(rotation_matrix);
-}
-
-vector< std::pair<glm::vec4, glm::vec4> > mesh_data::getMeshEdgesVec4() const
-{
-	map< int, std::pair<glm::vec4, glm::vec4> > edges;
-	int edge_counter = 0;
 
-	//for each side of each triangle
-	for (auto i : faces)
-	{
-		std::pair<glm::vec4, glm::vec4> edge1(i.at(0).xyzw, i.at(1).xyzw);
-		std::pair<glm::vec4, glm::vec4> edge2(i.at(1).xyzw, i.at(2).xyzw);
-		std::pair<glm::vec4, glm::vec4> edge3(i.at(2).xyzw, i.at(0).xyzw);
+	resetVertexLookup();
 
-		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge1));
-		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge2));
-		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge3));
-	}
+	if (representations & (MESH_FACES | MESH_INDEXED))
+		rebuildAttributeLists();
 
-	vector<int> unique_edges;
-	vector<int> shared_edges;
+	else transformAttributeLists(rotation_matrix, true);
 
-	for (auto i : edges)
-	{
-		//verity edge analyzed isn't already identified as shared
-		if (std::find(shared_edges.begin(), shared_edges.end(), i.first) != shared_edges.end())
-			continue;
+	updateBoundingVolumes(true);
+}
 
-		std::pair<glm::vec4, glm::vec4> i_edge = i.second;
+void mesh_data::rebuildAttributeLists()
+{
+	if (!(representations & MESH_ATTRIBUTE_LISTS))
+		return;
 
-		bool unique = true;
+	all_v_data.clear();
+	all_vt_data.clear();
+	all_vn_data.clear();
 
-		for (auto j : edges)
+	if (representations & MESH_FACES)
+	{
+		for (const auto &face : faces)
 		{
-			//skip if the edge has already been confirmed as unique or shared
-			if (std::find(shared_edges.begin(), shared_edges.end(), j.first) != shared_edges.end())
-				continue;
-
-			if (std::find(unique_edges.begin(), unique_edges.end(), j.first) != unique_edges.end())
-				continue;
-
-			std::pair<glm::vec4, glm::vec4> j_edge = j.second;
-
-			//if each edge has similar points, in any order, add to shared edges
-			if ((i_edge.second == j_edge.first && i_edge.second == j_edge.second) ||
-				(i_edge.first == j_edge.second && i_edge.second == j_edge.first))
+			for (const auto &vertex : face)
 			{
-				shared_edges.push_back(i.first);
-				shared_edges.push_back(j.first);
-				unique = false;
-				break;
+				addVData(vertex.getVData());
+				addVTData(vertex.getVTData());
+				addVNData(vertex.getVNData());
 			}
 		}
+	}
 
-		if (unique)
-			unique_edges.push_back(i.first);
+	//element_index lists the corners in the same order faces did
+	else if (representations & MESH_INDEXED)
+	{
+		for (auto index : element_index)
+		{
+			const vertex_data &vertex = vertex_map.at(index);
+			addVData(vertex.getVData());
+			addVTData(vertex.getVTData());
+			addVNData(vertex.getVNData());
+		}
 	}
+}
 
-	vector< std::pair<glm::vec4, glm::vec4> > outer_edges;
+void mesh_data::transformAttributeLists(const glm::mat4 &matrix, bool rotate_normals)
+{
+	if (!(representations & MESH_ATTRIBUTE_LISTS) || v_size <= 0)
+		return;
 
-	for (auto i : unique_edges)
-		outer_edges.push_back(edges.at(i));
+	//each corner goes through a temporary vertex_data so the math matches the other forms
+	int corner_total = all_v_data.size() / v_size;
+	for (int c = 0; c < corner_total; c++)
+	{
+		vector<float> position(all_v_data.begin() + c * v_size, all_v_data.begin() + (c + 1) * v_size);
+		vector<float> normal;
+		if (rotate_normals && vn_size > 0 && (int)all_vn_data.size() >= (c + 1) * vn_size)
+			normal.assign(all_vn_data.begin() + c * vn_size, all_vn_data.begin() + (c + 1) * vn_size);
 
-	return outer_edges;
+		vertex_data vertex(position, vector<float>(), normal);
+		if (rotate_normals)
+			vertex.rotate(matrix);
+
+		else vertex.modifyPosition(matrix);
+
+		vector<float> moved_position = vertex.getVData();
+		std::copy(moved_position.begin(), moved_position.end(), all_v_data.begin() + c * v_size);
+
+		if (!normal.empty())
+		{
+			vector<float> moved_normal = vertex.getVNData();
+			std::copy(moved_normal.begin(), moved_normal.end(), all_vn_data.begin() + c * vn_size);
+		}
+	}
 }
 
-vector< std::pair<glm::vec3, glm::vec3> > mesh_data::getMeshEdgesVec3() const
+const mesh_memory_usage mesh_data::memoryUsage() const
 {
-	vector< std::pair<glm::vec3, glm::vec3> > vec3_data;
-	vector< std::pair<glm::vec4, glm::vec4> > vec4_data = getMeshEdgesVec4();
+	//red-black tree node: three links and a color, padded, ahead of the stored pair
+	const size_t map_node_overhead = 4 * sizeof(void*);
+	mesh_memory_usage usage;
 
-	for (auto i : vec4_data)
+	usage.faces = faces.capacity() * sizeof(vector<vertex_data>);
+	for (const auto &face : faces)
 	{
-		std::pair<glm::vec3, glm::vec3> converted(glm::vec3(i.first), glm::vec3(i.second));
-		vec3_data.push_back(converted);
+		usage.faces += face.capacity() * sizeof(vertex_data);
+		for (const auto &vertex : face)
+			usage.faces += vertex.getHeapBytes();
 	}
 
-	return vec3_data;
-}
+	usage.attribute_lists = (all_v_data.capacity() + all_vt_data.capacity() + all_vn_data.capacity() + all_vp_data.capacity()) * sizeof(float);
 
-vector< vector<glm::vec4> > mesh_data::getMeshTrianglesVec4() const
-{
-	vector< vector<glm::vec4> > triangles;
+	usage.vertex_map = vertex_map.size() * (map_node_overhead + sizeof(std::pair<const unsigned short, vertex_data>));
+	for (const auto &vertex : vertex_map)
+		usage.vertex_map += vertex.second.getHeapBytes();
 
-	for (auto i : faces)
-	{
-		vector<glm::vec4> triangle = {
-			i.at(0).xyzw,
-			i.at(1).xyzw,
-			i.at(2).xyzw
-		};
+	//the addFaces lookup, one node per entry plus the bucket array
+	usage.vertex_map += vertex_lookup.size() * (2 * sizeof(void*) + sizeof(std::pair<const uint64_t, unsigned short>)) +
+		vertex_lookup.bucket_count() * sizeof(void*);
 
-		triangles.push_back(triangle);
-	}
+	usage.tangent_maps = (tangent_map.size() + bitangent_map.size()) * (map_node_overhead + sizeof(std::pair<const unsigned short, glm::vec3>));
+	usage.element_index = element_index.capacity() * sizeof(unsigned short);
+	usage.corner_tangents = (tangents.capacity() + bitangents.capacity()) * sizeof(glm::vec3);
 
-	return triangles;
+	return usage;
 }
 
-vector< vector<glm::vec3> > mesh_data::getMeshTrianglesVec3() const
+void mesh_data::compact(int keep)
 {
-	vector< vector<glm::vec3> > triangles;
+	//swapping with an empty container is the only portable way to free the capacity
+	if (keep & MESH_FACES)
+		faces.shrink_to_fit();
 
-	for (auto i : faces)
+	else vector< vector<vertex_data> >().swap(faces);
+
+	if (keep & MESH_ATTRIBUTE_LISTS)
+	{
+		all_v_data.shrink_to_fit();
+		all_vt_data.shrink_to_fit();
+		all_vn_data.shrink_to_fit();
+		all_vp_data.shrink_to_fit();
+	}
+
+	else
+	{
+		vector<float>().swap(all_v_data);
+		vector<float>().swap(all_vt_data);
+		vector<float>().swap(all_vn_data);
+		vector<float>().swap(all_vp_data);
+	}
+
+	//only addFaces needs the lookup, it is rebuilt if more faces come
+	resetVertexLookup();
+
+	if (keep & MESH_INDEXED)
+		element_index.shrink_to_fit();
+
+	else
+	{
+		map<unsigned short, vertex_data>().swap(vertex_map);
+		map<unsigned short, glm::vec3>().swap(tangent_map);
+		map<unsigned short, glm::vec3>().swap(bitangent_map);
+		vector<unsigned short>().swap(element_index);
+	}
+
+	if (keep & MESH_CORNER_TANGENTS)
+	{
+		tangents.shrink_to_fit();
+		bitangents.shrink_to_fit();
+	}
+
+	else
+	{
+		vector<glm::vec3>().swap(tangents);
+		vector<glm::vec3>().swap(bitangents);
+	}
+
+	representations &= keep;
+}
+
+void mesh_data::generateNormals(float crease_angle, NORMAL_WEIGHTING weighting)
+{
+	if (!(representations & MESH_INDEXED))
+		return;
+
+	int corner_total = element_index.size();
+	int triangle_total = corner_total / 3;
+	if (triangle_total == 0)
+		return;
+
+	//vertex_map keys run from 0 to size - 1
+	int vertex_total = vertex_map.size();
+	vector<glm::vec3> positions(vertex_total);
+	for (const auto &vertex : vertex_map)
+		positions[vertex.first] = vertex.second.xyz;
+
+	//vertices split by uv seams still share a position, smoothing works on position ids
+	vector<int> sorted_vertices(vertex_total);
+	for (int i = 0; i < vertex_total; i++)
+		sorted_vertices[i] = i;
+
+	std::sort(sorted_vertices.begin(), sorted_vertices.end(), [&positions](int a, int b) {
+		if (positions[a].x != positions[b].x)
+			return positions[a].x < positions[b].x;
+		if (positions[a].y != positions[b].y)
+			return positions[a].y < positions[b].y;
+		return positions[a].z < positions[b].z;
+	});
+
+	vector<int> position_ids(vertex_total);
+	int position_total = 0;
+	for (int i = 0; i < vertex_total; i++)
+	{
+		if (i > 0 && positions[sorted_vertices[i]] != positions[sorted_vertices[i - 1]])
+			position_total++;
+		position_ids[sorted_vertices[i]] = position_total;
+	}
+	position_total++;
+
+	//each triangle writes only its own slots, no synchronization needed
+	vector<glm::vec3> face_normals(triangle_total);
+	vector<glm::vec3> corner_contributions(corner_total);
+
+	parallelFor(triangle_total, [&](int begin, int end) {
+		for (int t = begin; t < end; t++)
+		{
+			const glm::vec3 &p0 = positions[element_index[t * 3]];
+			const glm::vec3 &p1 = positions[element_index[t * 3 + 1]];
+			const glm::vec3 &p2 = positions[element_index[t * 3 + 2]];
+
+			//cross product length is twice the triangle area
+			glm::vec3 face_cross = glm::cross(p1 - p0, p2 - p0);
+			float face_cross_length = glm::length(face_cross);
+			glm::vec3 face_normal = face_cross_length > 0.0f ? face_cross / face_cross_length : glm::vec3(0.0f, 0.0f, 0.0f);
+			face_normals[t] = face_normal;
+
+			const glm::vec3* corners[3] = { &p0, &p1, &p2 };
+			for (int k = 0; k < 3; k++)
+			{
+				if (weighting == NORMAL_WEIGHT_AREA)
+				{
+					corner_contributions[t * 3 + k] = face_cross;
+					continue;
+				}
+
+				glm::vec3 edge_a = *corners[(k + 1) % 3] - *corners[k];
+				glm::vec3 edge_b = *corners[(k + 2) % 3] - *corners[k];
+				float edge_lengths = glm::length(edge_a) * glm::length(edge_b);
+				float cosine = edge_lengths > 0.0f ? glm::dot(edge_a, edge_b) / edge_lengths : 1.0f;
+				cosine = std::max(-1.0f, std::min(1.0f, cosine));
+
+				corner_contributions[t * 3 + k] = face_normal * acos(cosine);
+			}
+		}
+	});
+
+	//corners grouped by position id, counting sort into one flat array
+	vector<int> adjacency_start(position_total + 1, 0);
+	for (int c = 0; c < corner_total; c++)
+		adjacency_start[position_ids[element_index[c]] + 1]++;
+
+	for (int i = 0; i < position_total; i++)
+		adjacency_start[i + 1] += adjacency_start[i];
+
+	vector<int> adjacency(corner_total);
+	vector<int> adjacency_fill(adjacency_start.begin(), adjacency_start.end() - 1);
+	for (int c = 0; c < corner_total; c++)
+		adjacency[adjacency_fill[position_ids[element_index[c]]]++] = c;
+
+	//every corner gathers from its neighbors instead of faces scattering into shared
+	//vertices, so threads never write the same slot. corners in the same smoothing
+	//group sum the same contributions in the same order and get identical normals
+	float crease_cosine = cos(crease_angle * 3.14159265f / 180.0f);
+	vector<glm::vec3> corner_normals(corner_total);
+
+	parallelFor(corner_total, [&](int begin, int end) {
+		for (int c = begin; c < end; c++)
+		{
+			const glm::vec3 &face_normal = face_normals[c / 3];
+			int position_id = position_ids[element_index[c]];
+
+			glm::vec3 sum(0.0f, 0.0f, 0.0f);
+			for (int a = adjacency_start[position_id]; a < adjacency_start[position_id + 1]; a++)
+			{
+				int neighbor = adjacency[a];
+				if (glm::dot(face_normal, face_normals[neighbor / 3]) >= crease_cosine)
+					sum += corner_contributions[neighbor];
+			}
+
+			float sum_length = glm::length(sum);
+			corner_normals[c] = sum_length > 0.0f ? sum / sum_length : face_normal;
+		}
+	});
+
+	//rebuild the indexed vertices, a vertex used with several normals is split
+	map<unsigned short, vertex_data> new_vertex_map;
+	map<unsigned short, glm::vec3> new_tangent_map;
+	map<unsigned short, glm::vec3> new_bitangent_map;
+	map< std::tuple<unsigned short, float, float, float>, unsigned short> split_vertices;
+
+	for (int c = 0; c < corner_total; c++)
+	{
+		unsigned short old_index = element_index[c];
+		const glm::vec3 &normal = corner_normals[c];
+		std::tuple<unsigned short, float, float, float> key(old_index, normal.x, normal.y, normal.z);
+
+		map< std::tuple<unsigned short, float, float, float>, unsigned short>::const_iterator found = split_vertices.find(key);
+		if (found != split_vertices.end())
+		{
+			element_index[c] = found->second;
+			continue;
+		}
+
+		unsigned short new_index = new_vertex_map.size();
+		split_vertices[key] = new_index;
+
+		vertex_data vertex = vertex_map.at(old_index);
+		vertex.setNormal(normal);
+		new_vertex_map.insert(std::pair<unsigned short, vertex_data>(new_index, vertex));
+		new_tangent_map[new_index] = tangent_map.at(old_index);
+		new_bitangent_map[new_index] = bitangent_map.at(old_index);
+
+		element_index[c] = new_index;
+	}
+
+	vertex_map.swap(new_vertex_map);
+	resetVertexLookup();
+	tangent_map.swap(new_tangent_map);
+	bitangent_map.swap(new_bitangent_map);
+
+	//per-face copies and the flat attribute lists are rebuilt in face order
+	int corner = 0;
+	face_stride = 0;
+	for (auto &face : faces)
+	{
+		for (auto &vertex : face)
+		{
+			if (corner < corner_total)
+				vertex.setNormal(corner_normals[corner++]);
+		}
+
+		trackFaceStride(face);
+	}
+
+	rebuildAttributeLists();
+	setMeshData();
+}
+
+vector< std::pair<glm::vec4, glm::vec4> > mesh_data::getMeshEdgesVec4() const
+{
+	map< int, std::pair<glm::vec4, glm::vec4> > edges;
+	int edge_counter = 0;
+
+	//for each side of each triangle
+	for (auto i : faces)
+	{
+		std::pair<glm::vec4, glm::vec4> edge1(i.at(0).xyzw, i.at(1).xyzw);
+		std::pair<glm::vec4, glm::vec4> edge2(i.at(1).xyzw, i.at(2).xyzw);
+		std::pair<glm::vec4, glm::vec4> edge3(i.at(2).xyzw, i.at(0).xyzw);
+
+		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge1));
+		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge2));
+		edges.insert(std::pair<int, std::pair<glm::vec4, glm::vec4> >(edge_counter++, edge3));
+	}
+
+	vector<int> unique_edges;
+	vector<int> shared_edges;
+
+	for (auto i : edges)
+	{
+		//verity edge analyzed isn't already identified as shared
+		if (std::find(shared_edges.begin(), shared_edges.end(), i.first) != shared_edges.end())
+			continue;
+
+		std::pair<glm::vec4, glm::vec4> i_edge = i.second;
+
+		bool unique = true;
+
+		for (auto j : edges)
+		{
+			//skip if the edge has already been confirmed as unique or shared
+			if (std::find(shared_edges.begin(), shared_edges.end(), j.first) != shared_edges.end())
+				continue;
+
+			if (std::find(unique_edges.begin(), unique_edges.end(), j.first) != unique_edges.end())
+				continue;
+
+			std::pair<glm::vec4, glm::vec4> j_edge = j.second;
+
+			//if each edge has similar points, in any order, add to shared edges
+			if ((i_edge.second == j_edge.first && i_edge.second == j_edge.second) ||
+				(i_edge.first == j_edge.second && i_edge.second == j_edge.first))
+			{
+				shared_edges.push_back(i.first);
+				shared_edges.push_back(j.first);
+				unique = false;
+				break;
+			}
+		}
+
+		if (unique)
+			unique_edges.push_back(i.first);
+	}
+
+	vector< std::pair<glm::vec4, glm::vec4> > outer_edges;
+
+	for (auto i : unique_edges)
+		outer_edges.push_back(edges.at(i));
+
+	return outer_edges;
+}
+
+vector< std::pair<glm::vec3, glm::vec3> > mesh_data::getMeshEdgesVec3() const
+{
+	vector< std::pair<glm::vec3, glm::vec3> > vec3_data;
+	vector< std::pair<glm::vec4, glm::vec4> > vec4_data = getMeshEdgesVec4();
+
+	for (auto i : vec4_data)
+	{
+		std::pair<glm::vec3, glm::vec3> converted(glm::vec3(i.first), glm::vec3(i.second));
+		vec3_data.push_back(converted);
+	}
+
+	return vec3_data;
+}
+
+vector< vector<glm::vec4> > mesh_data::getMeshTrianglesVec4() const
+{
+	vector< vector<glm::vec4> > triangles;
+
+	for (auto i : faces)
+	{
+		vector<glm::vec4> triangle = {
+			i.at(0).xyzw,
+			i.at(1).xyzw,
+			i.at(2).xyzw
+		};
+
+		triangles.push_back(triangle);
+	}
+
+	return triangles;
+}
+
+vector< vector<glm::vec3> > mesh_data::getMeshTrianglesVec3() const
+{
+	vector< vector<glm::vec3> > triangles;
+
+	for (auto i : faces)
 	{
 		vector<glm::vec3> triangle = {
 			i.at(0).xyz,
@@ -525,314 +1226,1228 @@ vector< vector<glm::vec3> > mesh_data::getMeshTrianglesVec3() const
 			i.at(2).xyz
 		};
 
-		triangles.push_back(triangle);
+		triangles.push_back(triangle);
+	}
+
+	return triangles;
+}
+
+void mesh_data::updateBoundingVolumes(bool recompute_box)
+{
+	if (vertex_count == 0)
+	{
+		bounds_min = glm::vec3(0.0f, 0.0f, 0.0f);
+		bounds_max = glm::vec3(0.0f, 0.0f, 0.0f);
+		sphere = bounding_sphere();
+		return;
+	}
+
+	//unique vertices cover every position the faces use, compacted meshes fall back
+	//to whichever per-corner form is still held
+	point_set points;
+	if (representations & MESH_INDEXED)
+	{
+		points.reserve(vertex_map.size());
+		for (const auto &vertex : vertex_map)
+			points.addPoint(vertex.second.xyz);
+	}
+
+	else if (representations & MESH_FACES)
+	{
+		for (const auto &face : faces)
+		{
+			for (const auto &vertex : face)
+				points.addPoint(vertex.xyz);
+		}
+	}
+
+	else if (v_size >= 3)
+	{
+		for (int i = 0; i + v_size <= (int)all_v_data.size(); i += v_size)
+			points.addPoint(glm::vec3(all_v_data[i], all_v_data[i + 1], all_v_data[i + 2]));
+	}
+
+	if (points.getCount() == 0)
+		return;
+
+	points.pad();
+
+	if (recompute_box)
+		computeBounds(points, bounds_min, bounds_max);
+
+	sphere = computeBoundingSphere(points, bounds_min, bounds_max);
+}
+
+void mesh_data::setMeshData()
+{
+	OBJ_TRACE_ZONE("setMeshData");
+	updateBoundingVolumes(false);
+
+	if (faces.begin() != faces.end())
+	{
+		interleave_stride = faces.begin()->begin()->getStride();
+		interleave_vt_offset = faces.begin()->begin()->getUVOffset();
+		interleave_vn_offset = faces.begin()->begin()->getNOffset();
+
+		v_size = faces.begin()->begin()->getVSize();
+		vt_size = faces.begin()->begin()->getVTSize();
+		vn_size = faces.begin()->begin()->getVNSize();
+
+		total_float_count = (v_size + vt_size + vn_size) * vertex_count;
+	}
+}
+
+load_stats::load_stats()
+{
+	bytes = 0;
+	lines = 0;
+	faces = 0;
+	total_vertices = 0;
+	unique_vertices = 0;
+	allocations = 0;
+	fan_triangulated_faces = 0;
+	ear_clipped_faces = 0;
+	total_seconds = 0.0;
+
+	for (int i = 0; i < DATA_TYPE_COUNT; i++)
+		lines_by_type[i] = 0;
+
+	for (int i = 0; i < LOAD_PHASE_COUNT; i++)
+		phase_seconds[i] = 0.0;
+}
+
+obj_contents::obj_contents()
+{
+	beginParse(true);
+}
+
+obj_contents::obj_contents(const char* obj_file)
+{
+	OBJ_STATS(std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now());
+	OBJ_TRACE_ZONE_ARGS("load", obj_file, -1);
+
+	beginParse(false);
+	OBJ_TRACE(source_name = obj_file);
+
+	string error;
+	std::unique_ptr<input_source> source(openInputSource(obj_file, error));
+
+	if (!source)
+	{
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+		meshes.clear();
+		return;
+	}
+
+	parseSource(*source);
+
+	OBJ_STATS(stats.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+}
+
+obj_contents::obj_contents(input_source &source)
+{
+	OBJ_STATS(std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now());
+	OBJ_TRACE_ZONE("load");
+
+	beginParse(false);
+	parseSource(source);
+
+	OBJ_STATS(stats.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+}
+
+obj_contents::obj_contents(const char* obj_file, const spill_options &options)
+{
+	OBJ_STATS(std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now());
+	OBJ_TRACE_ZONE_ARGS("load", obj_file, -1);
+
+	beginParse(false);
+	OBJ_TRACE(source_name = obj_file);
+	spill = std::make_shared<spill_storage>(options);
+
+	string error;
+	std::unique_ptr<input_source> source(openInputSource(obj_file, error));
+
+	if (!source)
+	{
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+		meshes.clear();
+		return;
+	}
+
+	parseSource(*source);
+
+	vector<string> spill_errors = spill->getErrors();
+	error_log.insert(error_log.end(), spill_errors.begin(), spill_errors.end());
+
+	OBJ_STATS(stats.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+}
+
+obj_contents::obj_contents(const char* obj_file, const obj_group_index &index, const vector<string> &group_names)
+{
+	vector<bool> selected(index.getGroupCount(), false);
+	for (int i = 0; i < index.getGroupCount(); i++)
+		selected[i] = std::find(group_names.begin(), group_names.end(), index.getGroup(i).name) != group_names.end();
+
+	loadGroups(obj_file, index, selected);
+}
+
+obj_contents::obj_contents(const char* obj_file, const obj_group_index &index, const vector<int> &groups)
+{
+	vector<bool> selected(index.getGroupCount(), false);
+	for (auto group : groups)
+		selected[group] = true;
+
+	loadGroups(obj_file, index, selected);
+}
+
+void obj_contents::loadGroups(const char* obj_file, const obj_group_index &index, const vector<bool> &selected)
+{
+	OBJ_STATS(std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now());
+	OBJ_TRACE_ZONE_ARGS("load", obj_file, -1);
+
+	beginParse(false);
+	OBJ_TRACE(source_name = obj_file);
+	mtl_filename = index.getMTLFilename();
+
+	int group_total = index.getGroupCount();
+	vector<bool> referenced(group_total, false);
+
+	//first pass reads the selected blocks to find which other blocks their faces reach
+	//into, the second reads every needed block in file order and parses it
+	for (int pass = 0; pass < 2; pass++)
+	{
+		string error;
+		std::unique_ptr<input_source> source(openInputSource(obj_file, error));
+		if (!source)
+		{
+			std::cout << error << std::endl;
+			error_log.push_back(error);
+			meshes.clear();
+			return;
+		}
+
+		unsigned long long position = 0;
+		string block;
+		bool first_selected = true;
+
+		for (int i = 0; i < group_total; i++)
+		{
+			bool wanted = pass == 0 ? selected[i] : (selected[i] || referenced[i]);
+			if (!wanted)
+				continue;
+
+			const obj_group_range &group = index.getGroup(i);
+			block.resize(group.end - group.begin);
+
+			size_t bytes_read = 0;
+			{
+				OBJ_STATS_PHASE(&stats, PHASE_IO);
+				bool skipped = source->skip(group.begin - position);
+				while (skipped && bytes_read < block.size())
+				{
+					size_t chunk = source->read(&block[bytes_read], block.size() - bytes_read);
+					if (chunk == 0)
+						break;
+
+					bytes_read += chunk;
+				}
+			}
+
+			position = group.begin + bytes_read;
+			if (bytes_read != block.size())
+			{
+				string range_error = "obj file is shorter than its group index: ";
+				range_error += obj_file;
+				std::cout << range_error << std::endl;
+				error_log.push_back(range_error);
+				break;
+			}
+
+			if (pass == 0)
+			{
+				markReferencedGroups(block, index, i, referenced);
+				continue;
+			}
+
+			//counters are restored so attributes keep their file-wide numbering
+			v_index_counter = group.v_start;
+			vt_index_counter = group.vt_start;
+			vn_index_counter = group.vn_start;
+			vp_index_counter = group.vp_start;
+			attributes_only = !selected[i];
+
+			//selected blocks are not adjacent in the file, so each one closes the last mesh
+			if (selected[i])
+			{
+				if (!first_selected)
+				{
+					completeMesh();
+					meshes.push_back(mesh_data());
+				}
+
+				meshes.back().setMaterialName(group.material);
+				current_material = group.material;
+				end_of_vertex_data = false;
+				first_selected = false;
+			}
+
+			//blocks are fed out of file order, offsets restart at each block
+			OBJ_TRACE(fed_bytes = group.begin);
+			feed(block.data(), block.size());
+			flushPartialLine();
+		}
+
+		vector<string> source_errors = source->getErrors();
+		for (auto error : source_errors)
+		{
+			std::cout << error << std::endl;
+			error_log.push_back(error);
+		}
+	}
+
+	attributes_only = false;
+	finish();
+
+	OBJ_STATS(stats.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+}
+
+void obj_contents::markReferencedGroups(const string &block, const obj_group_index &index, int group, vector<bool> &referenced)
+{
+	const obj_group_range &range = index.getGroup(group);
+
+	const char* line_start = block.data();
+	const char* block_end = block.data() + block.size();
+
+	while (line_start < block_end)
+	{
+		const char* line_end = (const char*)memchr(line_start, '\n', block_end - line_start);
+		if (line_end == NULL)
+			line_end = block_end;
+
+		string line(line_start, trimCarriageReturn(line_start, line_end));
+		line_start = line_end + 1;
+
+		if (getDataType(line) != OBJ_F)
+			continue;
+
+		vector< vector<int> > face_sequence(extractFaceSequence(line));
+		for (const auto &sequence : face_sequence)
+		{
+			for (int n = 0; n < FACE_SLOT_COUNT && n < (int)sequence.size(); n++)
+			{
+				if (sequence[n] == 0)
+					continue;
+
+				int start, count;
+				switch (face_slot_types[n])
+				{
+				case OBJ_V: start = range.v_start; count = range.v_count; break;
+				case OBJ_VT: start = range.vt_start; count = range.vt_count; break;
+				case OBJ_VN: start = range.vn_start; count = range.vn_count; break;
+				default: start = range.vp_start; count = range.vp_count; break;
+				}
+
+				if (sequence[n] >= start && sequence[n] < start + count)
+					continue;
+
+				int owner = index.findAttributeGroup(face_slot_types[n], sequence[n]);
+				if (owner >= 0)
+					referenced[owner] = true;
+			}
+		}
+	}
+}
+
+void obj_contents::parseSource(input_source &source)
+{
+	vector<char> buffer(read_chunk_size);
+
+	for (;;)
+	{
+		//for compressed input this is the time spent waiting on the decompression thread
+		size_t bytes_read;
+		{
+			OBJ_STATS_PHASE(&stats, PHASE_IO);
+			OBJ_TRACE_ZONE_ARGS("read", source_name.empty() ? NULL : source_name.c_str(), fed_bytes);
+			bytes_read = source.read(&buffer[0], buffer.size());
+		}
+
+		if (bytes_read == 0)
+			break;
+
+		feed(&buffer[0], bytes_read);
+	}
+
+	finish();
+
+	vector<string> source_errors = source.getErrors();
+	for (auto error : source_errors)
+	{
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+	}
+}
+
+void obj_contents::beginParse(bool emit_meshes)
+{
+	v_index_counter = 1;
+	vt_index_counter = 1;
+	vn_index_counter = 1;
+	vp_index_counter = 1;
+
+	file_bounds_min = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	file_bounds_max = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	fed_bytes = 0;
+	line_offset = 0;
+	partial_offset = 0;
+
+	for (int n = 0; n < FACE_SLOT_COUNT; n++)
+	{
+		raw_sizes[n] = 0;
+		face_kernel_sizes[n] = 0;
+	}
+	face_kernel = NULL;
+	face_kernel_slots = 0;
+
+	emit_completed_meshes = emit_meshes;
+	parse_finished = false;
+	end_of_vertex_data = false;
+	attributes_only = false;
+
+	//the mesh being built, constructors drop it again if the file cannot be opened
+	meshes.push_back(mesh_data());
+}
+
+void obj_contents::feed(const char* data, size_t size)
+{
+	if (parse_finished)
+	{
+		error_log.push_back("obj data fed after finish() was called");
+		return;
+	}
+
+	OBJ_STATS(std::chrono::steady_clock::time_point feed_start = std::chrono::steady_clock::now());
+	OBJ_TRACE_ZONE_ARGS("parse", source_name.empty() ? NULL : source_name.c_str(), fed_bytes);
+	OBJ_STATS(stats.bytes += size);
+	OBJ_STATS(meshes.back().setLoadStats(&stats));
+
+	//complete lines are parsed straight from the chunk, a line split across
+	//chunks is carried in partial_line until its newline arrives
+	const char* line_start = data;
+	const char* data_end = data + size;
+
+	while (line_start < data_end)
+	{
+		const char* line_end = (const char*)memchr(line_start, '\n', data_end - line_start);
+		if (line_end == NULL)
+			break;
+
+		if (partial_line.empty())
+		{
+			OBJ_TRACE(line_offset = fed_bytes + (line_start - data));
+			processLine(string(line_start, trimCarriageReturn(line_start, line_end)));
+		}
+
+		else
+		{
+			OBJ_TRACE(line_offset = partial_offset);
+			partial_line.append(line_start, line_end);
+			partial_line.erase(trimCarriageReturn(partial_line.data(), partial_line.data() + partial_line.size()) - partial_line.data());
+			processLine(partial_line);
+			partial_line.clear();
+		}
+
+		line_start = line_end + 1;
+	}
+
+#ifdef OBJ_PARSER_TRACE
+	if (partial_line.empty())
+		partial_offset = fed_bytes + (line_start - data);
+	fed_bytes += size;
+#endif
+	partial_line.append(line_start, data_end);
+
+	if (!meshes.empty())
+		meshes.back().setLoadStats(NULL);
+
+	OBJ_STATS(stats.total_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - feed_start).count());
+}
+
+void obj_contents::finish()
+{
+	if (parse_finished)
+		return;
+
+	OBJ_STATS(meshes.back().setLoadStats(&stats));
+
+	flushPartialLine();
+	completeMesh();
+	parse_finished = true;
+
+	//a file without positions reports a point at the origin
+	if (spill ? v_index_counter == 1 : raw_v_data.empty())
+	{
+		file_bounds_min = glm::vec3(0.0f, 0.0f, 0.0f);
+		file_bounds_max = glm::vec3(0.0f, 0.0f, 0.0f);
+	}
+}
+
+void obj_contents::flushPartialLine()
+{
+	//the last line may not end with a newline
+	if (!partial_line.empty())
+	{
+		OBJ_TRACE(line_offset = partial_offset);
+		partial_line.erase(trimCarriageReturn(partial_line.data(), partial_line.data() + partial_line.size()) - partial_line.data());
+		processLine(partial_line);
+		partial_line.clear();
+	}
+}
+
+vector<mesh_data> obj_contents::takeCompletedMeshes()
+{
+	vector<mesh_data> taken;
+	taken.swap(completed_meshes);
+	return taken;
+}
+
+vector<mesh_data> obj_contents::takeMeshes()
+{
+	vector<mesh_data> taken;
+	taken.swap(meshes);
+	return taken;
+}
+
+void obj_contents::completeMesh()
+{
+	mesh_data &mesh = meshes.back();
+	mesh.setMeshData();
+	mesh.setLoadStats(NULL);
+
+	if (emit_completed_meshes)
+	{
+		completed_meshes.push_back(std::move(mesh));
+		meshes.pop_back();
+	}
+
+	else if (spill)
+	{
+		spill->addMesh(mesh);
+		meshes.pop_back();
+	}
+}
+
+void obj_contents::processLine(const string &line)
+{
+	OBJ_STATS(stats.lines++);
+
+	DATA_TYPE type;
+	{
+		OBJ_STATS_PHASE(&stats, PHASE_TOKENIZE);
+		type = getDataType(line);
+	}
+	OBJ_STATS(stats.lines_by_type[type]++);
+
+	if (type == UNDEFINED)
+		return;
+
+	//attributes are stored under their file-wide index, nothing else in the block applies
+	if (attributes_only)
+	{
+		if (type == OBJ_V || type == OBJ_VT || type == OBJ_VN || type == OBJ_VP)
+			addAttributeLine(line, type);
+
+		return;
+	}
+
+	//"g" prefix indicates the previous geometry data has ended
+	else if (type == OBJ_G)
+	{
+		meshes.back().setMeshName(extractName(line));
+		end_of_vertex_data = true;
+		return;
+	}
+
+	if (type == OBJ_USEMTL)
+	{
+		current_material = extractName(line);
+		meshes.back().setMaterialName(current_material);
+		return;
+	}
+
+	if (type == OBJ_MTLLIB)
+	{
+		mtl_filename = extractName(line);
+		return;
+	}
+
+	//detects if a new geometry is starting, resets params and operates on new mesh
+	if (type == OBJ_V && end_of_vertex_data)
+	{
+		completeMesh();
+
+		meshes.push_back(mesh_data());
+		meshes.back().setMaterialName(current_material);
+		OBJ_STATS(meshes.back().setLoadStats(&stats));
+		end_of_vertex_data = false;
+	}
+
+	mesh_data &current_mesh = meshes.back();
+
+	if (type == OBJ_V || type == OBJ_VT || type == OBJ_VN || type == OBJ_VP)
+	{
+		addAttributeLine(line, type);
+
+		//one map node and one float vector per raw attribute
+		OBJ_STATS(stats.allocations += 2);
+	}
+
+	else if (type == OBJ_F)
+	{
+		//face_data contains the index list for each line (each face)
+		//	1/1/1  2/2/2  3/3/3
+		vector< vector<int> > extracted_face_data;
+		{
+			OBJ_STATS_PHASE(&stats, PHASE_TOKENIZE);
+			extracted_face_data = extractFaceSequence(line);
+		}
+		
+		//generate vertex data objects from sequences passed
+		vector<vertex_data> extracted_vertices(assembleFaceVertices(extracted_face_data));
+
+		//from extracted vertices, create 1 face for triangulated meshes,
+		//separate convex quadrangulated meshes into 2 separate faces,
+		//concave quads and larger polygons are triangulated by addPolygon
+		if (extracted_face_data.size() == 3)
+		{
+			current_mesh.addTriangle(extracted_vertices[0], extracted_vertices[1], extracted_vertices[2]);
+		}
+
+		else if (extracted_face_data.size() == 4 && isConvexPolygon(extracted_vertices, polygonNormal(extracted_vertices)))
+		{
+			OBJ_STATS(stats.fan_triangulated_faces++);
+
+			current_mesh.addTriangle(extracted_vertices[0], extracted_vertices[1], extracted_vertices[3]);
+			current_mesh.addTriangle(extracted_vertices[1], extracted_vertices[2], extracted_vertices[3]);
+		}
+
+		else if (extracted_face_data.size() >= 4)
+			addPolygon(current_mesh, extracted_vertices);
+	}
+}
+
+vector<glm::vec3> mesh_data::calcTangentBitangent(const vector<vertex_data> &face_data)
+{
+	vertex_data v_data_0 = face_data[0];
+	vertex_data v_data_1 = face_data[1];
+	vertex_data v_data_2 = face_data[2];
+
+	//position-only faces have no uv space to derive tangents from
+	if (v_data_0.getVTSize() == 0 || v_data_1.getVTSize() == 0 || v_data_2.getVTSize() == 0)
+		return vector<glm::vec3> { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f) };
+
+	glm::vec3 v0(v_data_0.getVData()[0], v_data_0.getVData()[1], v_data_0.getVData()[2]);
+	glm::vec3 v1(v_data_1.getVData()[0], v_data_1.getVData()[1], v_data_1.getVData()[2]);
+	glm::vec3 v2(v_data_2.getVData()[0], v_data_2.getVData()[1], v_data_2.getVData()[2]);
+
+	glm::vec2 uv0(v_data_0.getVTData()[0], v_data_0.getVTData()[1]);
+	glm::vec2 uv1(v_data_1.getVTData()[0], v_data_1.getVTData()[1]);
+	glm::vec2 uv2(v_data_2.getVTData()[0], v_data_2.getVTData()[1]);
+
+	glm::vec3 deltaPos1 = v1 - v0;
+	glm::vec3 deltaPos2 = v2 - v0;
+
+	glm::vec2 deltaUV1 = uv1 - uv0;
+	glm::vec2 deltaUV2 = uv2 - uv0;
+
+	float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
+	glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
+	glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
+
+	return vector<glm::vec3> {tangent, bitangent};
+}
+
+const vector<vertex_data> obj_contents::assembleFaceVertices(const vector< vector<int> > &face_sequence)
+{
+	OBJ_STATS_PHASE(&stats, PHASE_FACE_ASSEMBLY);
+	OBJ_TRACE_ZONE_ARGS("face assembly", source_name.empty() ? NULL : source_name.c_str(), line_offset);
+
+	if (meshes.back().getFaceCount() == 0)
+		selectFaceAssembler(face_sequence);
+
+	vector<vertex_data> extracted_vertices;
+	extracted_vertices.reserve(face_sequence.size());
+
+	if (face_kernel != NULL && faceMatchesAssembler(face_sequence))
+		(this->*face_kernel)(face_sequence, extracted_vertices);
+
+	else assembleAnyFace(face_sequence, extracted_vertices);
+
+	return extracted_vertices;
+}
+
+//bit n is set when the corner has a nonzero index in slot n
+static int filledFaceSlots(const vector<int> &corner)
+{
+	int slots = 0;
+	for (int n = 0; n < FACE_SLOT_COUNT && n < (int)corner.size(); n++)
+	{
+		if (corner[n] != 0)
+			slots |= 1 << n;
+	}
+
+	return slots;
+}
+
+void obj_contents::selectFaceAssembler(const vector< vector<int> > &face_sequence)
+{
+	face_kernel = NULL;
+	if (face_sequence.empty())
+		return;
+
+	//"v", "v/vt", "v//vn" and "v/vt/vn" with 3 or 4 float positions, 2 float uvs and 3 float normals
+	static const face_assembler kernels[2][2][2] = {
+		{ { &obj_contents::assembleFixedFace<3, 0, 0>, &obj_contents::assembleFixedFace<3, 0, 3> },
+		  { &obj_contents::assembleFixedFace<3, 2, 0>, &obj_contents::assembleFixedFace<3, 2, 3> } },
+		{ { &obj_contents::assembleFixedFace<4, 0, 0>, &obj_contents::assembleFixedFace<4, 0, 3> },
+		  { &obj_contents::assembleFixedFace<4, 2, 0>, &obj_contents::assembleFixedFace<4, 2, 3> } }
+	};
+
+	int slots = filledFaceSlots(face_sequence[0]);
+	bool has_vt = (slots & 2) != 0;
+	bool has_vn = (slots & 4) != 0;
+
+	if (!(slots & 1) || (raw_sizes[0] != 3 && raw_sizes[0] != 4))
+		return;
+	if ((has_vt && raw_sizes[1] != 2) || (has_vn && raw_sizes[2] != 3))
+		return;
+
+	face_kernel = kernels[raw_sizes[0] - 3][has_vt][has_vn];
+	face_kernel_slots = slots;
+	face_kernel_sizes[0] = raw_sizes[0];
+	face_kernel_sizes[1] = has_vt ? 2 : 0;
+	face_kernel_sizes[2] = has_vn ? 3 : 0;
+}
+
+const bool obj_contents::faceMatchesAssembler(const vector< vector<int> > &face_sequence) const
+{
+	//attributes read after the kernel was picked may have changed size
+	for (int n = 0; n < FACE_SLOT_COUNT; n++)
+	{
+		if (face_kernel_sizes[n] != 0 && raw_sizes[n] != face_kernel_sizes[n])
+			return false;
+	}
+
+	for (const auto &corner : face_sequence)
+	{
+		if (filledFaceSlots(corner) != face_kernel_slots)
+			return false;
 	}
 
-	return triangles;
+	return true;
 }
 
-void mesh_data::setMeshData()
+template <int V_SIZE, int VT_SIZE, int VN_SIZE>
+void obj_contents::assembleFixedFace(const vector< vector<int> > &face_sequence, vector<vertex_data> &vertices)
 {
-	if (faces.begin() != faces.end())
+	for (const auto &corner : face_sequence)
 	{
-		interleave_stride = faces.begin()->begin()->getStride();
-		interleave_vt_offset = faces.begin()->begin()->getUVOffset();
-		interleave_vn_offset = faces.begin()->begin()->getNOffset();
+		const float* position = getRawPointer(OBJ_V, corner[0], position_scratch);
+		const float* uv = VT_SIZE > 0 ? getRawPointer(OBJ_VT, corner[1], uv_scratch) : NULL;
+		const float* normal = VN_SIZE > 0 ? getRawPointer(OBJ_VN, corner[2], normal_scratch) : NULL;
 
-		v_size = faces.begin()->begin()->getVSize();
-		vt_size = faces.begin()->begin()->getVTSize();
-		vn_size = faces.begin()->begin()->getVNSize();
+		vertices.push_back(vertex_data::fromAttributes<V_SIZE, VT_SIZE, VN_SIZE>(position, uv, normal));
 
-		total_float_count = (v_size + vt_size + vn_size) * faces.size();
+		//the attribute and interleaved buffers held by each vertex_data
+		OBJ_STATS(stats.allocations += 1 + (VT_SIZE > 0) + (VN_SIZE > 0) + 1);
 	}
 }
 
-obj_contents::obj_contents(const char* obj_file)
+void obj_contents::assembleAnyFace(const vector< vector<int> > &face_sequence, vector<vertex_data> &vertices)
 {
-	v_index_counter = 1;
-	vt_index_counter = 1;
-	vn_index_counter = 1;
-	vp_index_counter = 1;
+	for (int i = 0; i < face_sequence.size(); i++)
+	{
+		int v_index = 0;
+		int vt_index = 0;
+		int vn_index = 0;
+		int vp_index = 0;
+		vector<float> position_data;
+		vector<float> uv_data;
+		vector<float> normal_data;
+
+		//v/vt/vn slots are fixed, an empty slot ("1//3") was stored as 0
+		for (int n = 0; n < FACE_SLOT_COUNT && n < (int)face_sequence[i].size(); n++)
+		{
+			if (face_sequence[i][n] == 0)
+				continue;
 
-	fstream file;
-	file.open(obj_file, std::ifstream::in);
+			switch (face_slot_types[n])
+			{
+			case OBJ_V:
+				v_index = face_sequence[i][n];
+				getRawData(OBJ_V, v_index, position_data);
+				break;
+			case OBJ_VT:
+				vt_index = face_sequence[i][n];
+				getRawData(OBJ_VT, vt_index, uv_data);
+				break;
+			case OBJ_VN:
+				vn_index = face_sequence[i][n];
+				getRawData(OBJ_VN, vn_index, normal_data);
+				break;
+			case OBJ_VP:
+				vp_index = face_sequence[i][n];
+				break;
+			default: throw;
+			}
+		}
 
-	if (!file.is_open())
-	{
-		string error = "unable to open obj file: ";
-		error += obj_file;
-		std::cout << error << std::endl;
-		error_log.push_back(error);
-		file.close();
-		return;
+		vertex_data vert(position_data, uv_data, normal_data);
+		vertices.push_back(vert);
+
+		//attribute copies plus the interleaved buffer held by each vertex_data
+		OBJ_STATS(stats.allocations += 1 + (uv_data.size() > 0) + (normal_data.size() > 0) + 1);
 	}
+}
 
-	bool end_of_vertex_data = false;
+void obj_contents::addPolygon(mesh_data &mesh, const vector<vertex_data> &polygon)
+{
+	int polygon_size = polygon.size();
+	glm::vec3 normal = polygonNormal(polygon);
 
-	meshes.push_back(mesh_data());
-	vector<mesh_data>::iterator current_mesh = meshes.begin();
+	if (isConvexPolygon(polygon, normal))
+	{
+		OBJ_STATS(stats.fan_triangulated_faces++);
 
-	vector<DATA_TYPE> index_order;
+		//fan around the last vertex, the same split used for quads
+		for (int i = 0; i < polygon_size - 2; i++)
+			mesh.addTriangle(polygon[i], polygon[i + 1], polygon[polygon_size - 1]);
 
-	string current_material;
+		return;
+	}
 
-	while (!file.eof())
-	{
-		string line;
-		std::getline(file, line, '\n');
+	OBJ_STATS(stats.ear_clipped_faces++);
 
-		DATA_TYPE type = getDataType(line);
+	//project onto the plane of the dominant normal axis, flipped as needed so the
+	//polygon winds counter-clockwise in 2d. scratch buffers are reused between faces
+	int axis = 2;
+	if (abs(normal.x) > abs(normal.y) && abs(normal.x) > abs(normal.z))
+		axis = 0;
+	else if (abs(normal.y) > abs(normal.z))
+		axis = 1;
 
-		if (type == UNDEFINED)
-			continue;
+	float flip = normal[axis] < 0.0f ? -1.0f : 1.0f;
 
-		//"g" prefix indicates the previous geometry data has ended
-		else if (type == OBJ_G)
+	ear_points.clear();
+	ear_indices.clear();
+	for (int i = 0; i < polygon_size; i++)
+	{
+		const glm::vec3 &p = polygon[i].xyz;
+		switch (axis)
 		{
-			current_mesh->setMeshName(extractName(line));
-			end_of_vertex_data = true;
-			continue;
+		case 0: ear_points.push_back(glm::vec2(p.y * flip, p.z)); break;
+		case 1: ear_points.push_back(glm::vec2(p.z * flip, p.x)); break;
+		default: ear_points.push_back(glm::vec2(p.x * flip, p.y)); break;
 		}
+		ear_indices.push_back(i);
+	}
 
-		if (type == OBJ_USEMTL)
-		{
-			current_material = extractName(line);
-			current_mesh->setMaterialName(current_material);
-			continue;
-		}
+	int remaining = polygon_size;
+	int current = 0;
+	//counts vertices tested since the last ear was clipped, a full lap without an ear
+	//means the polygon is degenerate and the current vertex is clipped regardless
+	int attempts = 0;
 
-		if (type == OBJ_MTLLIB)
-		{
-			mtl_filename = extractName(line);
-			continue;
-		}
+	while (remaining > 3)
+	{
+		int previous = (current + remaining - 1) % remaining;
+		int next = (current + 1) % remaining;
+
+		const glm::vec2 &a = ear_points[ear_indices[previous]];
+		const glm::vec2 &b = ear_points[ear_indices[current]];
+		const glm::vec2 &c = ear_points[ear_indices[next]];
 
-		//detects if a new geometry is starting, resets params and operates on new mesh
-		if (type == OBJ_V && end_of_vertex_data)
+		bool is_ear = cross2D(a, b, c) > 0.0f;
+
+		for (int i = 0; i < remaining && is_ear; i++)
 		{
-			meshes.push_back(mesh_data());
-			current_mesh = meshes.end() - 1;
-			current_mesh->setMaterialName(current_material);
-			end_of_vertex_data = false;
-			index_order.clear();
+			if (i == previous || i == current || i == next)
+				continue;
+
+			//points on the candidate's edges also block it, a reflex vertex lying on the
+			//diagonal would otherwise let the ear cut outside the polygon
+			const glm::vec2 &p = ear_points[ear_indices[i]];
+			if (p == a || p == b || p == c)
+				continue;
+
+			if (cross2D(a, b, p) >= 0.0f && cross2D(b, c, p) >= 0.0f && cross2D(c, a, p) >= 0.0f)
+				is_ear = false;
 		}
 
-		if (type == OBJ_V || type == OBJ_VT || type == OBJ_VN || type == OBJ_VP)
+		if (is_ear || attempts >= remaining)
 		{
-			if (std::find(index_order.begin(), index_order.end(), type) == index_order.end())
-				index_order.push_back(type);
+			mesh.addTriangle(polygon[ear_indices[previous]], polygon[ear_indices[current]], polygon[ear_indices[next]]);
+			ear_indices.erase(ear_indices.begin() + current);
+			remaining--;
+			attempts = 0;
 
-			vector<float> floats(extractFloats(line));
-			addRawData(floats, type);
+			if (current >= remaining)
+				current = 0;
 		}
 
-		else if (type == OBJ_F)
+		else
 		{
-			//face_data contains the index list for each line (each face)
-			//	1/1/1  2/2/2  3/3/3
-			vector< vector<int> > extracted_face_data(extractFaceSequence(line));
-			
-			//generate vertex data objects from sequences passed
-			vector<vertex_data> extracted_vertices;
-			for (int i = 0; i < extracted_face_data.size(); i++)
-			{
-				int v_index = 0;
-				int vt_index = 0;
-				int vn_index = 0;
-				int vp_index = 0;
-				vector<float> position_data;
-				vector<float> uv_data;
-				vector<float> normal_data;
-
-				for (int n = 0; n < index_order.size(); n++)
-				{
-					if (v_index = extracted_face_data[i][n] == 0)
-						continue;
-
-					switch (index_order[n])
-					{
-					case OBJ_V:
-						v_index = extracted_face_data[i][n];
-						position_data = raw_v_data.at(v_index);
-						break;
-					case OBJ_VT:
-						vt_index = extracted_face_data[i][n];
-						uv_data = raw_vt_data.at(vt_index);
-						break;
-					case OBJ_VN:
-						vn_index = extracted_face_data[i][n];
-						normal_data = raw_vn_data.at(vn_index);
-						break;
-					case OBJ_VP:
-						vp_index = extracted_face_data[i][n];
-						break;
-					default: throw;
-					}
-				}
+			current = next;
+			attempts++;
+		}
+	}
 
-				vertex_data vert(position_data, uv_data, normal_data);
-				extracted_vertices.push_back(vert);
-			}
+	mesh.addTriangle(polygon[ear_indices[0]], polygon[ear_indices[1]], polygon[ear_indices[2]]);
+}
 
-			//from extracted vertices, create 1 face for triangulated meshes,
-			//separate quadrangulated meshes into 2 separate faces
-			if (extracted_face_data.size() == 3)
-			{
-				vector<vertex_data> face;
-				face.push_back(extracted_vertices[0]);
-				face.push_back(extracted_vertices[1]);
-				face.push_back(extracted_vertices[2]);
+const int obj_contents::getSpilledMeshCount() const
+{
+	return spill ? spill->getMeshCount() : 0;
+}
 
-				current_mesh->addFace(face);		
-			}
+const spilled_mesh obj_contents::getSpilledMesh(int n) const
+{
+	if (!spill)
+		throw std::out_of_range("obj_contents::getSpilledMesh");
 
-			else if (extracted_face_data.size() == 4)
-			{
-				vector<vertex_data> face_a;
-				face_a.push_back(extracted_vertices[0]);
-				face_a.push_back(extracted_vertices[1]);
-				face_a.push_back(extracted_vertices[3]);
-				current_mesh->addFace(face_a);
+	return spill->getMesh(n);
+}
 
-				for (vector<vertex_data>::iterator it = face_a.begin(); it != face_a.end(); it++)
-				{
-					current_mesh->addVData(it->getVData());
-					current_mesh->addVTData(it->getVTData());
-					current_mesh->addVNData(it->getVNData());
-				}
+const float* obj_contents::getSpilledVertices(int n) const
+{
+	return spill ? spill->getVertices(n) : NULL;
+}
 
-				vector<vertex_data> face_b;
-				face_b.push_back(extracted_vertices[1]);
-				face_b.push_back(extracted_vertices[2]);
-				face_b.push_back(extracted_vertices[3]);
-				current_mesh->addFace(face_b);
+const unsigned short* obj_contents::getSpilledIndices(int n) const
+{
+	return spill ? spill->getIndices(n) : NULL;
+}
 
-				for (vector<vertex_data>::iterator it = face_b.begin(); it != face_b.end(); it++)
-				{
-					current_mesh->addVData(it->getVData());
-					current_mesh->addVTData(it->getVTData());
-					current_mesh->addVNData(it->getVNData());
-				}
-			}
+mesh_data obj_contents::loadSpilledMesh(int n) const
+{
+	spilled_mesh spilled = getSpilledMesh(n);
+	const float* vertices = getSpilledVertices(n);
+	const unsigned short* indices = getSpilledIndices(n);
+	const vertex_layout &layout = spilled.layout;
+
+	//the indexed vertices hold each vertex's first occurrence, so replaying the
+	//triangles in order dedups to the same vertices and accumulates the same tangents
+	mesh_data mesh;
+	mesh.setMeshName(spilled.name);
+	mesh.setMaterialName(spilled.material);
+
+	//reused for every triangle, addFace copies it into the mesh
+	vector<vertex_data> face;
+	face.reserve(3);
+
+	for (int i = 0; i + 2 < spilled.index_total; i += 3)
+	{
+		face.clear();
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* vertex = vertices + (size_t)indices[i + corner] * layout.stride;
+			vector<float> position(vertex + layout.v_offset, vertex + layout.v_offset + layout.v_size);
+			vector<float> uv(vertex + layout.vt_offset, vertex + layout.vt_offset + layout.vt_size);
+			vector<float> normal(vertex + layout.vn_offset, vertex + layout.vn_offset + layout.vn_size);
+			face.push_back(vertex_data(position, uv, normal));
 		}
+		mesh.addFace(face);
 	}
-	file.close();
 
-	for (vector<mesh_data>::iterator it = meshes.begin(); it != meshes.end(); it++)
-		it->setMeshData();
+	mesh.setMeshData();
+	return mesh;
 }
-vector<glm::vec3> mesh_data::calcTangentBitangent(const vector<vertex_data> &face_data)
-{
-	vertex_data v_data_0 = face_data[0];
-	vertex_data v_data_1 = face_data[1];
-	vertex_data v_data_2 = face_data[2];
-
-	glm::vec3 v0(v_data_0.getVData()[0], v_data_0.getVData()[1], v_data_0.getVData()[2]);
-	glm::vec3 v1(v_data_1.getVData()[0], v_data_1.getVData()[1], v_data_1.getVData()[2]);
-	glm::vec3 v2(v_data_2.getVData()[0], v_data_2.getVData()[1], v_data_2.getVData()[2]);
 
-	glm::vec2 uv0(v_data_0.getVTData()[0], v_data_0.getVTData()[1]);
-	glm::vec2 uv1(v_data_1.getVTData()[0], v_data_1.getVTData()[1]);
-	glm::vec2 uv2(v_data_2.getVTData()[0], v_data_2.getVTData()[1]);
+void obj_contents::generateMissingNormals(float crease_angle, NORMAL_WEIGHTING weighting)
+{
+	for (auto &mesh : meshes)
+	{
+		if (mesh.getFaceCount() > 0 && mesh.getVNSize() == 0)
+			mesh.generateNormals(crease_angle, weighting);
+	}
+}
 
-	glm::vec3 deltaPos1 = v1 - v0;
-	glm::vec3 deltaPos2 = v2 - v0;
+void obj_contents::addAttributeLine(const string &line, DATA_TYPE dt)
+{
+	OBJ_STATS_PHASE(&stats, PHASE_FLOAT_PARSE);
 
-	glm::vec2 deltaUV1 = uv1 - uv0;
-	glm::vec2 deltaUV2 = uv2 - uv0;
+	int malformed_tokens;
+	vector<float> floats(extractFloats(line, &malformed_tokens));
 
-	float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-	glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
-	glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
+	//the line is still stored, dropping it would renumber every later attribute
+	if (malformed_tokens > 0)
+		error_log.push_back("malformed number read as 0: " + line);
 
-	return vector<glm::vec3> {tangent, bitangent};
+	addRawData(floats, dt);
 }
 
 void obj_contents::addRawData(const vector<float> &floats, DATA_TYPE dt)
 {
+	//spill pools are indexed in file order just as the counters are
+	if (spill)
+		spill->addRawData(floats, dt);
+
+	for (int n = 0; n < FACE_SLOT_COUNT; n++)
+	{
+		if (face_slot_types[n] == dt && raw_sizes[n] != (int)floats.size())
+			raw_sizes[n] = raw_sizes[n] == 0 ? (int)floats.size() : -1;
+	}
+
 	switch (dt)
 	{
 	case OBJ_V:
-		raw_v_data[v_index_counter] = floats;
+		if (!spill)
+			raw_v_data[v_index_counter] = floats;
 		v_index_counter++;
+
+		if (floats.size() >= 3)
+		{
+			file_bounds_min = glm::vec3(fminf(file_bounds_min.x, floats[0]), fminf(file_bounds_min.y, floats[1]), fminf(file_bounds_min.z, floats[2]));
+			file_bounds_max = glm::vec3(fmaxf(file_bounds_max.x, floats[0]), fmaxf(file_bounds_max.y, floats[1]), fmaxf(file_bounds_max.z, floats[2]));
+		}
 		break;
 	case OBJ_VT:
-		raw_vt_data[vt_index_counter] = floats;
+		if (!spill)
+			raw_vt_data[vt_index_counter] = floats;
 		vt_index_counter++;
 		break;
 	case OBJ_VN:
-		raw_vn_data[vn_index_counter] = floats;
+		if (!spill)
+			raw_vn_data[vn_index_counter] = floats;
 		vn_index_counter++;
 		break;
 	case OBJ_VP:
-		raw_vp_data[vp_index_counter] = floats;
+		if (!spill)
+			raw_vp_data[vp_index_counter] = floats;
 		vp_index_counter++;
 		break;
 	default: break;
 	}
 }
 
-const vector<float> extractFloats(const string &s)
+const float* obj_contents::getRawPointer(DATA_TYPE dt, int n, vector<float> &scratch) const
 {
-	vector<float> floats;
+	if (spill)
+	{
+		spill->getRawData(dt, n, scratch);
+		return scratch.data();
+	}
 
-	vector<int> digits;
+	switch (dt)
+	{
+	case OBJ_V: return raw_v_data.at(n).data();
+	case OBJ_VT: return raw_vt_data.at(n).data();
+	case OBJ_VN: return raw_vn_data.at(n).data();
+	case OBJ_VP: return raw_vp_data.at(n).data();
+	default: return NULL;
+	}
+}
+
+void obj_contents::getRawData(DATA_TYPE dt, int n, vector<float> &floats) const
+{
+	if (spill)
+	{
+		spill->getRawData(dt, n, floats);
+		return;
+	}
+
+	switch (dt)
+	{
+	case OBJ_V: floats = raw_v_data.at(n); break;
+	case OBJ_VT: floats = raw_vt_data.at(n); break;
+	case OBJ_VN: floats = raw_vn_data.at(n); break;
+	case OBJ_VP: floats = raw_vp_data.at(n); break;
+	default: floats.clear();
+	}
+}
+
+//case-insensitive comparison of [begin, end) with a lowercase word
+static bool tokenIsWord(const char* begin, const char* end, const char* word)
+{
+	for (; begin < end && *word != '\0'; begin++, word++)
+	{
+		if (tolower((unsigned char)*begin) != *word)
+			return false;
+	}
+
+	return begin == end && *word == '\0';
+}
+
+//[+-]digits[.digits][e[+-]digits], or [+-]inf, infinity or nan as the writer and printf
+//spell non-finite values. up to 19 significant digits and a power of ten of at
+//most 22 are combined exactly in double (clinger's fast path), so the double is correctly
+//rounded. rounding that to float is exact too unless the double sits on a float midpoint,
+//those and longer inputs go through the classic-locale stream conversion. values out of
+//float range saturate as strtof does, to infinity on overflow and to zero on underflow
+static bool parseFloatToken(const char* begin, const char* end, float &value)
+{
+	const char* cursor = begin;
 	bool negative = false;
-	bool decimal_found = false;
-	int decimal_places = 0;
-	bool values_begin = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+'))
+		negative = *cursor++ == '-';
 
-	for (int i = 0; i < s.size(); i++)
+	if (tokenIsWord(cursor, end, "inf") || tokenIsWord(cursor, end, "infinity"))
+	{
+		value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+		return true;
+	}
+
+	if (tokenIsWord(cursor, end, "nan"))
 	{
-		if (s[i] == '-')
-			negative = true;
+		value = negative ? -std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::quiet_NaN();
+		return true;
+	}
 
-		else if (s[i] == '.')
-			decimal_found = true;
+	unsigned long long mantissa = 0;
+	int significant_digits = 0;
+	int exponent = 0;
+	bool digits_found = false;
 
-		else if (s[i] >= '0' && s[i] <= '9')
+	for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+	{
+		digits_found = true;
+		if (mantissa == 0 && *cursor == '0')
+			continue;
+
+		if (significant_digits < 19)
 		{
-			int char_int = '0';
-			char_int = s[i] - char_int;
-			digits.push_back(char_int);
-			if (decimal_found)
-				decimal_places++;
+			mantissa = mantissa * 10 + (*cursor - '0');
+			significant_digits++;
 		}
 
-		//if space found or end of string
-		if ((s[i] == ' ' && values_begin) || i == s.size() - 1)
+		else exponent++;
+	}
+
+	if (cursor < end && *cursor == '.')
+	{
+		for (cursor++; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
 		{
-			float extracted = 0;
+			digits_found = true;
+			if (mantissa == 0 && *cursor == '0')
+			{
+				exponent--;
+				continue;
+			}
 
-			for (int n = 0; n < digits.size(); n++)
+			if (significant_digits < 19)
 			{
-				//example--> 470.258
-				//size = 6
-				//decimal_places = 3
-				//first iteration of loop points to 4, which is in the
-				//10^2 location. 
-				//6 - 3 - 1 - 0 = 2 for the first loop
-				//6 - 3 - 1 - 1 = 1 for the second loop
-				int nth = digits.size() - decimal_places - 1 - n;
-				float multiplier = pow(10.0f, float(nth));
-				float toAdd = digits[n] * multiplier;
-				extracted += toAdd;
+				mantissa = mantissa * 10 + (*cursor - '0');
+				significant_digits++;
+				exponent--;
 			}
-			
-			if (negative)
-				extracted *= -1.0f;
+		}
+	}
 
-			floats.push_back(extracted);
+	if (!digits_found)
+		return false;
 
-			//resets counters
-			digits.clear();
-			negative = false;
-			decimal_found = false;
-			decimal_places = 0;
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		const char* exponent_start = ++cursor;
+		bool exponent_negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+'))
+			exponent_negative = *cursor++ == '-';
+
+		int written_exponent = 0;
+		for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+		{
+			if (written_exponent < 100000)
+				written_exponent = written_exponent * 10 + (*cursor - '0');
 		}
 
-		else if (s[i] == ' ' && !values_begin)
-			values_begin = true;
+		if (cursor == exponent_start)
+			return false;
+
+		exponent += exponent_negative ? -written_exponent : written_exponent;
+	}
+
+	if (cursor != end)
+		return false;
+
+	static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	if (mantissa == 0)
+	{
+		value = negative ? -0.0f : 0.0f;
+		return true;
+	}
+
+	if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double exact = exponent < 0 ? double(mantissa) / powers_of_ten[-exponent] : double(mantissa) * powers_of_ten[exponent];
+
+		unsigned long long bits;
+		memcpy(&bits, &exact, sizeof(bits));
+
+		//29 low bits of exactly 1 followed by zeros means a float rounding tie
+		if ((bits & 0x1FFFFFFFull) != 0x10000000ull)
+		{
+			value = negative ? -float(exact) : float(exact);
+			return true;
+		}
+	}
+
+	std::istringstream stream(string(begin, end));
+	stream.imbue(std::locale::classic());
+	stream >> value;
+
+	//the token is well formed by now, so the stream only fails on a range error
+	if (stream.fail())
+	{
+		float magnitude = exponent + significant_digits > 0 ? std::numeric_limits<float>::infinity() : 0.0f;
+		value = negative ? -magnitude : magnitude;
+	}
+
+	return true;
+}
+
+const vector<float> extractFloats(const string &s, int* malformed_tokens)
+{
+	vector<float> floats;
+	if (malformed_tokens != NULL)
+		*malformed_tokens = 0;
+
+	//values begin after the first space, past the "v", "vt", ... prefix
+	const char* cursor = s.c_str();
+	const char* line_end = cursor + s.size();
+	const char* values_begin = (const char*)memchr(cursor, ' ', s.size());
+	if (values_begin == NULL)
+		return floats;
+
+	cursor = values_begin;
+	while (cursor < line_end)
+	{
+		while (cursor < line_end && (*cursor == ' ' || *cursor == '\t'))
+			cursor++;
+
+		const char* token_end = cursor;
+		while (token_end < line_end && *token_end != ' ' && *token_end != '\t')
+			token_end++;
+
+		//a token that is not a number still takes its place, so later values keep their position
+		float value;
+		if (token_end > cursor)
+		{
+			if (!parseFloatToken(cursor, token_end, value))
+			{
+				value = 0.0f;
+				if (malformed_tokens != NULL)
+					(*malformed_tokens)++;
+			}
+
+			floats.push_back(value);
+		}
+
+		cursor = token_end;
 	}
 
 	return floats;
@@ -856,17 +2471,12 @@ const vector< vector<int> > extractFaceSequence(const string &s)
 				continue;
 			}
 
-			float extracted = 0;
-
+			//accumulated as an integer, float sums lose indices above 2^24
+			int extracted = 0;
 			for (int n = 0; n < digits.size(); n++)
-			{
-				int nth = digits.size() - 1 - n;
-				float multiplier = pow(10.0f, float(nth));
-				float toAdd = digits[n] * multiplier;
-				extracted += toAdd;
-			}
+				extracted = extracted * 10 + digits[n];
 
-			sequence.push_back(int(extracted));
+			sequence.push_back(extracted);
 
 			//resets counters
 			digits.clear();
@@ -882,17 +2492,12 @@ const vector< vector<int> > extractFaceSequence(const string &s)
 		//if space found or end of string
 		if ((s[i] == ' ' && values_begin) || i == s.size() - 1)
 		{
-			float extracted = 0;
-
+			//accumulated as an integer, float sums lose indices above 2^24
+			int extracted = 0;
 			for (int n = 0; n < digits.size(); n++)
-			{
-				int nth = digits.size() - 1 - n;
-				float multiplier = pow(10.0f, float(nth));
-				float toAdd = digits[n] * multiplier;
-				extracted += toAdd;
-			}
+				extracted = extracted * 10 + digits[n];
 
-			sequence.push_back(int(extracted));
+			sequence.push_back(extracted);
 			index_list.push_back(sequence);
 
 			//resets counters
@@ -907,6 +2512,56 @@ const vector< vector<int> > extractFaceSequence(const string &s)
 	return index_list;
 }
 
+const char* trimCarriageReturn(const char* line_start, const char* line_end)
+{
+	//input is read in binary, windows line endings leave a '\r' before the newline
+	if (line_end > line_start && *(line_end - 1) == '\r')
+		return line_end - 1;
+
+	return line_end;
+}
+
+const glm::vec3 polygonNormal(const vector<vertex_data> &polygon)
+{
+	//newell's method, stable for concave and slightly non-planar polygons
+	glm::vec3 normal(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < polygon.size(); i++)
+	{
+		const glm::vec3 &current = polygon[i].xyz;
+		const glm::vec3 &next = polygon[(i + 1) % polygon.size()].xyz;
+		normal.x += (current.y - next.y) * (current.z + next.z);
+		normal.y += (current.z - next.z) * (current.x + next.x);
+		normal.z += (current.x - next.x) * (current.y + next.y);
+	}
+
+	return normal;
+}
+
+const bool isConvexPolygon(const vector<vertex_data> &polygon, const glm::vec3 &normal)
+{
+	//degenerate polygons have no meaningful winding, fanning them is as good as anything
+	if (glm::dot(normal, normal) < 1e-20f)
+		return true;
+
+	int polygon_size = polygon.size();
+	for (int i = 0; i < polygon_size; i++)
+	{
+		const glm::vec3 &previous = polygon[(i + polygon_size - 1) % polygon_size].xyz;
+		const glm::vec3 &current = polygon[i].xyz;
+		const glm::vec3 &next = polygon[(i + 1) % polygon_size].xyz;
+
+		if (glm::dot(glm::cross(current - previous, next - current), normal) < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+const float cross2D(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
 const string extractName(const string &line)
 {
 	string name;
@@ -6,8 +6,15 @@
 #include <fstream>
 #include <map>
 #include <math.h>
+#include <float.h>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <stdint.h>
 #include <glm.hpp>
+#include "mesh_bounds.h"
 
 using std::string;
 using std::map;
@@ -18,20 +25,164 @@ class vertex_data;
 class material_data;
 class mesh_data;
 class obj_contents;
+class input_source;
+class obj_group_index;
+class spill_storage;
+struct load_stats;
 
 #define PRINTLINE std::cout << __FILE__ << ", " << __LINE__ << std::endl;
 
+//load statistics are collected unless OBJ_PARSER_NO_STATS is defined, in which case
+//getLoadStats() returns a zeroed struct and the counters compile away
+#ifndef OBJ_PARSER_NO_STATS
+#define OBJ_STATS_PHASE(stats, phase) phase_timer obj_phase_timer(stats, phase)
+#define OBJ_STATS(statement) statement
+#else
+#define OBJ_STATS_PHASE(stats, phase)
+#define OBJ_STATS(statement)
+#endif
+
 enum DATA_TYPE { UNDEFINED, OBJ_MTLLIB, OBJ_F, OBJ_V, OBJ_VT, OBJ_VN, OBJ_VP, OBJ_G, OBJ_USEMTL,
 				MTL_NEWMTL, MTL_KA, MTL_KD, MTL_KS, MTL_NS, MTL_D, 
-				MTL_MAP_KA, MTL_MAP_KD, MTL_MAP_KS, MTL_MAP_D, MTL_MAP_NS, MTL_MAP_BUMP, MTL_MAP_DISP, MTL_DECAL
+				MTL_MAP_KA, MTL_MAP_KD, MTL_MAP_KS, MTL_MAP_D, MTL_MAP_NS, MTL_MAP_BUMP, MTL_MAP_DISP, MTL_DECAL,
+				DATA_TYPE_COUNT
+};
+
+enum NORMAL_WEIGHTING { NORMAL_WEIGHT_AREA, NORMAL_WEIGHT_ANGLE };
+
+//forms of the geometry mesh_data holds, combined as flags for mesh_data::compact
+enum MESH_REPRESENTATION { MESH_FACES = 1, MESH_ATTRIBUTE_LISTS = 2, MESH_INDEXED = 4, MESH_CORNER_TANGENTS = 8,
+				MESH_ALL_REPRESENTATIONS = 15
 };
 
-const vector<float> extractFloats(const string &s);
+enum LOAD_PHASE { PHASE_IO, PHASE_TOKENIZE, PHASE_FLOAT_PARSE, PHASE_FACE_ASSEMBLY, PHASE_DEDUP, PHASE_TANGENTS,
+				LOAD_PHASE_COUNT
+};
+
+//attribute each index of a face corner refers to, "f v/vt/vn" as in the obj spec
+const int FACE_SLOT_COUNT = 3;
+const DATA_TYPE face_slot_types[FACE_SLOT_COUNT] = { OBJ_V, OBJ_VT, OBJ_VN };
+
+//tokens that are not numbers are read as 0 and counted in malformed_tokens
+const vector<float> extractFloats(const string &s, int* malformed_tokens = NULL);
 const vector< vector<int> > extractFaceSequence(const string &s);
 const vector<mesh_data> generateMeshes(const char* file_path);
 const map<string, material_data> generateMaterials(const char* file_path);
 const DATA_TYPE getDataType(const string &line);
 const string extractName(const string &line);
+const char* trimCarriageReturn(const char* line_start, const char* line_end);
+const glm::vec3 polygonNormal(const vector<vertex_data> &polygon);
+const bool isConvexPolygon(const vector<vertex_data> &polygon, const glm::vec3 &normal);
+const float cross2D(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c);
+
+struct load_stats
+{
+	load_stats();
+
+	unsigned long long bytes;
+	unsigned long long lines;
+	unsigned long long lines_by_type[DATA_TYPE_COUNT];
+	unsigned long long faces;
+	//vertices passed to addFace, and how many of them were new after deduplication
+	unsigned long long total_vertices;
+	unsigned long long unique_vertices;
+	//heap buffers created for raw attributes and per-vertex copies, an estimate
+	//from the containers the parser fills rather than an allocator hook
+	unsigned long long allocations;
+	//polygons of 4+ vertices split by a fan around the last vertex, or by ear clipping when concave
+	unsigned long long fan_triangulated_faces;
+	unsigned long long ear_clipped_faces;
+
+	//wall time spent in each LOAD_PHASE, and for the whole load
+	double phase_seconds[LOAD_PHASE_COUNT];
+	double total_seconds;
+};
+
+//adds the time spent in its scope to a phase of the load_stats passed, does nothing if stats is NULL
+class phase_timer
+{
+public:
+	phase_timer(load_stats* s, LOAD_PHASE p) : stats(s), phase(p)
+	{
+		if (stats != NULL)
+			start = std::chrono::steady_clock::now();
+	}
+
+	~phase_timer()
+	{
+		if (stats != NULL)
+			stats->phase_seconds[phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	load_stats* stats;
+	LOAD_PHASE phase;
+	std::chrono::steady_clock::time_point start;
+};
+
+//heap bytes held by each container of a mesh_data, map nodes are estimated
+struct mesh_memory_usage
+{
+	mesh_memory_usage() : faces(0), attribute_lists(0), vertex_map(0), tangent_maps(0), element_index(0), corner_tangents(0) {};
+
+	const size_t getTotal() const { return faces + attribute_lists + vertex_map + tangent_maps + element_index + corner_tangents; }
+
+	size_t faces;
+	size_t attribute_lists;
+	size_t vertex_map;
+	size_t tangent_maps;
+	size_t element_index;
+	size_t corner_tangents;
+};
+
+//layout of one vertex in an interleaved float buffer, offsets and sizes in floats,
+//a size of 0 means the attribute is absent
+struct vertex_layout
+{
+	vertex_layout() : stride(0), v_offset(0), v_size(0), vt_offset(0), vt_size(0), vn_offset(0), vn_size(0),
+		tan_offset(0), tan_size(0), bitan_offset(0), bitan_size(0) {};
+
+	int stride;
+	int v_offset;
+	int v_size;
+	int vt_offset;
+	int vt_size;
+	int vn_offset;
+	int vn_size;
+	int tan_offset;
+	int tan_size;
+	int bitan_offset;
+	int bitan_size;
+};
+
+//out-of-core parsing keeps raw attributes and finished meshes in memory-mapped temp
+//files under directory. once resident_budget bytes have been written the mapped pages
+//are handed back to the kernel, which pages them in again as faces reference them
+struct spill_options
+{
+	spill_options() : directory("/tmp"), resident_budget((size_t)256 << 20) {};
+
+	string directory;
+	size_t resident_budget;
+};
+
+//a finished mesh moved to a spill file, its vertices are in layout as returned by
+//getIndexedVertexData. offsets are in bytes into the spill files
+struct spilled_mesh
+{
+	spilled_mesh() : vertex_offset(0), vertex_total(0), index_offset(0), index_total(0),
+		bounds_min(0.0f, 0.0f, 0.0f), bounds_max(0.0f, 0.0f, 0.0f) {};
+
+	string name;
+	string material;
+	vertex_layout layout;
+	size_t vertex_offset;
+	int vertex_total;
+	size_t index_offset;
+	int index_total;
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+};
 
 class vertex_data
 {
@@ -53,8 +204,18 @@ public:
 			throw;
 	}
 
+	vertex_data(const vertex_data &other) = default;
+	vertex_data(vertex_data &&other) = default;
 	~vertex_data(){};
 
+	//builds a vertex from attributes of sizes the caller has already validated, the
+	//per-format face assembly uses it in place of the checking constructor
+	template <int V_SIZE, int VT_SIZE, int VN_SIZE>
+	static const vertex_data fromAttributes(const float* p, const float* uv, const float* n);
+
+	vertex_data& operator = (const vertex_data &other) = default;
+	vertex_data& operator = (vertex_data &&other) = default;
+
 	const int getUVOffset() const { return v_data.size() * sizeof(float); }
 	const int getNOffset() const { return getUVOffset() + (vt_data.size() * sizeof(float)); }
 	const int getStride() const { return all_data.size() * sizeof(float); }
@@ -69,10 +230,19 @@ public:
 	void modifyPosition(const glm::mat4 &translation_matrix);
 	//rotate modifies position data and normals
 	void rotate(const glm::mat4 &rotation_matrix);
+	//replaces the normal, adding one if the vertex had none
+	void setNormal(const glm::vec3 &normal);
 
 	vector<float> getAllData() const { return all_data; }
-
-	bool operator == (const vertex_data &other);
+	//writes the same floats as getAllData(), returns the position after the last one
+	float* copyAllData(float* destination) const;
+	//copyAllData for a vertex known to hold STRIDE floats
+	template <int STRIDE>
+	float* copyFixedData(float* destination) const { return std::copy(all_data.data(), all_data.data() + STRIDE, destination); }
+	//heap bytes held by the attribute vectors, not counting the object itself
+	const size_t getHeapBytes() const;
+
+	bool operator == (const vertex_data &other) const;
 	bool operator != (const vertex_data &other) { return !((*this) == other); }
 
 	float x, y, z, w;
@@ -88,7 +258,8 @@ public:
 	glm::vec3 n_xyz;
 
 private:
-	
+	vertex_data() {};
+
 	void setVertexData();
 	vector<float> v_data;
 	vector<float> vt_data;
@@ -100,12 +271,67 @@ private:
 	unsigned short v_count, vt_count, vn_count, vp_count;
 };
 
+template <int V_SIZE, int VT_SIZE, int VN_SIZE>
+const vertex_data vertex_data::fromAttributes(const float* p, const float* uv, const float* n)
+{
+	vertex_data vertex;
+	vertex.v_count = V_SIZE;
+	vertex.vt_count = VT_SIZE;
+	vertex.vn_count = VN_SIZE;
+	vertex.vp_count = 0;
+
+	vertex.v_data.assign(p, p + V_SIZE);
+	vertex.all_data.resize(V_SIZE + VT_SIZE + VN_SIZE);
+	float* all = std::copy(p, p + V_SIZE, vertex.all_data.data());
+
+	vertex.x = p[0];
+	vertex.y = p[1];
+	vertex.z = p[2];
+	vertex.w = V_SIZE > 3 ? p[V_SIZE - 1] : 1.0f;
+	vertex.xy = glm::vec2(p[0], p[1]);
+	vertex.xyz = glm::vec3(p[0], p[1], p[2]);
+	vertex.xyzw = glm::vec4(p[0], p[1], p[2], vertex.w);
+
+	vertex.u = 0.0f;
+	vertex.v = 0.0f;
+	if (VT_SIZE > 0)
+	{
+		vertex.vt_data.assign(uv, uv + VT_SIZE);
+		all = std::copy(uv, uv + VT_SIZE, all);
+		vertex.u = uv[0];
+		vertex.v = uv[1];
+	}
+	vertex.uv = glm::vec2(vertex.u, vertex.v);
+
+	vertex.n_x = 0.0f;
+	vertex.n_y = 0.0f;
+	vertex.n_z = 0.0f;
+	if (VN_SIZE > 0)
+	{
+		vertex.vn_data.assign(n, n + VN_SIZE);
+		std::copy(n, n + VN_SIZE, all);
+		vertex.n_x = n[0];
+		vertex.n_y = n[1];
+		vertex.n_z = n[2];
+	}
+	vertex.n_xy = glm::vec2(vertex.n_x, vertex.n_y);
+	vertex.n_xyz = glm::vec3(vertex.n_x, vertex.n_y, vertex.n_z);
+
+	return vertex;
+}
+
 class mesh_data
 {
 public:
-	mesh_data() : total_face_count(0), vertex_count(0) {};
+	mesh_data() : vertex_lookup_size(0), v_size(0), vt_size(0), vn_size(0), vertex_count(0), total_face_count(0), total_float_count(0), bounds_min(FLT_MAX), bounds_max(-FLT_MAX),
+		representations(MESH_ALL_REPRESENTATIONS), face_stride(0), stats(NULL) {};
+	mesh_data(const mesh_data &other) = default;
+	mesh_data(mesh_data &&other) = default;
 	~mesh_data(){};
 
+	mesh_data& operator = (const mesh_data &other) = default;
+	mesh_data& operator = (mesh_data &&other) = default;
+
 	void setMeshName(string n) { mesh_name = n; }
 	void setMaterialName(string n) { material_name = n; }
 
@@ -118,6 +344,12 @@ public:
 	void addVNData(const vector<float> &data) { all_vn_data.insert(all_vn_data.end(), data.begin(), data.end()); }
 	void addVPData(const vector<float> &data) { all_vp_data.insert(all_vp_data.end(), data.begin(), data.end()); }
 	void addFace(const vector<vertex_data> &data);
+	void addTriangle(const vertex_data &a, const vertex_data &b, const vertex_data &c);
+	//adds triangles with tangents and deduplication spread over threads. the result
+	//matches calling addFace for each in order whenever duplicate vertices are bitwise
+	//equal, as they are when parsed from the same text. batches holding other polygons
+	//or a different vertex layout go through addFace one face at a time
+	void addFaces(const vector< vector<vertex_data> > &triangles);
 	void addTangentBitangent(const vector<glm::vec3> &tb);
 	vector<glm::vec3> calcTangentBitangent(const vector<vertex_data> &face_data);
 
@@ -133,6 +365,16 @@ public:
 	//const vector<float> getIndexedBiangentData(vector<unsigned short> &indices) const;
 
 	const vector<unsigned short> getElementIndex() const { return element_index; }
+	const int getElementIndexCount() const { return element_index.size(); }
+	//writes getElementIndex() straight into a buffer of getElementIndexCount() indices
+	void copyElementIndex(unsigned short* destination) const;
+	//the index buffer itself, it stays put when the mesh is moved
+	const unsigned short* getElementIndexBuffer() const { return element_index.data(); }
+	const int getIndexedVertexCount() const { return vertex_map.size(); }
+	//writes getIndexedVertexData() straight into a buffer of getIndexedVertexCount() * stride floats
+	void copyIndexedVertexData(float* destination) const;
+	//describes one vertex of getIndexedVertexData(): position, uv, normal, tangent, bitangent
+	const vertex_layout getIndexedVertexLayout() const;
 
 	vector< vector<float> > getTriangles();
 	vector< vector<float> > getQuads();
@@ -161,13 +403,38 @@ public:
 	//rotate modifies position data and normals
 	void rotate(const glm::mat4 &rotation_matrix);
 
+	//replaces vertex normals with smoothed face normals, weighted by triangle area or
+	//corner angle. faces meeting at more than crease_angle degrees keep separate
+	//normals, which splits the shared vertex. indexed and interleaved data are rebuilt
+	void generateNormals(float crease_angle = 180.0f, NORMAL_WEIGHTING weighting = NORMAL_WEIGHT_ANGLE);
+
 	vector< std::pair<glm::vec4, glm::vec4> > getMeshEdgesVec4() const;
 	vector< std::pair<glm::vec3, glm::vec3> > getMeshEdgesVec3() const;
 	vector< vector<glm::vec4> >getMeshTrianglesVec4() const;
 	vector< vector<glm::vec3> >getMeshTrianglesVec3() const;
 
+	//bounds of the positions used by the mesh's faces, tracked while faces are added
+	//and refreshed by modifyPosition/rotate. empty meshes report a point at the origin
+	const glm::vec3 getBoundsMin() const { return bounds_min; }
+	const glm::vec3 getBoundsMax() const { return bounds_max; }
+	//computed by setMeshData
+	const bounding_sphere getBoundingSphere() const { return sphere; }
+
 	void setMeshData();
 
+	const mesh_memory_usage memoryUsage() const;
+	//releases every representation not in keep (MESH_REPRESENTATION flags) and trims the
+	//rest to size. call once loading is done, addFace expects every representation.
+	//	MESH_FACES: getInterleaveData, getMeshEdges*, getMeshTriangles*
+	//	MESH_ATTRIBUTE_LISTS: getVData, getVTData, getVNData, getVPData
+	//	MESH_INDEXED: getIndexedVertexData, getElementIndex, generateNormals
+	//	MESH_CORNER_TANGENTS: per-corner tangents and bitangents
+	void compact(int keep);
+	const int getRepresentations() const { return representations; }
+
+	//while set, addFace records dedup and tangent timings into the stats passed
+	void setLoadStats(load_stats* s) { stats = s; }
+
 private:
 	//vector of faces, each face is a vector of vertices
 	vector< vector<vertex_data> > faces;
@@ -176,6 +443,12 @@ private:
 	map<unsigned short, glm::vec3> bitangent_map;
 
 	vector<unsigned short> element_index;
+
+	//bit pattern hashes of the vertex_map entries with keys below vertex_lookup_size, so
+	//addFaces matches new corners without revisiting every indexed vertex. anything that
+	//edits vertex_map in place calls resetVertexLookup and the next addFaces rebuilds it
+	std::unordered_multimap<uint64_t, unsigned short> vertex_lookup;
+	int vertex_lookup_size;
 	
 	vector<glm::vec3> tangents;
 	vector<glm::vec3> bitangents;
@@ -207,14 +480,55 @@ private:
 	//# of faces are stored total
 	int total_face_count;
 	int total_float_count;
+
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+	bounding_sphere sphere;
+	void updateBoundingVolumes(bool recompute_box);
+	//refills the attribute lists from faces, or from the index once faces are released
+	void rebuildAttributeLists();
+	//updates attribute lists kept without faces or the index to rebuild them from
+	void transformAttributeLists(const glm::mat4 &matrix, bool rotate_normals);
+
+	int representations;
+	//floats per vertex shared by every face, 0 before the first face and -1 once they
+	//differ. picks the fixed-stride interleave kernels
+	int face_stride;
+	void trackFaceStride(const vector<vertex_data> &face);
+	//bounds, buffers, tangents and indices for the face just appended to faces
+	void indexLastFace();
+	void resetVertexLookup();
+	template <int STRIDE>
+	const vector<float> interleaveFaces() const;
+	template <int STRIDE>
+	void copyIndexedVertices(float* destination) const;
+	load_stats* stats;
 };
 
 class obj_contents
 {
 public:
+	//push mode, the caller passes the file contents to feed() in chunks of any size and
+	//collects each mesh with takeCompletedMeshes() once the group following it starts
+	obj_contents();
+	//gzip and zstd compressed files are detected and decompressed while parsing
 	obj_contents(const char* obj_file);
+	obj_contents(input_source &source);
+	//parses only the blocks of the named groups, plus the attribute lines of any
+	//other block their faces reference, using byte ranges from the group index
+	obj_contents(const char* obj_file, const obj_group_index &index, const vector<string> &group_names);
+	//same, for the blocks at the given positions in the index
+	obj_contents(const char* obj_file, const obj_group_index &index, const vector<int> &groups);
+	//out-of-core mode, raw attributes and each finished mesh go to spill files instead of
+	//the raw data maps and getMeshes(), only the mesh being built stays on the heap
+	obj_contents(const char* obj_file, const spill_options &options);
 	~obj_contents(){};
 
+	void feed(const char* data, size_t size);
+	//parses any unterminated last line and completes the final mesh
+	void finish();
+	vector<mesh_data> takeCompletedMeshes();
+
 	const map<int, vector<float> > getAllRawVData() const { return raw_v_data; }
 	const map<int, vector<float> > getAllRawVTData() const { return raw_vt_data; }
 	const map<int, vector<float> > getAllRawVNData() const { return raw_vn_data; }
@@ -225,15 +539,56 @@ public:
 	const vector<float> getRawVNData(int n) const { return raw_vn_data.at(n); }
 	const vector<float> getRawVPData(int n) const { return raw_vp_data.at(n); }
 
+	//in push mode, meshes are handed out by takeCompletedMeshes() and are not kept here
 	const int getMeshCount() const { return meshes.size(); }
 	const vector<mesh_data> getMeshes() const { return meshes; }
+	//moves the meshes out, getMeshes() is empty afterwards
+	vector<mesh_data> takeMeshes();
 
 	vector<string> getErrors() const { return error_log; }
+	const load_stats getLoadStats() const { return stats; }
 
 	const string getMTLFilename() const { return mtl_filename; }
 
+	//bounds of every "v" line in the file, referenced by a face or not
+	const glm::vec3 getBoundsMin() const { return file_bounds_min; }
+	const glm::vec3 getBoundsMax() const { return file_bounds_max; }
+
+	//out-of-core results, the pointers stay valid while this obj_contents exists
+	const int getSpilledMeshCount() const;
+	const spilled_mesh getSpilledMesh(int n) const;
+	const float* getSpilledVertices(int n) const;
+	const unsigned short* getSpilledIndices(int n) const;
+	//rebuilds a spilled mesh on the heap, matching the mesh an in-memory parse produces
+	mesh_data loadSpilledMesh(int n) const;
+
+	//runs mesh_data::generateNormals on every mesh loaded without vn data
+	void generateMissingNormals(float crease_angle = 180.0f, NORMAL_WEIGHTING weighting = NORMAL_WEIGHT_ANGLE);
+
 private:
+	void beginParse(bool emit_meshes);
+	void parseSource(input_source &source);
+	void processLine(const string &line);
+	void flushPartialLine();
+	void loadGroups(const char* obj_file, const obj_group_index &index, const vector<bool> &selected);
+	void markReferencedGroups(const string &block, const obj_group_index &index, int group, vector<bool> &referenced);
+	void completeMesh();
+	void addAttributeLine(const string &line, DATA_TYPE dt);
 	void addRawData(const vector<float> &floats, DATA_TYPE dt);
+	void getRawData(DATA_TYPE dt, int n, vector<float> &floats) const;
+	const vector<vertex_data> assembleFaceVertices(const vector< vector<int> > &face_sequence);
+	//points at raw attribute n, spilled attributes are copied into scratch first
+	const float* getRawPointer(DATA_TYPE dt, int n, vector<float> &scratch) const;
+
+	//face assembly is specialized per attribute layout. the kernel is picked from the
+	//first face of each mesh, faces that do not match it take the general path
+	typedef void (obj_contents::*face_assembler)(const vector< vector<int> > &face_sequence, vector<vertex_data> &vertices);
+	void selectFaceAssembler(const vector< vector<int> > &face_sequence);
+	const bool faceMatchesAssembler(const vector< vector<int> > &face_sequence) const;
+	template <int V_SIZE, int VT_SIZE, int VN_SIZE>
+	void assembleFixedFace(const vector< vector<int> > &face_sequence, vector<vertex_data> &vertices);
+	void assembleAnyFace(const vector< vector<int> > &face_sequence, vector<vertex_data> &vertices);
+	void addPolygon(mesh_data &mesh, const vector<vertex_data> &polygon);
 
 	//uses vector<float> because # of floats per vertex varies
 	//data direct from obj file, unformatted
@@ -241,15 +596,54 @@ private:
 	map<int, vector<float> > raw_vt_data;
 	map<int, vector<float> > raw_vn_data;
 	map<int, vector<float> > raw_vp_data;
+	//set in out-of-core mode, replaces the raw data maps. shared so copies stay valid
+	std::shared_ptr<spill_storage> spill;
 	string mtl_filename;
 
+	glm::vec3 file_bounds_min;
+	glm::vec3 file_bounds_max;
+
 	int v_index_counter;
 	int vt_index_counter;
 	int vn_index_counter;
 	int vp_index_counter;
+	//floats per raw attribute for each face slot, 0 before the first and -1 once sizes differ
+	int raw_sizes[FACE_SLOT_COUNT];
+
+	face_assembler face_kernel;
+	//filled slots and attribute sizes face_kernel was instantiated for, per face slot
+	int face_kernel_slots;
+	int face_kernel_sizes[FACE_SLOT_COUNT];
+	vector<float> position_scratch;
+	vector<float> uv_scratch;
+	vector<float> normal_scratch;
 
 	vector<string> error_log;
 	vector<mesh_data> meshes;
+
+	//parse state carried between feed() calls
+	static const int read_chunk_size = 1 << 16;
+	bool emit_completed_meshes;
+	bool parse_finished;
+	bool end_of_vertex_data;
+	//set while loading blocks that only supply attributes to selected groups
+	bool attributes_only;
+	string current_material;
+	string partial_line;
+	vector<mesh_data> completed_meshes;
+
+	//file being parsed and byte offsets into it, only used for trace zone args.
+	//line_offset is where the line being processed starts
+	string source_name;
+	unsigned long long fed_bytes;
+	unsigned long long line_offset;
+	unsigned long long partial_offset;
+
+	load_stats stats;
+
+	//scratch space for ear clipping, kept to avoid allocating per polygon
+	vector<glm::vec2> ear_points;
+	vector<int> ear_indices;
 };
 
 class material_data
@@ -0,0 +1,1222 @@
+//checks the parser and the passes built on it against small generated files. they are
+//written into the working directory, run from the build directory:
+//	obj_parser_tests
+
+#include "obj_parser.h"
+#include "obj_input.h"
+#include "obj_index.h"
+#include "obj_reload.h"
+#include "obj_stream.h"
+#include "mesh_snapshot.h"
+#include "mesh_weld.h"
+#include "mesh_batch.h"
+#include "mesh_instancing.h"
+#include "mesh_optimize.h"
+#include "mesh_hull.h"
+#include "mesh_tiles.h"
+#include "mesh_voxel.h"
+#include "vertex_dedup.h"
+#include "obj_writer.h"
+#include "glb_writer.h"
+#include "obj_trace.h"
+#include "obj_json.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <limits>
+#include <string.h>
+#include <stdint.h>
+#include <thread>
+#include <tuple>
+
+static int failures = 0;
+
+#define CHECK(condition) checkCondition(condition, #condition, __FILE__, __LINE__)
+
+static void checkCondition(bool condition, const char* text, const char* file, int line)
+{
+	if (condition)
+		return;
+
+	std::cout << file << ":" << line << ": check failed: " << text << std::endl;
+	failures++;
+}
+
+//group n is an n + 2 by n + 2 grid of quads at height n, every third group as triangles.
+//the last group closes with a pentagon and a concave quad for addPolygon
+static void writeCorpus(const char* obj_file, int group_total, float lift = 0.0f)
+{
+	std::ofstream out(obj_file);
+	out << "mtllib corpus.mtl\n";
+
+	int v_base = 1;
+	int vt_base = 1;
+	for (int n = 0; n < group_total; n++)
+	{
+		int side = n + 2;
+		for (int y = 0; y <= side; y++)
+		{
+			for (int x = 0; x <= side; x++)
+			{
+				out << "v " << x * 0.25f << " " << y * 0.5f << " " << n + lift << "\n";
+				out << "vt " << x / float(side) << " " << y / float(side) << "\n";
+			}
+		}
+		out << "vn 0 0 1\n";
+
+		out << "g group_" << n << "\n";
+		out << "usemtl material_" << n % 3 << "\n";
+		for (int y = 0; y < side; y++)
+		{
+			for (int x = 0; x < side; x++)
+			{
+				int a = y * (side + 1) + x;
+				int corners[4] = { a, a + 1, a + side + 2, a + side + 1 };
+				int vn = n + 1;
+
+				if (n % 3 == 2)
+				{
+					out << "f " << v_base + corners[0] << "/" << vt_base + corners[0] << "/" << vn;
+					out << " " << v_base + corners[1] << "/" << vt_base + corners[1] << "/" << vn;
+					out << " " << v_base + corners[2] << "/" << vt_base + corners[2] << "/" << vn << "\n";
+					out << "f " << v_base + corners[0] << "/" << vt_base + corners[0] << "/" << vn;
+					out << " " << v_base + corners[2] << "/" << vt_base + corners[2] << "/" << vn;
+					out << " " << v_base + corners[3] << "/" << vt_base + corners[3] << "/" << vn << "\n";
+				}
+
+				else
+				{
+					out << "f";
+					for (int c = 0; c < 4; c++)
+						out << " " << v_base + corners[c] << "/" << vt_base + corners[c] << "/" << vn;
+					out << "\n";
+				}
+			}
+		}
+
+		v_base += (side + 1) * (side + 1);
+		vt_base += (side + 1) * (side + 1);
+	}
+
+	out << "v 0 0 -1\nv 2 0 -1\nv 3 1 -1\nv 1 2 -1\nv -1 1 -1\nv 1 0.5 -1\n";
+	out << "g polygons\n";
+	out << "f " << v_base << " " << v_base + 1 << " " << v_base + 2 << " " << v_base + 3 << " " << v_base + 4 << "\n";
+	out << "f " << v_base << " " << v_base + 1 << " " << v_base + 3 << " " << v_base + 5 << "\n";
+}
+
+static bool sameMesh(const mesh_data &a, const mesh_data &b)
+{
+	return a.getMeshlName() == b.getMeshlName() && a.getMaterialName() == b.getMaterialName() &&
+		a.getFaceCount() == b.getFaceCount() && a.getElementIndex() == b.getElementIndex() &&
+		a.getIndexedVertexData() == b.getIndexedVertexData();
+}
+
+static bool sameMeshes(const vector<mesh_data> &a, const vector<mesh_data> &b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (int i = 0; i < (int)a.size(); i++)
+	{
+		if (!sameMesh(a[i], b[i]))
+			return false;
+	}
+
+	return true;
+}
+
+static string readFile(const char* file_path)
+{
+	std::ifstream in(file_path, std::ios::binary);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void writeText(const char* file_path, const string &text)
+{
+	std::ofstream out(file_path, std::ios::binary);
+	out << text;
+}
+
+static float triangleArea(const vector<glm::vec4> &triangle)
+{
+	return 0.5f * glm::length(glm::cross(glm::vec3(triangle[1] - triangle[0]), glm::vec3(triangle[2] - triangle[0])));
+}
+
+//unit cube of outward wound quads, positions only
+static const char* cube_obj =
+	"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+	"g cube\n"
+	"f 1 4 3 2\nf 5 6 7 8\nf 1 2 6 5\nf 4 8 7 3\nf 1 5 8 4\nf 2 3 7 6\n";
+
+static mesh_data loadCube()
+{
+	writeText("cube.obj", cube_obj);
+	vector<mesh_data> meshes = obj_contents("cube.obj").getMeshes();
+	return meshes.empty() ? mesh_data() : meshes[0];
+}
+
+static void testParse()
+{
+	writeCorpus("corpus.obj", 6);
+	obj_contents contents("corpus.obj");
+	vector<mesh_data> meshes = contents.getMeshes();
+
+	CHECK(contents.getErrors().empty());
+	CHECK(contents.getMTLFilename() == "corpus.mtl");
+	CHECK(meshes.size() == 7);
+
+	for (int n = 0; n < 6 && n < (int)meshes.size(); n++)
+	{
+		int side = n + 2;
+		CHECK(meshes[n].getMeshlName() == "group_" + std::to_string(n));
+		CHECK(meshes[n].getFaceCount() == side * side * 2);
+		CHECK(meshes[n].getIndexedVertexCount() == (side + 1) * (side + 1));
+	}
+}
+
+//a convex quad and pentagon are fanned, the concave quad is ear clipped
+static void testPolygons()
+{
+	writeText("polygons.obj",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"v 0 0 1\nv 2 0 1\nv 3 1 1\nv 1 2 1\nv -1 1 1\n"
+		"v 0 0 2\nv 2 0 2\nv 1 2 2\nv 1 0.5 2\n"
+		"g polygons\n"
+		"f 1 2 3 4\n"
+		"f 5 6 7 8 9\n"
+		"f 10 11 12 13\n");
+
+	obj_contents contents("polygons.obj");
+	vector<mesh_data> meshes = contents.getMeshes();
+	CHECK(meshes.size() == 1);
+	if (meshes.size() != 1)
+		return;
+
+	CHECK(meshes[0].getFaceCount() == 2 + 3 + 2);
+
+	//the triangles cover each polygon exactly: 1 + 5 + 1.25
+	float area = 0.0f;
+	for (const auto &triangle : meshes[0].getMeshTrianglesVec4())
+		area += triangleArea(triangle);
+	CHECK(fabs(area - 7.25f) < 1e-5f);
+
+#ifndef OBJ_PARSER_NO_STATS
+	load_stats stats = contents.getLoadStats();
+	CHECK(stats.fan_triangulated_faces == 2);
+	CHECK(stats.ear_clipped_faces == 1);
+#endif
+}
+
+static void testPushMode()
+{
+	writeCorpus("corpus.obj", 6);
+	vector<mesh_data> expected = obj_contents("corpus.obj").getMeshes();
+	string text = readFile("corpus.obj");
+
+	const size_t chunk_sizes[] = { 1, 7, 4096 };
+	for (auto chunk_size : chunk_sizes)
+	{
+		obj_contents contents;
+		vector<mesh_data> meshes;
+		for (size_t offset = 0; offset < text.size(); offset += chunk_size)
+		{
+			contents.feed(text.data() + offset, std::min(chunk_size, text.size() - offset));
+			vector<mesh_data> completed = contents.takeCompletedMeshes();
+			meshes.insert(meshes.end(), completed.begin(), completed.end());
+		}
+
+		//every mesh but the last is handed out as soon as the group after it starts
+		CHECK(meshes.size() + 1 == expected.size());
+
+		contents.finish();
+		vector<mesh_data> completed = contents.takeCompletedMeshes();
+		meshes.insert(meshes.end(), completed.begin(), completed.end());
+
+		CHECK(sameMeshes(meshes, expected));
+	}
+}
+
+//a file that cannot be opened is reported and leaves no meshes behind
+static void testMissingFile()
+{
+	obj_contents missing("does_not_exist.obj");
+	CHECK(missing.getMeshCount() == 0);
+	CHECK(!missing.getErrors().empty());
+}
+
+static void writeCompressed(const char* file_path, const string &text, INPUT_FORMAT format)
+{
+#ifdef OBJ_PARSER_USE_ZLIB
+	if (format == INPUT_GZIP)
+	{
+		gzFile file = gzopen(file_path, "wb");
+		gzwrite(file, text.data(), (unsigned int)text.size());
+		gzclose(file);
+	}
+#endif
+
+#ifdef OBJ_PARSER_USE_ZSTD
+	if (format == INPUT_ZSTD)
+	{
+		string compressed(ZSTD_compressBound(text.size()), '\0');
+		compressed.resize(ZSTD_compress(&compressed[0], compressed.size(), text.data(), text.size(), 3));
+		writeText(file_path, compressed);
+	}
+#endif
+}
+
+//compressed files must parse like the plain file, and report an error when cut short.
+//formats not built in are rejected by their magic bytes
+static void testCompressedInput()
+{
+	const unsigned char gzip_magic[] = { 0x1f, 0x8b, 0x08, 0x00 };
+	const unsigned char zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+	CHECK(detectInputFormat(gzip_magic, 4) == INPUT_GZIP);
+	CHECK(detectInputFormat(zstd_magic, 4) == INPUT_ZSTD);
+	CHECK(detectInputFormat((const unsigned char*)"v 0", 3) == INPUT_PLAIN);
+
+	writeCorpus("corpus.obj", 6);
+	vector<mesh_data> expected = obj_contents("corpus.obj").getMeshes();
+	string text = readFile("corpus.obj");
+
+	const INPUT_FORMAT formats[] = { INPUT_GZIP, INPUT_ZSTD };
+	for (auto format : formats)
+	{
+		bool built_in = false;
+#ifdef OBJ_PARSER_USE_ZLIB
+		built_in = built_in || format == INPUT_GZIP;
+#endif
+#ifdef OBJ_PARSER_USE_ZSTD
+		built_in = built_in || format == INPUT_ZSTD;
+#endif
+
+		if (!built_in)
+		{
+			writeText("compressed.obj", string((const char*)(format == INPUT_GZIP ? gzip_magic : zstd_magic), 4));
+			obj_contents contents("compressed.obj");
+			CHECK(contents.getMeshCount() == 0);
+			CHECK(!contents.getErrors().empty());
+			continue;
+		}
+
+		writeCompressed("compressed.obj", text, format);
+		obj_contents contents("compressed.obj");
+		CHECK(contents.getErrors().empty());
+		CHECK(sameMeshes(contents.getMeshes(), expected));
+
+		string compressed = readFile("compressed.obj");
+		writeText("truncated.obj", compressed.substr(0, compressed.size() - 8));
+		obj_contents truncated("truncated.obj");
+		CHECK(!truncated.getErrors().empty());
+	}
+}
+
+//vertices within the position tolerance of an earlier one are merged into it
+static void testWeld()
+{
+	vertex_layout layout;
+	layout.stride = 3;
+	layout.v_size = 3;
+
+	const float positions[] = { 0, 0, 0,  1, 0, 0,  0, 1, 0,  0.00005f, 0, 0,  1, 0, 0.00005f,  0.5f, 0.5f, 0 };
+	vector<float> vertices(positions, positions + 18);
+	vector<unsigned short> indices = { 0, 1, 2, 3, 4, 5 };
+
+	weld_result result = weldVertices(vertices, layout, indices, weld_tolerance());
+	CHECK(result.welded_vertex_count == 4);
+	CHECK(result.vertices.size() == 4 * 3);
+	CHECK(result.indices == vector<unsigned short>({ 0, 1, 2, 0, 1, 3 }));
+	CHECK(result.remap == vector<unsigned short>({ 0, 1, 2, 0, 1, 3 }));
+
+	//a tighter tolerance keeps them apart
+	weld_tolerance tight;
+	tight.position = 0.00001f;
+	CHECK(weldVertices(vertices, layout, indices, tight).welded_vertex_count == 6);
+}
+
+//with a 60 degree crease every cube corner splits into 3 vertices with axis aligned
+//normals, with no crease the 8 corners keep one normal pointing away from the centre
+static void testGenerateNormals()
+{
+	const float creases[] = { 60.0f, 180.0f };
+	for (auto crease : creases)
+	{
+		mesh_data cube = loadCube();
+		cube.generateNormals(crease);
+
+		vector<float> vertices = cube.getIndexedVertexData();
+		vertex_layout layout = cube.getIndexedVertexLayout();
+		CHECK(layout.vn_size == 3);
+		CHECK(cube.getIndexedVertexCount() == (crease < 90.0f ? 24 : 8));
+		if (layout.vn_size != 3)
+			continue;
+
+		for (int v = 0; v < cube.getIndexedVertexCount(); v++)
+		{
+			const float* vertex = &vertices[v * layout.stride];
+			glm::vec3 position(vertex[layout.v_offset], vertex[layout.v_offset + 1], vertex[layout.v_offset + 2]);
+			glm::vec3 normal(vertex[layout.vn_offset], vertex[layout.vn_offset + 1], vertex[layout.vn_offset + 2]);
+			glm::vec3 outward = position - glm::vec3(0.5f, 0.5f, 0.5f);
+
+			CHECK(fabs(glm::length(normal) - 1.0f) < 1e-4f);
+			if (crease < 90.0f)
+				CHECK(fabs(glm::dot(normal, outward) - 0.5f) < 1e-4f);
+			else
+				CHECK(glm::distance(normal, glm::normalize(outward)) < 1e-4f);
+		}
+	}
+}
+
+//mesh bounds cover the vertices its faces use, file bounds every v line
+static void testBounds()
+{
+	writeText("bounds.obj", string(cube_obj) + "v -2 0 0\n");
+	obj_contents contents("bounds.obj");
+	vector<mesh_data> meshes = contents.getMeshes();
+	CHECK(!meshes.empty());
+	if (meshes.empty())
+		return;
+
+	CHECK(meshes[0].getBoundsMin() == glm::vec3(0.0f, 0.0f, 0.0f));
+	CHECK(meshes[0].getBoundsMax() == glm::vec3(1.0f, 1.0f, 1.0f));
+	CHECK(contents.getBoundsMin() == glm::vec3(-2.0f, 0.0f, 0.0f));
+	CHECK(contents.getBoundsMax() == glm::vec3(1.0f, 1.0f, 1.0f));
+
+	//the cube's smallest enclosing sphere has radius sqrt(3) / 2
+	bounding_sphere sphere = meshes[0].getBoundingSphere();
+	CHECK(glm::distance(sphere.center, glm::vec3(0.5f, 0.5f, 0.5f)) < 0.05f);
+	CHECK(sphere.radius >= 0.866f && sphere.radius < 0.866f * 1.05f);
+	for (const auto &triangle : meshes[0].getMeshTrianglesVec4())
+	{
+		for (const auto &corner : triangle)
+			CHECK(glm::distance(glm::vec3(corner), sphere.center) <= sphere.radius * 1.0001f);
+	}
+}
+
+static glm::mat4 translation(float x, float y, float z)
+{
+	glm::mat4 matrix(1.0f);
+	matrix[3] = glm::vec4(x, y, z, 1.0f);
+	return matrix;
+}
+
+//cube_obj's corners moved by placement and its faces to start at vertex first_vertex,
+//under its own group and material
+static string cubeGroup(const string &name, const string &material, int first_vertex, const glm::mat4 &placement)
+{
+	std::ostringstream text;
+	for (int v = 0; v < 8; v++)
+	{
+		glm::vec4 corner(v == 1 || v == 2 || v == 5 || v == 6, v == 2 || v == 3 || v == 6 || v == 7, v >= 4, 1.0f);
+		glm::vec4 placed = placement * corner;
+		text << "v " << placed.x << " " << placed.y << " " << placed.z << "\n";
+	}
+
+	text << "g " << name << "\nusemtl " << material << "\n";
+	const int quads[6][4] = { { 1, 4, 3, 2 }, { 5, 6, 7, 8 }, { 1, 2, 6, 5 }, { 4, 8, 7, 3 }, { 1, 5, 8, 4 }, { 2, 3, 7, 6 } };
+	for (int f = 0; f < 6; f++)
+		text << "f " << quads[f][0] + first_vertex - 1 << " " << quads[f][1] + first_vertex - 1 << " " << quads[f][2] + first_vertex - 1 << " " << quads[f][3] + first_vertex - 1 << "\n";
+
+	return text.str();
+}
+
+//meshes sharing a material land in one batch, each command must draw its own mesh
+static void testBatchByMaterial()
+{
+	writeText("batch.obj", cubeGroup("a", "stone", 1, translation(0.0f, 0.0f, 0.0f)) + cubeGroup("b", "wood", 9, translation(2.0f, 0.0f, 0.0f)) +
+		cubeGroup("c", "stone", 17, translation(4.0f, 0.0f, 0.0f)));
+	vector<mesh_data> meshes = obj_contents("batch.obj").getMeshes();
+	vector<material_batch> batches = batchByMaterial(meshes);
+
+	CHECK(meshes.size() == 3);
+	CHECK(batches.size() == 2);
+	if (meshes.size() != 3 || batches.size() != 2)
+		return;
+
+	CHECK(batches[0].material_name == "stone" && batches[1].material_name == "wood");
+	CHECK(batches[0].mesh_names == vector<string>({ "a", "c" }));
+	CHECK(batches[0].commands.size() == 2);
+	CHECK(batches[0].commands[1].first_index == batches[0].commands[0].count);
+	CHECK(batches[0].commands[1].base_vertex == meshes[0].getIndexedVertexCount());
+
+	const int sources[2][2] = { { 0, 2 }, { 1, -1 } };
+	for (int n = 0; n < 2; n++)
+	{
+		const material_batch &batch = batches[n];
+		for (int c = 0; c < (int)batch.commands.size(); c++)
+		{
+			const mesh_data &mesh = meshes[sources[n][c]];
+			const draw_command &command = batch.commands[c];
+			vector<float> vertices = mesh.getIndexedVertexData();
+			vector<unsigned short> element_index = mesh.getElementIndex();
+			CHECK(command.count == element_index.size());
+
+			for (unsigned int i = 0; i < command.count && i < element_index.size(); i++)
+			{
+				const float* batched = &batch.vertices[(command.base_vertex + batch.indices[command.first_index + i]) * batch.layout.stride];
+				const float* source = &vertices[element_index[i] * batch.layout.stride];
+				CHECK(std::equal(source, source + batch.layout.stride, batched));
+			}
+		}
+	}
+}
+
+//a turned and moved copy of a cube is an instance of it, a larger cube is not
+static void testFindInstances()
+{
+	glm::mat4 turned = translation(10.0f, 3.0f, -2.0f);
+	turned[0] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+	turned[1] = glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f);
+	glm::mat4 larger(2.0f);
+	larger[3] = glm::vec4(-5.0f, 0.0f, 0.0f, 1.0f);
+
+	writeText("instances.obj", cubeGroup("a", "stone", 1, glm::mat4(1.0f)) + cubeGroup("b", "stone", 9, turned) +
+		cubeGroup("c", "stone", 17, larger));
+	vector<mesh_data> meshes = obj_contents("instances.obj").getMeshes();
+	vector<instance_group> groups = findInstances(meshes);
+
+	CHECK(groups.size() == 2);
+	if (groups.size() != 2)
+		return;
+
+	CHECK(groups[0].source_meshes == vector<int>({ 0, 1 }));
+	CHECK(groups[1].source_meshes == vector<int>({ 2 }));
+	CHECK(groups[0].instance_names == vector<string>({ "a", "b" }));
+
+	//the transform carries the prototype's corners onto the instance's
+	if (groups[0].transforms.size() == 2)
+	{
+		vector< vector<glm::vec4> > prototype = meshes[0].getMeshTrianglesVec4();
+		vector< vector<glm::vec4> > instance = meshes[1].getMeshTrianglesVec4();
+		for (int t = 0; t < (int)prototype.size() && t < (int)instance.size(); t++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				glm::vec4 moved = groups[0].transforms[1] * glm::vec4(glm::vec3(prototype[t][c]), 1.0f);
+				CHECK(glm::distance(glm::vec3(moved), glm::vec3(instance[t][c])) < 1e-4f);
+			}
+		}
+	}
+}
+
+//loading named groups must give the meshes a full parse gives for them, including
+//faces that use attributes of other blocks
+static void testSelectiveLoad()
+{
+	//the corpus ends with 6 polygon vertices after the grids
+	int vertex_total = 6;
+	for (int n = 0; n < 6; n++)
+		vertex_total += (n + 3) * (n + 3);
+
+	writeCorpus("corpus.obj", 6);
+	writeText("corpus.obj", readFile("corpus.obj") + "v 9 9 9\ng external\nf 1 2 " + std::to_string(vertex_total + 1) + "\n");
+	vector<mesh_data> expected = obj_contents("corpus.obj").getMeshes();
+	CHECK(expected.size() == 8);
+
+	obj_group_index index;
+	CHECK(index.open("corpus.obj", "corpus.obj.index"));
+	CHECK(index.getGroupCount() == 8);
+
+	obj_contents selected("corpus.obj", index, vector<string>({ "group_4", "external" }));
+	vector<mesh_data> meshes = selected.getMeshes();
+	CHECK(meshes.size() == 2);
+	if (meshes.size() == 2 && expected.size() == 8)
+	{
+		CHECK(sameMesh(meshes[0], expected[4]));
+		CHECK(sameMesh(meshes[1], expected[7]));
+		CHECK(meshes[1].getFaceCount() == 1);
+	}
+
+	//the sidecar is current until the obj changes
+	obj_group_index reloaded;
+	CHECK(reloaded.load("corpus.obj.index", "corpus.obj"));
+	CHECK(reloaded.getGroupCount() == 8);
+	writeCorpus("corpus.obj", 6, 0.5f);
+	CHECK(!reloaded.load("corpus.obj.index", "corpus.obj"));
+}
+
+//compacting to the indexed form releases the faces and attribute lists and keeps what
+//an indexed renderer reads
+static void testCompact()
+{
+	writeCorpus("corpus.obj", 6);
+	vector<mesh_data> meshes = obj_contents("corpus.obj").getMeshes();
+	CHECK(meshes.size() == 7);
+	if (meshes.size() != 7)
+		return;
+
+	mesh_data mesh = meshes[5];
+	vector<float> vertices = mesh.getIndexedVertexData();
+	vector<unsigned short> element_index = mesh.getElementIndex();
+
+	mesh_memory_usage before = mesh.memoryUsage();
+	CHECK(before.faces > 0 && before.attribute_lists > 0 && before.vertex_map > 0 && before.element_index > 0);
+
+	mesh.compact(MESH_INDEXED);
+	mesh_memory_usage after = mesh.memoryUsage();
+	CHECK(mesh.getRepresentations() == MESH_INDEXED);
+	CHECK(after.faces == 0 && after.attribute_lists == 0);
+	CHECK(after.getTotal() < before.getTotal());
+	CHECK(mesh.getIndexedVertexData() == vertices);
+	CHECK(mesh.getElementIndex() == element_index);
+}
+
+//triangles of a side by side grid with uvs, neighbouring triangles share corners
+static vector< vector<vertex_data> > gridTriangles(int side)
+{
+	vector< vector<vertex_data> > triangles;
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			vector<vertex_data> corners;
+			const int offsets[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+			for (int c = 0; c < 4; c++)
+			{
+				float u = float(x + offsets[c][0]);
+				float v = float(y + offsets[c][1]);
+				corners.push_back(vertex_data(vector<float>({ u, v, 0.0f }), vector<float>({ u / side, v / side }), vector<float>()));
+			}
+
+			triangles.push_back(vector<vertex_data>({ corners[0], corners[1], corners[2] }));
+			triangles.push_back(vector<vertex_data>({ corners[0], corners[2], corners[3] }));
+		}
+	}
+
+	return triangles;
+}
+
+//batched and mixed addFaces calls must index exactly like addFace one face at a time
+static void testAddFaces()
+{
+	vector< vector<vertex_data> > triangles = gridTriangles(30);
+
+	mesh_data serial;
+	for (const auto &triangle : triangles)
+		serial.addFace(triangle);
+
+	mesh_data batched;
+	batched.addFaces(triangles);
+	CHECK(batched.getElementIndex() == serial.getElementIndex());
+	CHECK(batched.getIndexedVertexData() == serial.getIndexedVertexData());
+
+	mesh_data mixed;
+	for (int begin = 0; begin < (int)triangles.size(); begin += 7)
+	{
+		vector< vector<vertex_data> > chunk(triangles.begin() + begin, triangles.begin() + std::min(begin + 7, (int)triangles.size()));
+		if ((begin / 7) % 3 == 2)
+		{
+			for (const auto &triangle : chunk)
+				mixed.addFace(triangle);
+		}
+
+		else mixed.addFaces(chunk);
+	}
+	CHECK(mixed.getElementIndex() == serial.getElementIndex());
+	CHECK(mixed.getIndexedVertexData() == serial.getIndexedVertexData());
+
+	//dedupVertices numbers distinct corners in order of first occurrence
+	vector<float> corners;
+	for (const auto &triangle : triangles)
+	{
+		for (const auto &corner : triangle)
+		{
+			vector<float> data = corner.getAllData();
+			corners.insert(corners.end(), data.begin(), data.end());
+		}
+	}
+
+	int stride = triangles[0][0].getAllData().size();
+	int corner_total = corners.size() / stride;
+	vector<float> unique_vertices;
+	vector<unsigned int> indices;
+	int unique_total = dedupVertices(&corners[0], corner_total, stride, unique_vertices, indices);
+
+	std::map< vector<float>, unsigned int > first_index;
+	vector<unsigned int> expected;
+	for (int i = 0; i < corner_total; i++)
+	{
+		vector<float> corner(corners.begin() + i * stride, corners.begin() + (i + 1) * stride);
+		std::map< vector<float>, unsigned int >::const_iterator found = first_index.find(corner);
+		if (found == first_index.end())
+			found = first_index.insert(std::make_pair(corner, (unsigned int)first_index.size())).first;
+		expected.push_back(found->second);
+	}
+
+	CHECK(unique_total == 31 * 31);
+	CHECK(unique_total == (int)first_index.size());
+	CHECK(indices == expected);
+	CHECK((int)unique_vertices.size() == unique_total * stride);
+}
+
+static void testWriterRoundTrip()
+{
+	writeCorpus("corpus.obj", 6);
+	obj_contents contents("corpus.obj");
+	vector<mesh_data> expected = contents.getMeshes();
+
+	string error;
+	CHECK(writeOBJ("written.obj", contents, error));
+	CHECK(error.empty());
+
+	obj_contents written("written.obj");
+	CHECK(written.getErrors().empty());
+	CHECK(written.getMTLFilename() == "corpus.mtl");
+	CHECK(sameMeshes(written.getMeshes(), expected));
+
+	//shortest round-trip text reads back bit-exact
+	const float values[] = { 0.1f, 1.0f / 3.0f, 1e-38f, 3.4028235e38f, -0.0f, 16777217.0f,
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+	for (auto value : values)
+	{
+		string text;
+		appendFloat(text, value);
+		vector<float> parsed = extractFloats("v " + text);
+		CHECK(parsed.size() == 1 && memcmp(&parsed[0], &value, sizeof(float)) == 0);
+	}
+
+	string nan_text;
+	appendFloat(nan_text, -std::numeric_limits<float>::quiet_NaN());
+	vector<float> nan_parsed = extractFloats("v " + nan_text);
+	CHECK(nan_parsed.size() == 1 && nan_parsed[0] != nan_parsed[0] && signbit(nan_parsed[0]));
+
+	//out of range values saturate to infinity, which must read back as infinity
+	writeText("overflow.obj", "v 1e39 -1e39 0\nv 1 0 0\nv 0 1 0\ng overflow\nf 1 2 3\n");
+	obj_contents overflow("overflow.obj");
+	CHECK(overflow.getErrors().empty());
+	CHECK(writeOBJ("overflow_written.obj", overflow, error));
+
+	obj_contents overflow_written("overflow_written.obj");
+	CHECK(overflow_written.getErrors().empty());
+	CHECK(overflow_written.getMeshCount() == 1);
+	if (overflow.getMeshCount() == 1 && overflow_written.getMeshCount() == 1)
+	{
+		vector<float> positions = overflow_written.getMeshes()[0].getVData();
+		CHECK(positions.size() >= 2 && positions[0] == std::numeric_limits<float>::infinity() && positions[1] == -std::numeric_limits<float>::infinity());
+		CHECK(positions == overflow.getMeshes()[0].getVData());
+	}
+}
+
+static uint32_t readUint32(const string &bytes, size_t offset)
+{
+	uint32_t value = 0;
+	if (offset + 4 <= bytes.size())
+		memcpy(&value, &bytes[offset], 4);
+	return value;
+}
+
+//a glb is a 12 byte header, a padded json chunk and a binary chunk holding each mesh's indices
+static void testGLB()
+{
+	writeText("glb.obj", cubeGroup("a", "stone", 1, glm::mat4(1.0f)) + cubeGroup("b", "wood", 9, translation(2.0f, 0.0f, 0.0f)));
+	vector<mesh_data> meshes = obj_contents("glb.obj").getMeshes();
+
+	string error;
+	CHECK(writeGLB("meshes.glb", meshes, map<string, material_data>(), error));
+	CHECK(error.empty());
+
+	string bytes = readFile("meshes.glb");
+	CHECK(readUint32(bytes, 0) == 0x46546C67u);
+	CHECK(readUint32(bytes, 4) == 2);
+	CHECK(readUint32(bytes, 8) == bytes.size());
+
+	uint32_t json_length = readUint32(bytes, 12);
+	CHECK(json_length % 4 == 0);
+	CHECK(readUint32(bytes, 16) == 0x4E4F534Au);
+	string json = bytes.substr(20, json_length);
+	CHECK(json.find("\"meshes\"") != string::npos);
+	CHECK(json.find("\"a\"") != string::npos && json.find("\"b\"") != string::npos);
+
+	size_t bin_start = 20 + json_length;
+	uint32_t bin_length = readUint32(bytes, bin_start);
+	CHECK(readUint32(bytes, bin_start + 4) == 0x004E4942u);
+	CHECK(bin_start + 8 + bin_length == bytes.size());
+
+	string bin = bytes.substr(bin_start + 8, bin_length);
+	for (const auto &mesh : meshes)
+	{
+		vector<unsigned short> element_index = mesh.getElementIndex();
+		string index_bytes((const char*)&element_index[0], element_index.size() * sizeof(unsigned short));
+		CHECK(bin.find(index_bytes) != string::npos);
+	}
+}
+
+static void testStream()
+{
+	writeCorpus("corpus.obj", 6);
+	vector<mesh_data> expected = obj_contents("corpus.obj").getMeshes();
+
+	mesh_stream stream("corpus.obj");
+	vector<mesh_data> meshes;
+	mesh_data mesh;
+	while (stream.next(mesh))
+		meshes.push_back(mesh);
+
+	CHECK(stream.getErrors().empty());
+	CHECK(stream.getMTLFilename() == "corpus.mtl");
+	CHECK(sameMeshes(meshes, expected));
+
+#ifdef OBJ_PARSER_HAS_COROUTINES
+	vector<mesh_data> generated;
+	for (mesh_data &mesh : streamMeshes("corpus.obj"))
+		generated.push_back(mesh);
+	CHECK(sameMeshes(generated, expected));
+#endif
+}
+
+static void testSpill()
+{
+	writeCorpus("corpus.obj", 6);
+	vector<mesh_data> expected = obj_contents("corpus.obj").getMeshes();
+
+	spill_options options;
+	options.directory = ".";
+	obj_contents contents("corpus.obj", options);
+
+	//only the spill files hold the meshes
+	CHECK(contents.getMeshCount() == 0);
+	CHECK(contents.getSpilledMeshCount() == (int)expected.size());
+
+	vector<mesh_data> meshes;
+	for (int n = 0; n < contents.getSpilledMeshCount(); n++)
+	{
+		spilled_mesh spilled = contents.getSpilledMesh(n);
+		const unsigned short* indices = contents.getSpilledIndices(n);
+		if (n < (int)expected.size())
+			CHECK(vector<unsigned short>(indices, indices + spilled.index_total) == expected[n].getElementIndex());
+
+		meshes.push_back(contents.loadSpilledMesh(n));
+	}
+
+	CHECK(contents.getErrors().empty());
+	CHECK(sameMeshes(meshes, expected));
+}
+
+//edits return new snapshots that share every buffer they leave alone, the original is untouched
+static void testSnapshots()
+{
+	mesh_handle cube = std::make_shared<const mesh_snapshot>(loadCube());
+	const vector<float> original_vertices = cube->getIndexedVertexData();
+
+	mesh_handle renamed = cube->setMaterialName("brick");
+	CHECK(renamed->getMaterialName() == "brick");
+	CHECK(cube->getMaterialName() != "brick");
+	CHECK(renamed->sharesIndexedData(*cube));
+	CHECK(&renamed->getElementIndex() == &cube->getElementIndex());
+
+	mesh_handle moved = cube->modifyPosition(translation(1.0f, 2.0f, 3.0f));
+	CHECK(!moved->sharesIndexedData(*cube));
+	CHECK(&moved->getElementIndex() == &cube->getElementIndex());
+	CHECK(cube->getIndexedVertexData() == original_vertices);
+	CHECK(moved->getBoundsMin() == glm::vec3(1.0f, 2.0f, 3.0f));
+	CHECK(moved->getBoundsMax() == glm::vec3(2.0f, 3.0f, 4.0f));
+
+	const vertex_layout &layout = moved->getIndexedVertexLayout();
+	for (int v = 0; v < moved->getIndexedVertexCount(); v++)
+	{
+		const float* before = &original_vertices[v * layout.stride + layout.v_offset];
+		const float* after = &moved->getIndexedVertexData()[v * layout.stride + layout.v_offset];
+		CHECK(after[0] == before[0] + 1.0f && after[1] == before[1] + 2.0f && after[2] == before[2] + 3.0f);
+	}
+
+	//threads read one handle without locks and all see the same data
+	vector<double> sums(4, 0.0);
+	vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.push_back(std::thread([moved, &sums, t]
+		{
+			for (auto value : moved->getIndexedVertexData())
+				sums[t] += value;
+		}));
+	}
+
+	for (auto &reader : readers)
+		reader.join();
+
+	CHECK(sums[0] == sums[1] && sums[1] == sums[2] && sums[2] == sums[3]);
+}
+
+//each triangle as its three positions, rotated to start at the smallest so winding is kept
+static vector< vector<float> > triangleSet(const vector<float> &vertices, const vertex_layout &layout, const vector<unsigned short> &indices)
+{
+	vector< vector<float> > triangles;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		vector< vector<float> > corners;
+		for (int c = 0; c < 3; c++)
+		{
+			const float* position = &vertices[indices[i + c] * layout.stride + layout.v_offset];
+			corners.push_back(vector<float>(position, position + 3));
+		}
+
+		std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+		vector<float> triangle;
+		for (const auto &corner : corners)
+			triangle.insert(triangle.end(), corner.begin(), corner.end());
+		triangles.push_back(triangle);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+//reordering keeps every triangle and its winding and must not make the cache behave worse
+static void testOptimizeOrder()
+{
+	vector< vector<vertex_data> > triangles = gridTriangles(24);
+	std::mt19937 random(7);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+
+	mesh_data mesh;
+	mesh.addFaces(triangles);
+	const vector<float> vertices = mesh.getIndexedVertexData();
+	const vertex_layout layout = mesh.getIndexedVertexLayout();
+	const vector<unsigned short> indices = mesh.getElementIndex();
+
+	const order_metrics shuffled = measureOrder(vertices, layout, indices);
+	CHECK(shuffled.atvr >= 1.0f);
+	CHECK(shuffled.acmr >= 0.5f && shuffled.acmr <= 3.0f);
+	CHECK(shuffled.overdraw >= 1.0f);
+
+	overdraw_result ordered = optimizeOverdraw(vertices, layout, indices);
+	CHECK(triangleSet(vertices, layout, ordered.indices) == triangleSet(vertices, layout, indices));
+	CHECK(ordered.cluster_count >= 1);
+	CHECK(ordered.after.acmr < ordered.before.acmr);
+
+	fetch_result fetched = optimizeMeshOrder(mesh);
+	CHECK(triangleSet(fetched.vertices, layout, fetched.indices) == triangleSet(vertices, layout, indices));
+	CHECK(fetched.before.acmr == shuffled.acmr);
+	CHECK(fetched.after.acmr < fetched.before.acmr);
+	CHECK(fetched.after.overfetch <= fetched.before.overfetch);
+	CHECK(fetched.remap.size() == vertices.size() / layout.stride);
+
+	//first use order means the indices introduce vertices 0, 1, 2 ... in sequence
+	int next_vertex = 0;
+	for (auto index : fetched.indices)
+	{
+		CHECK(index <= next_vertex);
+		if (index == next_vertex)
+			next_vertex++;
+	}
+
+	CHECK(next_vertex == (int)(fetched.vertices.size() / layout.stride));
+}
+
+//the hull of a cube with points inside it is the cube, wound outwards
+static void testConvexHull()
+{
+	vector<glm::vec3> points;
+	for (int corner = 0; corner < 8; corner++)
+		points.push_back(glm::vec3(float(corner & 1), float((corner >> 1) & 1), float((corner >> 2) & 1)));
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> inside(0.1f, 0.9f);
+	for (int i = 0; i < 200; i++)
+		points.push_back(glm::vec3(inside(random), inside(random), inside(random)));
+
+	std::shuffle(points.begin(), points.end(), random);
+	convex_hull hull = computeConvexHull(points);
+	CHECK(hull.vertices.size() == 8);
+	CHECK(hull.indices.size() == 36);
+	CHECK(fabs(hull.volume - 1.0f) < 1e-4f);
+
+	const glm::vec3 center(0.5f, 0.5f, 0.5f);
+	for (size_t i = 0; i + 2 < hull.indices.size(); i += 3)
+	{
+		const glm::vec3 a = hull.vertices[hull.indices[i]];
+		const glm::vec3 b = hull.vertices[hull.indices[i + 1]];
+		const glm::vec3 c = hull.vertices[hull.indices[i + 2]];
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		CHECK(glm::dot(normal, (a + b + c) / 3.0f - center) > 0.0f);
+		for (const auto &point : points)
+			CHECK(glm::dot(normal, point - a) <= 1e-5f);
+	}
+
+	convex_hull cube_hull = computeConvexHull(loadCube());
+	CHECK(cube_hull.vertices.size() == 8);
+	CHECK(fabs(cube_hull.volume - 1.0f) < 1e-4f);
+
+	convex_hull limited = computeConvexHull(points, 5);
+	CHECK(limited.vertices.size() <= 5);
+	CHECK(limited.volume > 0.0f && limited.volume < 1.0f);
+
+	vector<glm::vec3> flat({ glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(1, 1, 0) });
+	CHECK(computeConvexHull(flat).indices.empty());
+
+	//a convex mesh needs no cuts
+	vector<convex_hull> parts = decomposeConvex(loadCube());
+	CHECK(parts.size() == 1);
+	CHECK(!parts.empty() && fabs(parts[0].volume - 1.0f) < 1e-4f);
+}
+
+//every triangle lands in exactly one tile, the one holding its centroid
+static void testTiles()
+{
+	mesh_data mesh;
+	mesh.addFaces(gridTriangles(16));
+	const vector<float> vertices = mesh.getIndexedVertexData();
+	const vertex_layout layout = mesh.getIndexedVertexLayout();
+	const vector<unsigned short> indices = mesh.getElementIndex();
+	const vector<unsigned int> wide_indices(indices.begin(), indices.end());
+
+	tile_options grid;
+	grid.divisions[0] = 4;
+	grid.divisions[1] = 4;
+	grid.divisions[2] = 1;
+	vector<mesh_tile> tiles = tileTriangles(vertices, layout, wide_indices, grid);
+	CHECK(tiles.size() == 16);
+
+	vector< vector<float> > tiled;
+	for (size_t t = 0; t < tiles.size(); t++)
+	{
+		const mesh_tile &tile = tiles[t];
+		CHECK(tile.x == int(t % 4) && tile.y == int(t / 4) && tile.z == 0);
+		CHECK(tile.indices.size() == 3 * 32);
+
+		glm::vec3 low(std::numeric_limits<float>::max());
+		glm::vec3 high(-std::numeric_limits<float>::max());
+		for (size_t v = 0; v < tile.vertices.size(); v += tile.layout.stride)
+		{
+			const glm::vec3 position(tile.vertices[v + tile.layout.v_offset], tile.vertices[v + tile.layout.v_offset + 1], tile.vertices[v + tile.layout.v_offset + 2]);
+			low = glm::vec3(std::min(low.x, position.x), std::min(low.y, position.y), std::min(low.z, position.z));
+			high = glm::vec3(std::max(high.x, position.x), std::max(high.y, position.y), std::max(high.z, position.z));
+		}
+
+		CHECK(tile.bounds_min == low && tile.bounds_max == high);
+
+		for (size_t i = 0; i + 2 < tile.indices.size(); i += 3)
+		{
+			glm::vec3 centroid(0.0f);
+			for (int c = 0; c < 3; c++)
+			{
+				const float* position = &tile.vertices[tile.indices[i + c] * tile.layout.stride + tile.layout.v_offset];
+				centroid = centroid + glm::vec3(position[0], position[1], position[2]) / 3.0f;
+			}
+
+			CHECK(int(centroid.x / 4.0f) == tile.x && int(centroid.y / 4.0f) == tile.y);
+		}
+
+		const vector<unsigned short> tile_indices(tile.indices.begin(), tile.indices.end());
+		const vector< vector<float> > triangles = triangleSet(tile.vertices, tile.layout, tile_indices);
+		tiled.insert(tiled.end(), triangles.begin(), triangles.end());
+	}
+
+	std::sort(tiled.begin(), tiled.end());
+	CHECK(tiled == triangleSet(vertices, layout, indices));
+
+	tile_options octree;
+	octree.scheme = TILE_OCTREE;
+	octree.max_triangles = 64;
+	tiles = tileMesh(mesh, octree);
+	CHECK(tiles.size() > 1);
+
+	size_t triangle_total = 0;
+	for (const auto &tile : tiles)
+	{
+		CHECK(tile.indices.size() <= 3 * 64);
+		CHECK(tile.level > 0);
+		triangle_total += tile.indices.size() / 3;
+	}
+
+	CHECK(triangle_total == indices.size() / 3);
+}
+
+//zones recorded between startTrace and stopTrace come out as escaped trace-event json
+static void testTrace()
+{
+	string quoted;
+	appendJSONString(quoted, "say \"hi\"\\\n\x01");
+	CHECK(quoted == "\"say \\\"hi\\\"\\\\\\u000a\\u0001\"");
+
+	startTrace();
+	CHECK(isTracing());
+	{
+		trace_zone zone("test zone", "dir\\\"cube\".obj", 42);
+	}
+
+#ifdef OBJ_PARSER_TRACE
+	loadCube();
+#endif
+
+	stopTrace();
+	CHECK(!isTracing());
+	{
+		trace_zone zone("after stop");
+	}
+
+	string error;
+	CHECK(writeTrace("trace.json", error));
+	string json = readFile("trace.json");
+	CHECK(json.find("\"traceEvents\":[") != string::npos);
+	CHECK(json.find("\"name\":\"test zone\",\"ph\":\"X\"") != string::npos);
+	CHECK(json.find("\"file\":\"dir\\\\\\\"cube\\\".obj\",\"offset\":42") != string::npos);
+	CHECK(json.find("after stop") == string::npos);
+	CHECK(json.compare(json.size() - 3, 3, "]}\n") == 0);
+#ifdef OBJ_PARSER_TRACE
+	CHECK(json.find("\"name\":\"load\"") != string::npos);
+#endif
+
+	//restarting clears earlier events, the threshold drops short zones
+	startTrace(1e9);
+	{
+		trace_zone zone("short zone");
+	}
+	stopTrace();
+
+	CHECK(writeTrace("trace.json", error));
+	json = readFile("trace.json");
+	CHECK(json.find("test zone") == string::npos);
+	CHECK(json.find("short zone") == string::npos);
+
+	CHECK(!writeTrace("missing_directory/trace.json", error));
+	CHECK(!error.empty());
+}
+
+//a unit cube at 16 voxels a side is a one voxel thick shell, or solid when filled
+static void testVoxelize()
+{
+	mesh_data cube = loadCube();
+	voxel_options options;
+	options.resolution = 16;
+
+	voxel_grid surface = voxelizeMesh(cube, options);
+	CHECK(surface.getDimension(0) == 16 && surface.getDimension(1) == 16 && surface.getDimension(2) == 16);
+	CHECK(surface.getVoxelSize() == 1.0f / 16.0f);
+	CHECK(surface.getVoxelPosition(16, 16, 16) == glm::vec3(1.0f, 1.0f, 1.0f));
+	CHECK(surface.getVoxelCount() == 16 * 16 * 16 - 14 * 14 * 14);
+	CHECK(surface.getBricks().size() == 8);
+	CHECK(surface.isSet(0, 7, 9) && surface.isSet(15, 15, 15));
+	CHECK(!surface.isSet(1, 1, 1) && !surface.isSet(8, 8, 8));
+	CHECK(!surface.isSet(16, 0, 0) && !surface.isSet(-1, 0, 0));
+
+	for (size_t b = 1; b < surface.getBricks().size(); b++)
+	{
+		const voxel_brick &previous = surface.getBricks()[b - 1];
+		const voxel_brick &brick = surface.getBricks()[b];
+		CHECK(std::make_tuple(previous.z, previous.y, previous.x) < std::make_tuple(brick.z, brick.y, brick.x));
+	}
+
+	options.fill = VOXEL_FILL_PARITY;
+	voxel_grid parity = voxelizeMesh(cube, options);
+	CHECK(parity.getVoxelCount() == 16 * 16 * 16);
+	CHECK(parity.isSet(8, 8, 8));
+
+	options.fill = VOXEL_FILL_WINDING;
+	CHECK(voxelizeMesh(cube, options).getVoxelCount() == 16 * 16 * 16);
+
+	//a second cube inside the first: parity hollows it out, winding keeps it solid
+	vector<glm::vec3> triangles = getTrianglePositions(cube);
+	const size_t outer_total = triangles.size();
+	for (size_t p = 0; p < outer_total; p++)
+		triangles.push_back(glm::vec3(0.25f, 0.25f, 0.25f) + triangles[p] * 0.5f);
+
+	voxel_grid nested = voxelizeTriangles(triangles, options);
+	CHECK(nested.getVoxelCount() == 16 * 16 * 16);
+
+	options.fill = VOXEL_FILL_PARITY;
+	nested = voxelizeTriangles(triangles, options);
+	CHECK(!nested.isSet(8, 8, 8));
+	CHECK(nested.isSet(2, 2, 2));
+	//the inner faces lie on voxel boundaries 4 and 12 and set the voxels on both sides
+	CHECK(nested.getVoxelCount() == 16 * 16 * 16 - 6 * 6 * 6);
+}
+
+//a reload parses only the blocks whose bytes changed and moves every other mesh over
+static void testReload()
+{
+	writeCorpus("reload.obj", 6);
+	obj_reloader reloader;
+	CHECK(reloader.load("reload.obj"));
+	CHECK(sameMeshes(reloader.getMeshes(), obj_contents("reload.obj").getMeshes()));
+
+	vector<int> replaced;
+	CHECK(reloader.reload(replaced));
+	CHECK(replaced.empty());
+
+	//lifting the grids changes their blocks, the polygons block keeps its bytes
+	writeCorpus("reload.obj", 6, 0.5f);
+	const unsigned short* polygons = reloader.getMeshes()[6].getElementIndexBuffer();
+	CHECK(reloader.reload(replaced));
+	CHECK(replaced == vector<int>({ 0, 1, 2, 3, 4, 5 }));
+	CHECK(reloader.getMeshes()[6].getElementIndexBuffer() == polygons);
+	CHECK(sameMeshes(reloader.getMeshes(), obj_contents("reload.obj").getMeshes()));
+
+	//a group inserted before the polygons is the only block parsed, every other mesh
+	//keeps its buffers. it ends on the material the polygons started with before
+	vector<const unsigned short*> buffers;
+	for (const auto &mesh : reloader.getMeshes())
+		buffers.push_back(mesh.getElementIndexBuffer());
+
+	int vertex_total = 0;
+	for (int n = 0; n < 6; n++)
+		vertex_total += (n + 3) * (n + 3);
+
+	//the polygons move back by the inserted vertices, their face indices with them
+	string text = readFile("reload.obj");
+	std::ostringstream edited;
+	edited << text.substr(0, text.find("v 0 0 -1\n"));
+	edited << "v 0 0 9\nv 1 0 9\nv 0 1 9\ng inserted\nusemtl material_2\n";
+	edited << "f " << vertex_total + 1 << " " << vertex_total + 2 << " " << vertex_total + 3 << "\n";
+
+	int v_base = vertex_total + 4;
+	edited << "v 0 0 -1\nv 2 0 -1\nv 3 1 -1\nv 1 2 -1\nv -1 1 -1\nv 1 0.5 -1\n";
+	edited << "g polygons\n";
+	edited << "f " << v_base << " " << v_base + 1 << " " << v_base + 2 << " " << v_base + 3 << " " << v_base + 4 << "\n";
+	edited << "f " << v_base << " " << v_base + 1 << " " << v_base + 3 << " " << v_base + 5 << "\n";
+	writeText("reload.obj", edited.str());
+	CHECK(reloader.reload(replaced));
+	CHECK(replaced == vector<int>({ 6 }));
+	CHECK(reloader.getMeshCount() == 8);
+	for (int i = 0; i < 6; i++)
+		CHECK(reloader.getMeshes()[i].getElementIndexBuffer() == buffers[i]);
+	CHECK(reloader.getMeshes()[7].getElementIndexBuffer() == buffers[6]);
+	CHECK(sameMeshes(reloader.getMeshes(), obj_contents("reload.obj").getMeshes()));
+
+	remove("reload.obj");
+	CHECK(!reloader.reload(replaced));
+	CHECK(!reloader.getErrors().empty());
+}
+
+int main()
+{
+	testParse();
+	testPolygons();
+	testPushMode();
+	testMissingFile();
+	testCompressedInput();
+	testWeld();
+	testGenerateNormals();
+	testBounds();
+	testBatchByMaterial();
+	testFindInstances();
+	testSelectiveLoad();
+	testCompact();
+	testAddFaces();
+	testWriterRoundTrip();
+	testGLB();
+	testStream();
+	testSpill();
+	testSnapshots();
+	testOptimizeOrder();
+	testConvexHull();
+	testTiles();
+	testTrace();
+	testVoxelize();
+	testReload();
+
+	if (failures > 0)
+	{
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
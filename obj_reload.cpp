@@ -0,0 +1,84 @@
+#include "obj_reload.h"
+
+#include <unordered_map>
+
+bool obj_reloader::load(const char* obj_file)
+{
+	this->obj_file = obj_file;
+	index = obj_group_index();
+	meshes.clear();
+
+	vector<int> replaced;
+	return reload(replaced);
+}
+
+bool obj_reloader::reload(vector<int> &replaced)
+{
+	replaced.clear();
+	error_log.clear();
+
+	obj_group_index next_index;
+	if (!next_index.build(obj_file.c_str(), true))
+	{
+		error_log = next_index.getErrors();
+		return false;
+	}
+
+	//each block takes the first unused block of the last load with the same hash, so
+	//blocks inserted, removed or moved around only cost their own parse
+	std::unordered_multimap<uint64_t, int> previous;
+	for (int i = 0; i < index.getGroupCount(); i++)
+		previous.insert(std::make_pair(index.getGroup(i).content_hash, i));
+
+	int group_total = next_index.getGroupCount();
+	vector<int> source(group_total, -1);
+
+	for (int i = 0; i < group_total; i++)
+	{
+		std::unordered_multimap<uint64_t, int>::iterator found = previous.find(next_index.getGroup(i).content_hash);
+		if (found == previous.end())
+		{
+			replaced.push_back(i);
+			continue;
+		}
+
+		source[i] = found->second;
+		previous.erase(found);
+	}
+
+	vector<mesh_data> parsed;
+	if (!replaced.empty())
+	{
+		//with nothing to keep, a plain parse skips the index's reference pass
+		bool full_parse = (int)replaced.size() == group_total;
+		std::unique_ptr<obj_contents> contents(full_parse ? new obj_contents(obj_file.c_str()) :
+			new obj_contents(obj_file.c_str(), next_index, replaced));
+
+		vector<string> parse_errors = contents->getErrors();
+		error_log.insert(error_log.end(), parse_errors.begin(), parse_errors.end());
+		parsed = contents->takeMeshes();
+
+		if (parsed.size() != replaced.size())
+		{
+			error_log.push_back("parsed meshes do not match the group index: " + obj_file);
+			replaced.clear();
+			return false;
+		}
+	}
+
+	vector<mesh_data> next_meshes(group_total);
+	for (int i = 0, p = 0; i < group_total; i++)
+	{
+		if (source[i] < 0)
+			next_meshes[i] = std::move(parsed[p++]);
+		else
+			next_meshes[i] = std::move(meshes[source[i]]);
+	}
+
+	meshes.swap(next_meshes);
+	index = next_index;
+
+	vector<string> index_errors = index.getErrors();
+	error_log.insert(error_log.end(), index_errors.begin(), index_errors.end());
+	return error_log.empty();
+}
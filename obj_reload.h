@@ -0,0 +1,38 @@
+#ifndef OBJ_RELOAD_H
+#define OBJ_RELOAD_H
+
+//keeps the meshes of one obj file current while it is saved over and over. each reload
+//indexes the file again with content hashes and parses only the blocks whose hash has
+//no match in the previous load, the meshes of every other block are moved over as they
+//are. blocks are obj_group_index's, one per mesh obj_contents produces
+
+#include "obj_parser.h"
+#include "obj_index.h"
+
+class obj_reloader
+{
+public:
+	obj_reloader(){};
+	~obj_reloader(){};
+
+	//first load, every block is parsed
+	bool load(const char* obj_file);
+	//re-reads the file given to load(). replaced receives the positions in getMeshes()
+	//of the meshes that were parsed again, in ascending order
+	bool reload(vector<int> &replaced);
+
+	const vector<mesh_data>& getMeshes() const { return meshes; }
+	const int getMeshCount() const { return meshes.size(); }
+	const obj_group_index& getIndex() const { return index; }
+	const string getMTLFilename() const { return index.getMTLFilename(); }
+	vector<string> getErrors() const { return error_log; }
+
+private:
+	string obj_file;
+	obj_group_index index;
+	//meshes[n] was parsed from block n of index
+	vector<mesh_data> meshes;
+	vector<string> error_log;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "obj_spill.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdexcept>
+
+#ifndef _WIN32
+#define OBJ_SPILL_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+mapped_file::mapped_file(const string &directory) : descriptor(-1), data(NULL), size(0), capacity(0)
+{
+#ifdef OBJ_SPILL_MMAP
+	string path = directory + "/obj_spill_XXXXXX";
+	vector<char> path_template(path.begin(), path.end());
+	path_template.push_back('\0');
+
+	descriptor = mkstemp(&path_template[0]);
+	if (descriptor < 0)
+	{
+		string error = "unable to create spill file, keeping data in memory: ";
+		error += path;
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+		return;
+	}
+
+	//the file lives only as long as the descriptor
+	unlink(&path_template[0]);
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+#ifdef OBJ_SPILL_MMAP
+	if (data != NULL && descriptor >= 0)
+		munmap(data, capacity);
+
+	if (descriptor >= 0)
+		close(descriptor);
+#endif
+}
+
+void mapped_file::reserve(size_t required)
+{
+	if (required <= capacity)
+		return;
+
+	size_t new_capacity = capacity > 0 ? capacity : (size_t)1 << 20;
+	while (new_capacity < required)
+		new_capacity *= 2;
+
+#ifdef OBJ_SPILL_MMAP
+	if (descriptor >= 0)
+	{
+		char* mapped = (char*)MAP_FAILED;
+		if (ftruncate(descriptor, new_capacity) == 0)
+			mapped = (char*)mmap(NULL, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+		if (mapped != (char*)MAP_FAILED)
+		{
+			if (data != NULL)
+				munmap(data, capacity);
+
+			data = mapped;
+			capacity = new_capacity;
+			return;
+		}
+
+		string error = "unable to grow spill file, keeping data in memory";
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+
+		fallback.assign(data, data + size);
+		if (data != NULL)
+			munmap(data, capacity);
+
+		close(descriptor);
+		descriptor = -1;
+	}
+#endif
+
+	fallback.reserve(new_capacity);
+	fallback.resize(size);
+	data = fallback.data();
+	capacity = new_capacity;
+}
+
+size_t mapped_file::append(const void* bytes, size_t byte_count)
+{
+	size_t offset = size;
+	reserve(size + byte_count);
+
+	if (descriptor < 0)
+	{
+		fallback.insert(fallback.end(), (const char*)bytes, (const char*)bytes + byte_count);
+		data = fallback.data();
+	}
+
+	else memcpy(data + size, bytes, byte_count);
+
+	size += byte_count;
+	return offset;
+}
+
+void mapped_file::release()
+{
+#ifdef OBJ_SPILL_MMAP
+	if (descriptor < 0 || data == NULL)
+		return;
+
+	//dirty shared pages go back to the page cache and are written to the file
+	msync(data, capacity, MS_ASYNC);
+	madvise(data, capacity, MADV_DONTNEED);
+#endif
+}
+
+void attribute_pool::add(const vector<float> &floats)
+{
+	//offsets holds the end of every entry, so entry n spans [end of n - 1, end of n)
+	if (!floats.empty())
+		values.append(&floats[0], floats.size() * sizeof(float));
+
+	uint64_t end = values.getSize() / sizeof(float);
+	offsets.append(&end, sizeof(end));
+	count++;
+}
+
+void attribute_pool::get(int index, vector<float> &floats) const
+{
+	if (index < 1 || index > count)
+		throw std::out_of_range("attribute_pool::get");
+
+	const uint64_t* ends = (const uint64_t*)offsets.getData();
+	uint64_t begin = index > 1 ? ends[index - 2] : 0;
+	const float* entry = (const float*)values.getData() + begin;
+	floats.assign(entry, entry + (ends[index - 1] - begin));
+}
+
+spill_storage::spill_storage(const spill_options &o) : options(o), unreleased_bytes(0),
+	v_pool(o.directory), vt_pool(o.directory), vn_pool(o.directory), vp_pool(o.directory),
+	mesh_vertices(o.directory), mesh_indices(o.directory)
+{
+}
+
+void spill_storage::addRawData(const vector<float> &floats, DATA_TYPE dt)
+{
+	switch (dt)
+	{
+	case OBJ_V: v_pool.add(floats); break;
+	case OBJ_VT: vt_pool.add(floats); break;
+	case OBJ_VN: vn_pool.add(floats); break;
+	case OBJ_VP: vp_pool.add(floats); break;
+	default: return;
+	}
+
+	unreleased_bytes += floats.size() * sizeof(float) + sizeof(uint64_t);
+	enforceBudget();
+}
+
+void spill_storage::getRawData(DATA_TYPE dt, int index, vector<float> &floats) const
+{
+	switch (dt)
+	{
+	case OBJ_V: v_pool.get(index, floats); break;
+	case OBJ_VT: vt_pool.get(index, floats); break;
+	case OBJ_VN: vn_pool.get(index, floats); break;
+	case OBJ_VP: vp_pool.get(index, floats); break;
+	default: floats.clear();
+	}
+}
+
+void spill_storage::addMesh(const mesh_data &mesh)
+{
+	spilled_mesh spilled;
+	spilled.name = mesh.getMeshlName();
+	spilled.material = mesh.getMaterialName();
+	spilled.bounds_min = mesh.getBoundsMin();
+	spilled.bounds_max = mesh.getBoundsMax();
+
+	if ((mesh.getRepresentations() & MESH_INDEXED) && mesh.getIndexedVertexCount() > 0)
+	{
+		spilled.layout = mesh.getIndexedVertexLayout();
+		spilled.vertex_total = mesh.getIndexedVertexCount();
+
+		scratch.resize((size_t)spilled.vertex_total * spilled.layout.stride);
+		mesh.copyIndexedVertexData(&scratch[0]);
+		spilled.vertex_offset = mesh_vertices.append(&scratch[0], scratch.size() * sizeof(float));
+
+		vector<unsigned short> element_index = mesh.getElementIndex();
+		spilled.index_total = element_index.size();
+		if (!element_index.empty())
+			spilled.index_offset = mesh_indices.append(&element_index[0], element_index.size() * sizeof(unsigned short));
+
+		unreleased_bytes += scratch.size() * sizeof(float) + element_index.size() * sizeof(unsigned short);
+	}
+
+	meshes.push_back(spilled);
+	enforceBudget();
+}
+
+const float* spill_storage::getVertices(int n) const
+{
+	return (const float*)(mesh_vertices.getData() + meshes.at(n).vertex_offset);
+}
+
+const unsigned short* spill_storage::getIndices(int n) const
+{
+	return (const unsigned short*)(mesh_indices.getData() + meshes.at(n).index_offset);
+}
+
+void spill_storage::enforceBudget()
+{
+	if (unreleased_bytes < options.resident_budget)
+		return;
+
+	mapped_file* files[] = { &v_pool.values, &v_pool.offsets, &vt_pool.values, &vt_pool.offsets,
+		&vn_pool.values, &vn_pool.offsets, &vp_pool.values, &vp_pool.offsets, &mesh_vertices, &mesh_indices };
+
+	for (auto file : files)
+		file->release();
+
+	unreleased_bytes = 0;
+}
+
+vector<string> spill_storage::getErrors() const
+{
+	const mapped_file* files[] = { &v_pool.values, &v_pool.offsets, &vt_pool.values, &vt_pool.offsets,
+		&vn_pool.values, &vn_pool.offsets, &vp_pool.values, &vp_pool.offsets, &mesh_vertices, &mesh_indices };
+
+	vector<string> errors;
+	for (auto file : files)
+	{
+		vector<string> file_errors = file->getErrors();
+		errors.insert(errors.end(), file_errors.begin(), file_errors.end());
+	}
+	return errors;
+}
@@ -0,0 +1,92 @@
+#ifndef OBJ_SPILL_H
+#define OBJ_SPILL_H
+
+//file-backed storage for out-of-core parsing. each buffer is an unlinked temp file
+//mapped into memory, so the kernel can write its pages back and drop them instead of
+//keeping them resident. on platforms without mmap the buffers fall back to the heap
+
+#include "obj_parser.h"
+
+#include <stdint.h>
+
+class mapped_file
+{
+public:
+	mapped_file(const string &directory);
+	~mapped_file();
+
+	//grows the file as needed, returns the offset the bytes were written at
+	size_t append(const void* bytes, size_t size);
+	const char* getData() const { return data; }
+	const size_t getSize() const { return size; }
+	//schedules written pages for writeback and drops them from the resident set,
+	//later reads fault them back in from the file
+	void release();
+
+	vector<string> getErrors() const { return error_log; }
+
+private:
+	mapped_file(const mapped_file&);
+	mapped_file& operator=(const mapped_file&);
+	void reserve(size_t capacity);
+
+	int descriptor;
+	char* data;
+	size_t size;
+	size_t capacity;
+	vector<char> fallback;
+	vector<string> error_log;
+};
+
+//raw attributes under their 1-based obj index, each entry keeps its own float count
+class attribute_pool
+{
+public:
+	attribute_pool(const string &directory) : values(directory), offsets(directory), count(0) {};
+
+	void add(const vector<float> &floats);
+	//throws std::out_of_range for an index that was never added, as map::at does
+	void get(int index, vector<float> &floats) const;
+	const int getCount() const { return count; }
+
+	mapped_file values;
+	mapped_file offsets;
+
+private:
+	int count;
+};
+
+class spill_storage
+{
+public:
+	spill_storage(const spill_options &o);
+
+	void addRawData(const vector<float> &floats, DATA_TYPE dt);
+	void getRawData(DATA_TYPE dt, int index, vector<float> &floats) const;
+	//writes the mesh's indexed vertices and indices out, the mesh can be dropped after
+	void addMesh(const mesh_data &mesh);
+
+	const int getMeshCount() const { return meshes.size(); }
+	const spilled_mesh getMesh(int n) const { return meshes.at(n); }
+	const float* getVertices(int n) const;
+	const unsigned short* getIndices(int n) const;
+
+	vector<string> getErrors() const;
+
+private:
+	//releases every buffer once the bytes written since the last release reach the budget
+	void enforceBudget();
+
+	spill_options options;
+	size_t unreleased_bytes;
+	attribute_pool v_pool;
+	attribute_pool vt_pool;
+	attribute_pool vn_pool;
+	attribute_pool vp_pool;
+	mapped_file mesh_vertices;
+	mapped_file mesh_indices;
+	vector<spilled_mesh> meshes;
+	vector<float> scratch;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "obj_stream.h"
+
+#include <iostream>
+
+mesh_stream::mesh_stream(const char* obj_file) : source(NULL), buffer(1 << 16), finished(false)
+{
+	string error;
+	owned_source = openInputSource(obj_file, error);
+
+	if (!owned_source)
+	{
+		std::cout << error << std::endl;
+		error_log.push_back(error);
+		finished = true;
+		return;
+	}
+
+	source = owned_source.get();
+}
+
+mesh_stream::mesh_stream(input_source &s) : source(&s), buffer(1 << 16), finished(false)
+{
+}
+
+bool mesh_stream::next(mesh_data &mesh)
+{
+	if (ready.empty())
+		readUntilMesh();
+
+	if (ready.empty())
+		return false;
+
+	mesh = std::move(ready.front());
+	ready.pop_front();
+	return true;
+}
+
+void mesh_stream::readUntilMesh()
+{
+	while (ready.empty() && !finished)
+	{
+		size_t bytes_read = source->read(&buffer[0], buffer.size());
+
+		if (bytes_read == 0)
+		{
+			contents.finish();
+			finished = true;
+
+			vector<string> source_errors = source->getErrors();
+			for (auto error : source_errors)
+			{
+				std::cout << error << std::endl;
+				error_log.push_back(error);
+			}
+		}
+
+		else contents.feed(&buffer[0], bytes_read);
+
+		vector<mesh_data> completed = contents.takeCompletedMeshes();
+		for (auto &completed_mesh : completed)
+			ready.push_back(std::move(completed_mesh));
+	}
+}
+
+vector<string> mesh_stream::getErrors() const
+{
+	vector<string> errors = error_log;
+	vector<string> parse_errors = contents.getErrors();
+	errors.insert(errors.end(), parse_errors.begin(), parse_errors.end());
+	return errors;
+}
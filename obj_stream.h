@@ -0,0 +1,135 @@
+#ifndef OBJ_STREAM_H
+#define OBJ_STREAM_H
+
+//pull-style mesh delivery: each mesh is handed out as soon as the group following it
+//starts, so a caller can upload mesh n while mesh n+1 is still being parsed. only the
+//meshes completed by the last read chunk are held, the raw v/vt/vn lists still grow
+//with the file since any later face may reference them.
+//
+//	mesh_stream stream("model.obj");
+//	mesh_data mesh;
+//	while (stream.next(mesh))
+//		upload(mesh);
+//
+//with c++20 coroutines, streamMeshes wraps the same loop in a generator:
+//
+//	for (mesh_data &mesh : streamMeshes("model.obj"))
+//		upload(mesh);
+
+#include "obj_parser.h"
+#include "obj_input.h"
+
+#include <deque>
+#include <memory>
+
+class mesh_stream
+{
+public:
+	//gzip and zstd compressed files are detected and decompressed while parsing
+	mesh_stream(const char* obj_file);
+	//the source must outlive the stream
+	mesh_stream(input_source &source);
+	~mesh_stream(){};
+
+	//moves the next completed mesh into mesh, returns false once the file is exhausted
+	bool next(mesh_data &mesh);
+
+	//filled in as "mtllib" is reached, complete once next() has returned false
+	const string getMTLFilename() const { return contents.getMTLFilename(); }
+	vector<string> getErrors() const;
+	const load_stats getLoadStats() const { return contents.getLoadStats(); }
+
+private:
+	//reads chunks until at least one mesh completes or the input ends
+	void readUntilMesh();
+
+	std::unique_ptr<input_source> owned_source;
+	input_source* source;
+	obj_contents contents;
+	std::deque<mesh_data> ready;
+	vector<char> buffer;
+	bool finished;
+	vector<string> error_log;
+};
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define OBJ_PARSER_HAS_COROUTINES
+#include <coroutine>
+#include <exception>
+#endif
+#endif
+
+#ifdef OBJ_PARSER_HAS_COROUTINES
+//single-pass generator of meshes, iterating resumes the coroutine until the next yield
+class mesh_generator
+{
+public:
+	struct promise_type
+	{
+		mesh_data* current = nullptr;
+		std::exception_ptr exception;
+
+		mesh_generator get_return_object() { return mesh_generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		//the yielded mesh lives in the coroutine frame until the consumer resumes it
+		std::suspend_always yield_value(mesh_data &mesh) noexcept { current = &mesh; return {}; }
+		void return_void() {}
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+
+	class iterator
+	{
+	public:
+		iterator() : handle(nullptr) {};
+		explicit iterator(std::coroutine_handle<promise_type> h) : handle(h) {};
+
+		mesh_data& operator*() const { return *handle.promise().current; }
+		mesh_data* operator->() const { return handle.promise().current; }
+		iterator& operator++() { advance(); return *this; }
+		void operator++(int) { advance(); }
+		bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+		bool operator!=(std::default_sentinel_t s) const { return !(*this == s); }
+
+		void advance()
+		{
+			handle.resume();
+			if (handle.done() && handle.promise().exception)
+				std::rethrow_exception(handle.promise().exception);
+		}
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	mesh_generator(mesh_generator &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+	mesh_generator(const mesh_generator&) = delete;
+	mesh_generator& operator=(const mesh_generator&) = delete;
+	~mesh_generator() { if (handle) handle.destroy(); }
+
+	iterator begin()
+	{
+		iterator first(handle);
+		if (handle)
+			first.advance();
+		return first;
+	}
+	std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+	explicit mesh_generator(std::coroutine_handle<promise_type> h) : handle(h) {};
+	std::coroutine_handle<promise_type> handle;
+};
+
+//errors are printed as the parser finds them, use mesh_stream directly to collect them
+inline mesh_generator streamMeshes(const char* obj_file)
+{
+	mesh_stream stream(obj_file);
+	mesh_data mesh;
+	while (stream.next(mesh))
+		co_yield mesh;
+}
+#endif
+
+#endif
@@ -0,0 +1,196 @@
+#include "obj_trace.h"
+#include "obj_json.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdio.h>
+
+using std::vector;
+
+struct trace_event
+{
+	const char* name;
+	string file;
+	long long offset;
+	//microseconds since startTrace()
+	double start;
+	double duration;
+};
+
+//events of one thread. only its own thread appends, the lock is taken uncontended
+//except while startTrace() or writeTrace() walk every buffer
+struct trace_buffer
+{
+	int thread;
+	std::mutex lock;
+	vector<trace_event> events;
+};
+
+struct trace_state
+{
+	trace_state() : enabled(false), min_duration(0.0), thread_total(0) {};
+
+	std::atomic<bool> enabled;
+	std::mutex lock;
+	std::chrono::steady_clock::time_point origin;
+	double min_duration;
+	int thread_total;
+	//buffers outlive their threads so events of finished workers are still written
+	vector< std::shared_ptr<trace_buffer> > buffers;
+};
+
+static trace_state& traceState()
+{
+	static trace_state state;
+	return state;
+}
+
+static trace_buffer& threadBuffer()
+{
+	thread_local std::shared_ptr<trace_buffer> buffer;
+
+	if (!buffer)
+	{
+		trace_state &state = traceState();
+		std::lock_guard<std::mutex> guard(state.lock);
+
+		buffer = std::make_shared<trace_buffer>();
+		buffer->thread = ++state.thread_total;
+		state.buffers.push_back(buffer);
+	}
+
+	return *buffer;
+}
+
+void startTrace(double min_microseconds)
+{
+	trace_state &state = traceState();
+	std::lock_guard<std::mutex> guard(state.lock);
+
+	for (auto &buffer : state.buffers)
+	{
+		std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+		buffer->events.clear();
+	}
+
+	state.origin = std::chrono::steady_clock::now();
+	state.min_duration = min_microseconds;
+	state.enabled = true;
+}
+
+void stopTrace()
+{
+	traceState().enabled = false;
+}
+
+const bool isTracing()
+{
+	return traceState().enabled.load(std::memory_order_relaxed);
+}
+
+bool writeTrace(const char* json_file, string &error)
+{
+	trace_state &state = traceState();
+	string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	char number[64];
+
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+
+		for (auto &buffer : state.buffers)
+		{
+			std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+			if (buffer->events.empty())
+				continue;
+
+			//names the thread's row in the viewer
+			snprintf(number, sizeof(number), "%d", buffer->thread);
+			json += first ? "\n" : ",\n";
+			json += string("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":") + number +
+				",\"args\":{\"name\":\"obj_parser thread " + number + "\"}}";
+			first = false;
+
+			for (const auto &event : buffer->events)
+			{
+				json += ",\n{\"name\":";
+				appendJSONString(json, event.name);
+				snprintf(number, sizeof(number), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d", buffer->thread);
+				json += number;
+				snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f", event.start, event.duration);
+				json += number;
+
+				json += ",\"args\":{";
+				if (!event.file.empty())
+				{
+					json += "\"file\":";
+					appendJSONString(json, event.file);
+				}
+
+				if (event.offset >= 0)
+				{
+					snprintf(number, sizeof(number), "%s\"offset\":%lld", event.file.empty() ? "" : ",", event.offset);
+					json += number;
+				}
+				json += "}}";
+			}
+		}
+	}
+
+	json += "\n]}\n";
+
+	FILE* file = fopen(json_file, "wb");
+	if (file == NULL)
+	{
+		error = "unable to open trace file for writing: ";
+		error += json_file;
+		return false;
+	}
+
+	bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+	written = fclose(file) == 0 && written;
+
+	if (!written)
+	{
+		error = "error writing trace file: ";
+		error += json_file;
+		return false;
+	}
+
+	return true;
+}
+
+trace_zone::trace_zone(const char* zone_name, const char* file_name, long long byte_offset)
+	: name(zone_name), file(file_name), offset(byte_offset), active(isTracing())
+{
+	if (active)
+		start = std::chrono::steady_clock::now();
+}
+
+trace_zone::~trace_zone()
+{
+	if (!active)
+		return;
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	trace_state &state = traceState();
+
+	//the origin and threshold are only changed by startTrace(), read without the lock
+	trace_event event;
+	event.name = name;
+	event.offset = offset;
+	event.start = std::chrono::duration<double, std::micro>(start - state.origin).count();
+	event.duration = std::chrono::duration<double, std::micro>(end - start).count();
+
+	if (event.duration < state.min_duration)
+		return;
+
+	if (file != NULL)
+		event.file = file;
+
+	trace_buffer &buffer = threadBuffer();
+	std::lock_guard<std::mutex> guard(buffer.lock);
+	buffer.events.push_back(event);
+}
@@ -0,0 +1,48 @@
+#ifndef OBJ_TRACE_H
+#define OBJ_TRACE_H
+
+//scoped timing zones written as chrome trace-event json, which chrome://tracing and
+//ui.perfetto.dev show as one timeline row per thread. zones only exist when built with
+//OBJ_PARSER_TRACE, otherwise the macros expand to nothing. when built in, a zone costs
+//one flag check until startTrace() is called
+
+#include <string>
+#include <chrono>
+
+using std::string;
+
+#ifdef OBJ_PARSER_TRACE
+#define OBJ_TRACE_ZONE(name) trace_zone obj_trace_zone(name)
+#define OBJ_TRACE_ZONE_ARGS(name, file, offset) trace_zone obj_trace_zone(name, file, offset)
+#define OBJ_TRACE(statement) statement
+#else
+#define OBJ_TRACE_ZONE(name)
+#define OBJ_TRACE_ZONE_ARGS(name, file, offset)
+#define OBJ_TRACE(statement)
+#endif
+
+//clears any earlier events and starts recording, call it while no load is running. zones shorter than min_microseconds are
+//dropped when they close, per-face zones of a large file would otherwise fill the trace
+void startTrace(double min_microseconds = 0.0);
+void stopTrace();
+const bool isTracing();
+//writes every event recorded since startTrace(), from all threads, tracing may still be on
+bool writeTrace(const char* json_file, string &error);
+
+class trace_zone
+{
+public:
+	//name must outlive the trace, a string literal. file must outlive the zone, it and
+	//offset are written to the event's args when given
+	trace_zone(const char* zone_name, const char* file_name = NULL, long long byte_offset = -1);
+	~trace_zone();
+
+private:
+	const char* name;
+	const char* file;
+	long long offset;
+	bool active;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include "obj_writer.h"
+#include "obj_parallel.h"
+
+#include <stdio.h>
+#include <thread>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars)
+#define OBJ_WRITER_TO_CHARS
+#endif
+
+enum WRITE_TASK { WRITE_POSITIONS, WRITE_UVS, WRITE_NORMALS, WRITE_HEADER, WRITE_FACES };
+
+//one mesh flattened into separate attribute arrays, whichever form it was stored in
+struct mesh_plan
+{
+	vector<float> positions;
+	vector<float> uvs;
+	vector<float> normals;
+	vector<unsigned int> corners;
+	int v_size;
+	int vt_size;
+	int vn_size;
+	int vertex_total;
+
+	//1-based index of the mesh's first v, vt and vn line in the file
+	int v_base;
+	int vt_base;
+	int vn_base;
+	string header;
+};
+
+struct write_task
+{
+	int mesh;
+	WRITE_TASK type;
+	int begin;
+	int end;
+};
+
+void appendFloat(string &out, float f)
+{
+	char buffer[32];
+#ifdef OBJ_WRITER_TO_CHARS
+	std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), f);
+	out.append(buffer, result.ptr);
+#else
+	int length = snprintf(buffer, sizeof(buffer), "%.9g", f);
+	out.append(buffer, length);
+#endif
+}
+
+static void appendUnsigned(string &out, unsigned int n)
+{
+	char buffer[16];
+	char* cursor = buffer + sizeof(buffer);
+	do
+	{
+		*--cursor = char('0' + n % 10);
+		n /= 10;
+	} while (n != 0);
+
+	out.append(cursor, buffer + sizeof(buffer));
+}
+
+static void appendAttributeLines(string &out, const char* prefix, const vector<float> &data, int size, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		out += prefix;
+		for (int n = 0; n < size; n++)
+		{
+			out += ' ';
+			appendFloat(out, data[(size_t)i * size + n]);
+		}
+		out += '\n';
+	}
+}
+
+static void appendFaceLines(string &out, const mesh_plan &plan, int begin, int end)
+{
+	for (int t = begin; t < end; t++)
+	{
+		out += 'f';
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int vertex = plan.corners[t * 3 + k];
+			out += ' ';
+			appendUnsigned(out, plan.v_base + vertex);
+
+			if (plan.vt_size > 0 || plan.vn_size > 0)
+			{
+				out += '/';
+				if (plan.vt_size > 0)
+					appendUnsigned(out, plan.vt_base + vertex);
+			}
+
+			if (plan.vn_size > 0)
+			{
+				out += '/';
+				appendUnsigned(out, plan.vn_base + vertex);
+			}
+		}
+		out += '\n';
+	}
+}
+
+static bool planMesh(const mesh_data &mesh, const obj_write_options &options, mesh_plan &plan)
+{
+	plan.v_size = 0;
+	plan.vt_size = 0;
+	plan.vn_size = 0;
+	plan.vertex_total = 0;
+
+	if (mesh.getRepresentations() & MESH_INDEXED)
+	{
+		vertex_layout layout = mesh.getIndexedVertexLayout();
+		vector<float> vertices = mesh.getIndexedVertexData();
+		vector<unsigned short> element_index = mesh.getElementIndex();
+
+		if (layout.stride == 0 || element_index.empty())
+			return false;
+
+		plan.vertex_total = vertices.size() / layout.stride;
+		plan.v_size = layout.v_size;
+		plan.vt_size = options.write_uvs ? layout.vt_size : 0;
+		plan.vn_size = options.write_normals ? layout.vn_size : 0;
+
+		plan.positions.reserve((size_t)plan.vertex_total * plan.v_size);
+		plan.uvs.reserve((size_t)plan.vertex_total * plan.vt_size);
+		plan.normals.reserve((size_t)plan.vertex_total * plan.vn_size);
+
+		for (int i = 0; i < plan.vertex_total; i++)
+		{
+			vector<float>::const_iterator vertex = vertices.begin() + (size_t)i * layout.stride;
+			plan.positions.insert(plan.positions.end(), vertex + layout.v_offset, vertex + layout.v_offset + plan.v_size);
+			plan.uvs.insert(plan.uvs.end(), vertex + layout.vt_offset, vertex + layout.vt_offset + plan.vt_size);
+			plan.normals.insert(plan.normals.end(), vertex + layout.vn_offset, vertex + layout.vn_offset + plan.vn_size);
+		}
+
+		plan.corners.assign(element_index.begin(), element_index.end());
+	}
+
+	//every corner becomes its own vertex
+	else if (mesh.getRepresentations() & MESH_ATTRIBUTE_LISTS)
+	{
+		plan.v_size = mesh.getVSize();
+		if (plan.v_size <= 0)
+			return false;
+
+		plan.positions = mesh.getVData();
+		plan.vertex_total = plan.positions.size() / plan.v_size;
+
+		if (options.write_uvs && mesh.getVTSize() > 0)
+		{
+			plan.vt_size = mesh.getVTSize();
+			plan.uvs = mesh.getVTData();
+		}
+
+		if (options.write_normals && mesh.getVNSize() > 0)
+		{
+			plan.vn_size = mesh.getVNSize();
+			plan.normals = mesh.getVNData();
+		}
+
+		plan.corners.resize(plan.vertex_total);
+		for (int i = 0; i < plan.vertex_total; i++)
+			plan.corners[i] = i;
+	}
+
+	return plan.vertex_total > 0 && plan.corners.size() >= 3;
+}
+
+static void formatTask(const write_task &task, const vector<mesh_plan> &plans, string &out)
+{
+	const mesh_plan &plan = plans[task.mesh];
+
+	//roughly 12 characters per float keeps reallocation out of the loop
+	switch (task.type)
+	{
+	case WRITE_POSITIONS:
+		out.reserve((task.end - task.begin) * (4 + plan.v_size * 12));
+		appendAttributeLines(out, "v", plan.positions, plan.v_size, task.begin, task.end);
+		break;
+	case WRITE_UVS:
+		out.reserve((task.end - task.begin) * (4 + plan.vt_size * 12));
+		appendAttributeLines(out, "vt", plan.uvs, plan.vt_size, task.begin, task.end);
+		break;
+	case WRITE_NORMALS:
+		out.reserve((task.end - task.begin) * (4 + plan.vn_size * 12));
+		appendAttributeLines(out, "vn", plan.normals, plan.vn_size, task.begin, task.end);
+		break;
+	case WRITE_HEADER:
+		out = plan.header;
+		break;
+	case WRITE_FACES:
+		out.reserve((task.end - task.begin) * 48);
+		appendFaceLines(out, plan, task.begin, task.end);
+		break;
+	}
+}
+
+bool writeOBJ(const char* obj_file, const vector<mesh_data> &meshes, const string &mtl_filename,
+	string &error, const obj_write_options &options)
+{
+	vector<mesh_plan> plans(meshes.size());
+	//char, not bool, since workers set neighbouring entries at the same time
+	vector<char> writable(meshes.size());
+
+	parallelFor(meshes.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			writable[i] = planMesh(meshes[i], options, plans[i]);
+	}, 1);
+
+	//global attribute numbers are a running sum over the meshes actually written
+	vector<write_task> tasks;
+	int block_lines = options.block_lines > 0 ? options.block_lines : 1;
+	int v_total = 0;
+	int vt_total = 0;
+	int vn_total = 0;
+	string current_material;
+
+	for (int i = 0; i < (int)meshes.size(); i++)
+	{
+		//an empty block would hand its g line to the previous mesh when read back
+		if (!writable[i])
+			continue;
+
+		mesh_plan &plan = plans[i];
+		plan.v_base = v_total + 1;
+		plan.vt_base = vt_total + 1;
+		plan.vn_base = vn_total + 1;
+		v_total += plan.vertex_total;
+		vt_total += plan.vt_size > 0 ? plan.vertex_total : 0;
+		vn_total += plan.vn_size > 0 ? plan.vertex_total : 0;
+
+		plan.header = "g";
+		if (!meshes[i].getMeshlName().empty())
+			plan.header += " " + meshes[i].getMeshlName();
+		plan.header += "\n";
+
+		//the parser carries a material into the next mesh, so only changes are written
+		if (meshes[i].getMaterialName() != current_material)
+		{
+			current_material = meshes[i].getMaterialName();
+			plan.header += "usemtl";
+			if (!current_material.empty())
+				plan.header += " " + current_material;
+			plan.header += "\n";
+		}
+
+		WRITE_TASK attribute_types[3] = { WRITE_POSITIONS, WRITE_UVS, WRITE_NORMALS };
+		bool attribute_written[3] = { true, plan.vt_size > 0, plan.vn_size > 0 };
+		for (int a = 0; a < 3; a++)
+		{
+			if (!attribute_written[a])
+				continue;
+
+			for (int begin = 0; begin < plan.vertex_total; begin += block_lines)
+			{
+				write_task task = { i, attribute_types[a], begin, std::min(plan.vertex_total, begin + block_lines) };
+				tasks.push_back(task);
+			}
+		}
+
+		write_task header_task = { i, WRITE_HEADER, 0, 0 };
+		tasks.push_back(header_task);
+
+		int triangle_total = plan.corners.size() / 3;
+		for (int begin = 0; begin < triangle_total; begin += block_lines)
+		{
+			write_task task = { i, WRITE_FACES, begin, std::min(triangle_total, begin + block_lines) };
+			tasks.push_back(task);
+		}
+	}
+
+	FILE* file = fopen(obj_file, "wb");
+	if (file == NULL)
+	{
+		error = "unable to open obj file for writing: ";
+		error += obj_file;
+		return false;
+	}
+
+	if (!mtl_filename.empty())
+	{
+		string mtllib = "mtllib " + mtl_filename + "\n";
+		fwrite(mtllib.data(), 1, mtllib.size(), file);
+	}
+
+	//tasks are formatted a wave at a time, bounding memory to a few blocks per thread,
+	//and each block goes out in a single write
+	int thread_total = std::max(1, (int)std::thread::hardware_concurrency());
+	int wave_size = thread_total * 4;
+	bool write_failed = false;
+
+	for (int wave_begin = 0; wave_begin < (int)tasks.size() && !write_failed; wave_begin += wave_size)
+	{
+		int wave_end = std::min((int)tasks.size(), wave_begin + wave_size);
+		vector<string> blocks(wave_end - wave_begin);
+
+		parallelFor(wave_end - wave_begin, [&](int begin, int end) {
+			for (int t = begin; t < end; t++)
+				formatTask(tasks[wave_begin + t], plans, blocks[t]);
+		}, 1);
+
+		for (const auto &block : blocks)
+		{
+			if (fwrite(block.data(), 1, block.size(), file) != block.size())
+			{
+				write_failed = true;
+				break;
+			}
+		}
+	}
+
+	if (fclose(file) != 0 || write_failed)
+	{
+		error = "error writing obj file: ";
+		error += obj_file;
+		return false;
+	}
+
+	return true;
+}
+
+bool writeOBJ(const char* obj_file, const obj_contents &contents, string &error, const obj_write_options &options)
+{
+	return writeOBJ(obj_file, contents.getMeshes(), contents.getMTLFilename(), error, options);
+}
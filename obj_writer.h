@@ -0,0 +1,32 @@
+#ifndef OBJ_WRITER_H
+#define OBJ_WRITER_H
+
+#include "obj_parser.h"
+
+//floats are written in their shortest round-trip form with std::to_chars when built
+//as c++17 with a library that supports it, otherwise with 9 significant digits, which
+//also reads back bit-exact. every mesh is written as its own block, in the layout the
+//parser splits on:
+//	v, vt, vn lines, g <mesh name>, usemtl <material>, f v/vt/vn lines
+//meshes are written from their indexed vertices (MESH_INDEXED), or corner by corner
+//from the attribute lists once compact() has released the index
+struct obj_write_options
+{
+	obj_write_options() : write_uvs(true), write_normals(true), block_lines(1 << 16) {};
+
+	bool write_uvs;
+	bool write_normals;
+	//lines formatted per task, tasks run in parallel and are written in order
+	int block_lines;
+};
+
+//returns false and sets error if the file cannot be written
+bool writeOBJ(const char* obj_file, const vector<mesh_data> &meshes, const string &mtl_filename,
+	string &error, const obj_write_options &options = obj_write_options());
+bool writeOBJ(const char* obj_file, const obj_contents &contents,
+	string &error, const obj_write_options &options = obj_write_options());
+
+//appends the shortest text that reads back as exactly f
+void appendFloat(string &out, float f);
+
+#endif
@@ -0,0 +1,220 @@
+#include "vertex_dedup.h"
+#include "obj_parallel.h"
+#include "obj_trace.h"
+
+#include <string.h>
+#include <thread>
+#include <algorithm>
+
+//slot states, data is written between claiming a slot and publishing it
+static const int SLOT_EMPTY = 0;
+static const int SLOT_BUSY = 1;
+static const int SLOT_READY = 2;
+
+static uint32_t floatBits(float f)
+{
+	//-0 compares equal to 0, so it has to hash the same
+	if (f == 0.0f)
+		return 0;
+
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+concurrent_vertex_dedup::concurrent_vertex_dedup(int s, int capacity, int shard_total) :
+	stride(s), spill_count(0)
+{
+	int shard_count = 1;
+	while (shard_count < shard_total)
+		shard_count <<= 1;
+
+	//half full tables keep probes short, and hash imbalance between shards has room
+	int per_shard = (capacity + shard_count - 1) / shard_count;
+	int slot_count = 16;
+	while (slot_count < per_shard * 2)
+		slot_count <<= 1;
+
+	shard_mask = shard_count - 1;
+	slot_mask = slot_count - 1;
+	shard_capacity = slot_count;
+
+	for (int i = 0; i < shard_count; i++)
+	{
+		std::unique_ptr<shard> table(new shard);
+		table->slots.reset(new std::atomic<int>[slot_count]);
+		table->first_sequence.reset(new std::atomic<uint64_t>[slot_count]);
+		table->hashes.resize(slot_count);
+		table->vertices.resize((size_t)slot_count * stride);
+
+		for (int n = 0; n < slot_count; n++)
+			table->slots[n].store(SLOT_EMPTY, std::memory_order_relaxed);
+
+		shards.push_back(std::move(table));
+	}
+}
+
+size_t concurrent_vertex_dedup::spill_key_hash::operator()(const vector<float> &key) const
+{
+	uint64_t h = 1469598103934665603ull;
+	for (auto f : key)
+		h = (h ^ floatBits(f)) * 1099511628211ull;
+
+	return (size_t)h;
+}
+
+void concurrent_vertex_dedup::keepMinimum(std::atomic<uint64_t> &target, uint64_t sequence)
+{
+	uint64_t current = target.load(std::memory_order_relaxed);
+	while (sequence < current && !target.compare_exchange_weak(current, sequence, std::memory_order_relaxed))
+		;
+}
+
+const uint64_t concurrent_vertex_dedup::hashVertex(const float* vertex) const
+{
+	uint64_t h = 0x9e3779b97f4a7c15ull;
+	for (int i = 0; i < stride; i++)
+	{
+		h ^= floatBits(vertex[i]);
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 32;
+	}
+
+	return h;
+}
+
+const bool concurrent_vertex_dedup::sameVertex(const float* a, const float* b) const
+{
+	for (int i = 0; i < stride; i++)
+	{
+		if (a[i] != b[i])
+			return false;
+	}
+
+	return true;
+}
+
+const uint32_t concurrent_vertex_dedup::insert(const float* vertex, uint64_t sequence)
+{
+	uint64_t h = hashVertex(vertex);
+	int shard_index = h & shard_mask;
+	shard &table = *shards[shard_index];
+	int slot = (h >> 32) & slot_mask;
+
+	//linear probing, the first empty slot on the path is the only place this vertex can be added
+	for (int probe = 0; probe <= slot_mask; probe++, slot = (slot + 1) & slot_mask)
+	{
+		int state = table.slots[slot].load(std::memory_order_acquire);
+
+		if (state == SLOT_EMPTY)
+		{
+			if (table.slots[slot].compare_exchange_strong(state, SLOT_BUSY, std::memory_order_acq_rel))
+			{
+				std::copy(vertex, vertex + stride, &table.vertices[(size_t)slot * stride]);
+				table.hashes[slot] = h;
+				table.first_sequence[slot].store(sequence, std::memory_order_relaxed);
+				table.slots[slot].store(SLOT_READY, std::memory_order_release);
+				return shard_index * shard_capacity + slot;
+			}
+		}
+
+		//the claiming thread is only copying stride floats
+		while (state == SLOT_BUSY)
+		{
+			std::this_thread::yield();
+			state = table.slots[slot].load(std::memory_order_acquire);
+		}
+
+		if (table.hashes[slot] == h && sameVertex(vertex, &table.vertices[(size_t)slot * stride]))
+		{
+			keepMinimum(table.first_sequence[slot], sequence);
+			return shard_index * shard_capacity + slot;
+		}
+	}
+
+	//a full table never gains this vertex later, so the spill map is the only copy
+	return spill(vertex, sequence);
+}
+
+const uint32_t concurrent_vertex_dedup::spill(const float* vertex, uint64_t sequence)
+{
+	std::lock_guard<std::mutex> guard(spill_lock);
+
+	vector<float> key(vertex, vertex + stride);
+	std::unordered_map< vector<float>, uint32_t, spill_key_hash >::iterator found = spill_handles.find(key);
+	if (found != spill_handles.end())
+	{
+		uint32_t spill_index = found->second - shards.size() * shard_capacity;
+		spill_sequence[spill_index] = std::min(spill_sequence[spill_index], sequence);
+		return found->second;
+	}
+
+	uint32_t handle = shards.size() * shard_capacity + spill_count;
+	spill_handles[key] = handle;
+	spill_vertices.insert(spill_vertices.end(), vertex, vertex + stride);
+	spill_sequence.push_back(sequence);
+	spill_count++;
+
+	return handle;
+}
+
+const int concurrent_vertex_dedup::finish(vector<float> &vertices)
+{
+	//(first sequence, handle) of every distinct vertex, sorted into serial order
+	vector< std::pair<uint64_t, uint32_t> > order;
+
+	for (int i = 0; i < (int)shards.size(); i++)
+	{
+		shard &table = *shards[i];
+		for (int slot = 0; slot <= slot_mask; slot++)
+		{
+			if (table.slots[slot].load(std::memory_order_acquire) == SLOT_READY)
+				order.push_back(std::make_pair(table.first_sequence[slot].load(std::memory_order_relaxed), i * shard_capacity + slot));
+		}
+	}
+
+	for (int i = 0; i < spill_count; i++)
+		order.push_back(std::make_pair(spill_sequence[i], shards.size() * shard_capacity + i));
+
+	std::sort(order.begin(), order.end());
+
+	final_index.assign(shards.size() * shard_capacity + spill_count, -1);
+	vertices.resize(order.size() * stride);
+
+	for (int i = 0; i < (int)order.size(); i++)
+	{
+		uint32_t handle = order[i].second;
+		final_index[handle] = i;
+
+		const float* source;
+		if (handle >= shards.size() * shard_capacity)
+			source = &spill_vertices[(size_t)(handle - shards.size() * shard_capacity) * stride];
+
+		else source = &shards[handle / shard_capacity]->vertices[(size_t)(handle % shard_capacity) * stride];
+
+		std::copy(source, source + stride, &vertices[(size_t)i * stride]);
+	}
+
+	return order.size();
+}
+
+const int dedupVertices(const float* corners, int corner_total, int stride,
+	vector<float> &unique_vertices, vector<unsigned int> &indices)
+{
+	concurrent_vertex_dedup dedup(stride, corner_total);
+	vector<uint32_t> handles(corner_total);
+
+	parallelFor(corner_total, [&](int begin, int end) {
+		OBJ_TRACE_ZONE("dedup range");
+		for (int c = begin; c < end; c++)
+			handles[c] = dedup.insert(corners + (size_t)c * stride, c);
+	});
+
+	int unique_total = dedup.finish(unique_vertices);
+
+	indices.resize(corner_total);
+	for (int c = 0; c < corner_total; c++)
+		indices[c] = dedup.getIndex(handles[c]);
+
+	return unique_total;
+}
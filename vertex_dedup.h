@@ -0,0 +1,86 @@
+#ifndef VERTEX_DEDUP_H
+#define VERTEX_DEDUP_H
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+using std::vector;
+
+//vertex deduplication that any number of threads can feed at once. vertices are
+//split into shards by hash, each shard an open addressing table whose slots are
+//claimed with compare-and-swap, so producers never take a lock on the common path.
+//a shard that runs out of room spills into a mutex guarded map instead of failing.
+//
+//each insert carries a sequence number, normally the corner's position in the mesh.
+//every vertex remembers the smallest sequence it was seen with, and finish() numbers
+//vertices in that order. the final indices therefore match a serial first-occurrence
+//pass over the corners, whatever the thread count or interleaving.
+//
+//vertices match when their floats are bitwise equal (with -0 equal to 0), unlike
+//vertex_data::operator == which also merges values within 1e-6 of each other
+class concurrent_vertex_dedup
+{
+public:
+	//capacity is the expected number of distinct vertices, stride the floats per vertex
+	concurrent_vertex_dedup(int stride, int capacity, int shard_total = 64);
+	~concurrent_vertex_dedup(){};
+
+	//thread safe, returns a handle for the vertex that is only meaningful to getIndex
+	const uint32_t insert(const float* vertex, uint64_t sequence);
+
+	//single threaded, once every producer has returned. writes the distinct vertices
+	//to vertices in final order and returns how many there are
+	const int finish(vector<float> &vertices);
+	//final index of a handle returned by insert, valid after finish()
+	const int getIndex(uint32_t handle) const { return final_index[handle]; }
+
+	const int getStride() const { return stride; }
+	const int getSpillCount() const { return spill_count; }
+
+private:
+	struct shard
+	{
+		//storage index held by each table slot, -1 while empty
+		std::unique_ptr< std::atomic<int>[] > slots;
+		std::unique_ptr< std::atomic<uint64_t>[] > first_sequence;
+		vector<uint64_t> hashes;
+		vector<float> vertices;
+	};
+
+	struct spill_key_hash
+	{
+		size_t operator()(const vector<float> &key) const;
+	};
+
+	static void keepMinimum(std::atomic<uint64_t> &target, uint64_t sequence);
+	const uint64_t hashVertex(const float* vertex) const;
+	const bool sameVertex(const float* a, const float* b) const;
+	const uint32_t spill(const float* vertex, uint64_t sequence);
+
+	int stride;
+	int shard_mask;
+	int slot_mask;
+	int shard_capacity;
+	vector< std::unique_ptr<shard> > shards;
+
+	//rare overflow path, handles above shard_total * shard_capacity
+	std::mutex spill_lock;
+	std::unordered_map< vector<float>, uint32_t, spill_key_hash > spill_handles;
+	vector<float> spill_vertices;
+	vector<uint64_t> spill_sequence;
+	int spill_count;
+
+	vector<int> final_index;
+};
+
+//deduplicates corner_total vertices of stride floats with parallelFor. indices[i] is the
+//index corner i gets from a serial first-occurrence pass, unique_vertices holds the
+//distinct vertices in that order. returns the number of distinct vertices
+const int dedupVertices(const float* corners, int corner_total, int stride,
+	vector<float> &unique_vertices, vector<unsigned int> &indices);
+
+#endif